@@ -0,0 +1,225 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Bump allocator over a list of large chunks. Allocations are never freed
+// one by one: a monotonic arena keeps everything until release(), and a
+// scratch arena is rewound to a mark (or reset) once a query is done,
+// keeping its chunks for the next one. Not thread-safe; scratchArena()
+// gives every thread its own. Containers keep a pointer to their arena,
+// so it must not move while they live. New chunks start at chunkBytes
+// and double up to maxChunkBytes (by default they stay the same size),
+// so an arena that may stay small need not reserve a large chunk.
+class Arena {
+public:
+    explicit Arena(size_t chunkBytes = 64 << 10, size_t maxChunkBytes = 0)
+        : chunkSize(chunkBytes), maxChunkSize(std::max(chunkBytes, maxChunkBytes)), current(0), used(0),
+          reserved(0) {}
+    ~Arena() { release(); }
+
+    // Uninitialized, aligned memory valid until the arena is rewound past it
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        while (true) {
+            if (current < chunks.size()) {
+                size_t start = (used + align - 1) & ~(align - 1);
+                if (start + bytes <= chunks[current].size) {
+                    used = start + bytes;
+                    return chunks[current].data + start;
+                }
+                if (current + 1 < chunks.size() && chunks[current + 1].size >= bytes + align) {
+                    current++; // reuse a chunk kept by an earlier rewind
+                    used = 0;
+                    continue;
+                }
+            }
+            // New chunk right after the current one, so rewinding still works in order
+            Chunk chunk;
+            chunk.size = std::max(chunkSize, bytes + align);
+            chunk.data = (char*)std::malloc(chunk.size);
+            if (!chunk.data) throw std::bad_alloc();
+            reserved += chunk.size;
+            chunkSize = std::min(chunkSize * 2, maxChunkSize);
+            size_t at = chunks.empty() ? 0 : current + 1;
+            chunks.insert(chunks.begin() + at, chunk);
+            current = at;
+            used = 0;
+        }
+    }
+
+    template <class T>
+    T* allocateArray(size_t count) {
+        return (T*)allocate(count * sizeof(T), alignof(T));
+    }
+
+    // Position to rewind to
+    struct Mark {
+        size_t chunk, offset;
+    };
+
+    Mark mark() const {
+        Mark m = {current, used};
+        return m;
+    }
+
+    // Discard everything allocated since m; the chunks stay for reuse
+    void rewind(const Mark& m) {
+        current = m.chunk;
+        used = m.offset;
+    }
+
+    void reset() {
+        current = 0;
+        used = 0;
+    }
+
+    // Return every chunk to the system
+    void release() {
+        for (size_t i = 0; i < chunks.size(); i++) std::free(chunks[i].data);
+        chunks.clear();
+        current = 0;
+        used = 0;
+        reserved = 0;
+    }
+
+    // Bytes obtained from the system
+    size_t bytesReserved() const { return reserved; }
+
+private:
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+
+    struct Chunk {
+        char* data;
+        size_t size;
+    };
+
+    std::vector<Chunk> chunks;
+    size_t chunkSize; // of the next new chunk
+    size_t maxChunkSize;
+    size_t current; // chunk being filled
+    size_t used;    // bytes of it handed out
+    size_t reserved;
+};
+
+// Rewinds an arena to where it was when the scope began
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena& scopeArena) : arena(scopeArena), start(scopeArena.mark()) {}
+    ~ArenaScope() { arena.rewind(start); }
+
+private:
+    ArenaScope(const ArenaScope&);
+    ArenaScope& operator=(const ArenaScope&);
+
+    Arena& arena;
+    Arena::Mark start;
+};
+
+// Per-thread arena for query temporaries; wrap its use in an ArenaScope
+inline Arena& scratchArena() {
+    static thread_local Arena arena;
+    return arena;
+}
+
+// Standard allocator handing out arena memory, for containers that live
+// no longer than the arena's current scope. deallocate() does nothing.
+template <class T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    explicit ArenaAllocator(Arena& source) : arena(&source) {}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t count) { return arena->allocateArray<T>(count); }
+    void deallocate(T*, size_t) {}
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+private:
+    template <class U>
+    friend class ArenaAllocator;
+
+    Arena* arena;
+};
+
+// Vector whose buffer comes from an arena
+template <class T>
+struct ArenaVector {
+    typedef std::vector<T, ArenaAllocator<T> > type;
+};
+
+// Append-only sequence in blocks taken from an arena. The first block
+// holds 2^FIRST_BITS elements and each later one as many as all before
+// it, up to 2^BLOCK_BITS; from there blocks keep that size. A short list
+// takes little memory, and past the first BLOCK elements an index is
+// found with a shift and a mask. Growing never copies, and at most one
+// block is unused.
+template <class T, unsigned BLOCK_BITS = 14, unsigned FIRST_BITS = 6>
+class ArenaList {
+public:
+    static const size_t BLOCK = (size_t)1 << BLOCK_BITS;
+    static const size_t FIRST = (size_t)1 << FIRST_BITS;
+
+    explicit ArenaList(Arena& source) : arena(&source), count(0), capacity(0) {}
+
+    void push_back(const T& value) {
+        if (count == capacity) {
+            size_t size = count < FIRST ? FIRST : std::min(count, BLOCK);
+            blocks.push_back(arena->allocateArray<T>(size));
+            capacity += size;
+        }
+        new (at(count)) T(value);
+        count++;
+    }
+
+    T& operator[](size_t i) { return *at(i); }
+    const T& operator[](size_t i) const { return *at(i); }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // Forget the elements; the caller resets or releases the arena
+    void clear() {
+        blocks.clear();
+        count = 0;
+        capacity = 0;
+    }
+
+    size_t memoryBytes() const { return capacity * sizeof(T) + blocks.size() * sizeof(T*); }
+
+private:
+    // Blocks below BLOCK elements: [0, FIRST) and then [2^k, 2^(k+1))
+    static const size_t GROWING_BLOCKS = BLOCK_BITS - FIRST_BITS + 1;
+
+    T* at(size_t i) const {
+        if (i >= BLOCK) return blocks[GROWING_BLOCKS - 1 + (i >> BLOCK_BITS)] + (i & (BLOCK - 1));
+        if (i < FIRST) return blocks[0] + i;
+        unsigned high = 63 - __builtin_clzll(i);
+        return blocks[high - FIRST_BITS + 1] + (i - ((size_t)1 << high));
+    }
+
+    Arena* arena;
+    std::vector<T*> blocks;
+    size_t count;
+    size_t capacity; // elements the blocks hold
+};
+
+template <class T, unsigned BLOCK_BITS, unsigned FIRST_BITS>
+const size_t ArenaList<T, BLOCK_BITS, FIRST_BITS>::BLOCK;
+template <class T, unsigned BLOCK_BITS, unsigned FIRST_BITS>
+const size_t ArenaList<T, BLOCK_BITS, FIRST_BITS>::FIRST;
+template <class T, unsigned BLOCK_BITS, unsigned FIRST_BITS>
+const size_t ArenaList<T, BLOCK_BITS, FIRST_BITS>::GROWING_BLOCKS;
+
+#endif
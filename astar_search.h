@@ -0,0 +1,246 @@
+#ifndef ASTAR_SEARCH_H
+#define ASTAR_SEARCH_H
+
+#include <algorithm>
+#include <cmath>
+
+#include "csr_graph.h"
+#include "search_context.h"
+#include "open_list.h"
+#include "landmarks.h"
+#include "search_stats.h"
+#include "heuristic_kernels.h"
+
+// Euclidean distance between two node ids
+inline double euclideanHeuristic(const CsrGraph& g, NodeId from, NodeId to) {
+    double dx = g.x(to) - g.x(from);
+    double dy = g.y(to) - g.y(from);
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+// Heuristics are callables estimating the cost from a node to a fixed
+// goal. evaluate() estimates a batch of nodes at once; the search uses it
+// for all neighbors improved by one expansion.
+
+// Metric distance (see heuristic_kernels.h) from a node's coordinates to
+// the goal's. Batches of at least a full vector run through the kernel
+// of the given SIMD level; smaller ones, and every batch at the default
+// scalar level, are estimated inline.
+template <class Metric>
+struct CoordinateHeuristic {
+    const CsrGraph& g;
+    NodeId goal;
+    double goalX, goalY;
+    DistanceKernel kernel;
+    size_t minBatch; // fewest nodes handed to kernel
+
+    CoordinateHeuristic(const CsrGraph& graph, NodeId goalNode, SimdLevel level = defaultSimdLevel())
+        : g(graph), goal(goalNode), goalX(graph.x(goalNode)), goalY(graph.y(goalNode)),
+          kernel(distanceKernel<Metric>(level)), minBatch(kernelMinBatch(level)) {}
+
+    double operator()(NodeId u) const { return Metric::distance(g.x(u) - goalX, g.y(u) - goalY); }
+
+    void evaluate(const NodeId* nodes, size_t count, double* out) const {
+        if (count < minBatch) {
+            for (size_t i = 0; i < count; i++) out[i] = (*this)(nodes[i]);
+            return;
+        }
+        kernel(g.xData(), g.yData(), nodes, count, goalX, goalY, out);
+    }
+};
+
+typedef CoordinateHeuristic<EuclideanMetric> EuclideanHeuristic;
+typedef CoordinateHeuristic<ManhattanMetric> ManhattanHeuristic;
+typedef CoordinateHeuristic<OctileMetric> OctileHeuristic;
+
+// ALT lower bound from a precomputed landmark table
+struct LandmarkHeuristic {
+    const LandmarkTable& table;
+    NodeId goal;
+    LandmarkHeuristic(const LandmarkTable& landmarks, NodeId goalNode) : table(landmarks), goal(goalNode) {}
+    double operator()(NodeId u) const { return table.bound(u, goal); }
+
+    void evaluate(const NodeId* nodes, size_t count, double* out) const {
+        for (size_t i = 0; i < count; i++) out[i] = table.bound(nodes[i], goal);
+    }
+};
+
+// Stop as soon as this node is expanded
+struct SingleGoal {
+    NodeId goal;
+    explicit SingleGoal(NodeId goalNode) : goal(goalNode) {}
+    bool operator()(NodeId u) const { return u == goal; }
+};
+
+// Edge filter that lets every edge through
+struct AllEdges {
+    bool operator()(EdgeId) const { return true; }
+};
+
+// No estimate at all: A* with it is Dijkstra's algorithm
+struct ZeroHeuristic {
+    double operator()(NodeId) const { return 0; }
+    void evaluate(const NodeId*, size_t count, double* out) const { std::fill(out, out + count, 0.0); }
+};
+
+// A* specialized at compile time for one graph view, heuristic, open list
+// and stats policy, so the whole loop can be inlined.
+//
+// GraphView needs numNodes(), edgeBegin(u), edgeEnd(u), target(e) and
+// weight(e) like CsrGraph (or a CompactWeightGraph to read float or
+// fixed-point weights). Heuristic needs operator()(u) and a batch
+// evaluate(); Stats is a policy from search_stats.h. The search uses ctx
+// as scratch space and open as the open list. Expanded nodes are closed;
+// a closed node whose g-score still improves (inconsistent heuristic) is
+// reopened.
+template <class GraphView, class Heuristic, class OpenList, class Stats = NoSearchStats>
+class AStar {
+public:
+    AStar(const GraphView& graph, SearchContext& scratch, OpenList& openList, const Heuristic& estimate,
+          Stats& statistics)
+        : g(graph), ctx(scratch), open(openList), heuristic(estimate), stats(statistics) {}
+
+    // Search from start until a node passing isGoal is expanded, relaxing
+    // only edges passing allowEdge. Returns that node, or INVALID_NODE if
+    // none is reachable; ctx.g() has its cost and ctx.buildPath() the path.
+    template <class GoalTest, class EdgeFilter>
+    NodeId search(NodeId start, const GoalTest& isGoal, const EdgeFilter& allowEdge) {
+        stats.beginSearch(ctx.memoryBytes());
+        ctx.reset(g.numNodes());
+        open.reset(g.numNodes());
+        stats.endSetup();
+
+        ctx.setG(start, 0, INVALID_NODE);
+        ctx.setState(start, SearchContext::OPEN);
+        stats.heuristic();
+        open.push(start, heuristic(start));
+        stats.push(open.size());
+
+        NodeId reached = INVALID_NODE;
+        while (!open.empty()) {
+            NodeId current = open.pop();
+            stats.pop();
+            if (ctx.stateOf(current) != SearchContext::OPEN) {
+                stats.stalePop();
+                continue; // stale entry from a lazy open list
+            }
+            ctx.setState(current, SearchContext::CLOSED);
+            ctx.countExpansion();
+
+            if (isGoal(current)) {
+                reached = current;
+                break;
+            }
+
+            // Relax every edge first, then estimate the improved neighbors in one batch
+            double currentG = ctx.g(current);
+            NodeId* improved = ctx.batchNodes(g.edgeEnd(current) - g.edgeBegin(current));
+            size_t improvedCount = 0;
+            for (EdgeId e = g.edgeBegin(current); e < g.edgeEnd(current); e++) {
+                if (!allowEdge(e)) continue;
+                NodeId neighbor = g.target(e);
+                double tentativeGScore = currentG + g.weight(e);
+                stats.relax();
+
+                if (tentativeGScore < ctx.g(neighbor)) {
+                    ctx.setG(neighbor, tentativeGScore, current);
+                    ctx.setState(neighbor, SearchContext::OPEN);
+                    improved[improvedCount++] = neighbor;
+                }
+            }
+
+            double* estimates = ctx.batchEstimates();
+            heuristic.evaluate(improved, improvedCount, estimates);
+            for (size_t i = 0; i < improvedCount; i++) {
+                stats.heuristic();
+                open.push(improved[i], ctx.g(improved[i]) + estimates[i]);
+                stats.push(open.size());
+            }
+        }
+
+        stats.endSearch(ctx.memoryBytes());
+        return reached;
+    }
+
+    // Path cost from start to goal, or INFINITE_COST if goal is unreachable
+    double search(NodeId start, NodeId goal) {
+        return search(start, SingleGoal(goal), AllEdges()) == INVALID_NODE ? INFINITE_COST : ctx.g(goal);
+    }
+
+private:
+    const GraphView& g;
+    SearchContext& ctx;
+    OpenList& open;
+    const Heuristic& heuristic;
+    Stats& stats;
+};
+
+// A* from start to goal over the frozen graph (see AStar). Returns the
+// path cost, or INFINITE_COST if goal is unreachable; on success
+// ctx.buildPath(goal) yields the node ids along the path.
+template <class OpenList, class Heuristic, class Stats>
+double astarSearchWith(const CsrGraph& g, SearchContext& ctx, OpenList& open, NodeId start, NodeId goal,
+                       const Heuristic& heuristic, Stats& stats) {
+    return AStar<CsrGraph, Heuristic, OpenList, Stats>(g, ctx, open, heuristic, stats).search(start, goal);
+}
+
+// Same without statistics
+template <class OpenList, class Heuristic>
+double astarSearchWith(const CsrGraph& g, SearchContext& ctx, OpenList& open, NodeId start, NodeId goal,
+                       const Heuristic& heuristic) {
+    NoSearchStats none;
+    return astarSearchWith(g, ctx, open, start, goal, heuristic, none);
+}
+
+// A* with the Euclidean heuristic
+template <class OpenList>
+double astarSearchWith(const CsrGraph& g, SearchContext& ctx, OpenList& open, NodeId start, NodeId goal) {
+    return astarSearchWith(g, ctx, open, start, goal, EuclideanHeuristic(g, goal));
+}
+
+// A* with the open list chosen at run time and any heuristic callable
+template <class Heuristic, class Stats>
+double astarSearchHeuristic(const CsrGraph& g, SearchContext& ctx, NodeId start, NodeId goal, OpenListKind kind,
+                            const Heuristic& heuristic, Stats& stats) {
+    switch (kind) {
+        case OPEN_LIST_BINARY_HEAP:
+            return astarSearchWith(g, ctx, ctx.binaryHeap, start, goal, heuristic, stats);
+        case OPEN_LIST_RADIX_HEAP:
+            return astarSearchWith(g, ctx, ctx.radixHeap, start, goal, heuristic, stats);
+        case OPEN_LIST_QUATERNARY_HEAP:
+        default:
+            return astarSearchWith(g, ctx, ctx.quaternaryHeap, start, goal, heuristic, stats);
+    }
+}
+
+template <class Heuristic>
+double astarSearchHeuristic(const CsrGraph& g, SearchContext& ctx, NodeId start, NodeId goal, OpenListKind kind,
+                            const Heuristic& heuristic) {
+    NoSearchStats none;
+    return astarSearchHeuristic(g, ctx, start, goal, kind, heuristic, none);
+}
+
+template <class Stats>
+double astarSearchStats(const CsrGraph& g, SearchContext& ctx, NodeId start, NodeId goal, OpenListKind kind,
+                        const LandmarkTable* landmarks, Stats& stats) {
+    if (landmarks && !landmarks->empty()) {
+        return astarSearchHeuristic(g, ctx, start, goal, kind, LandmarkHeuristic(*landmarks, goal), stats);
+    }
+    return astarSearchHeuristic(g, ctx, start, goal, kind, EuclideanHeuristic(g, goal), stats);
+}
+
+// Uses the ALT heuristic when a landmark table for g is given, otherwise
+// the Euclidean one. Counters are added to stats when it is given; the
+// choice is made once per query, so searches without it are not slowed.
+inline double astarSearch(const CsrGraph& g, SearchContext& ctx, NodeId start, NodeId goal,
+                          OpenListKind kind = OPEN_LIST_QUATERNARY_HEAP, const LandmarkTable* landmarks = nullptr,
+                          SearchStats* stats = nullptr) {
+    if (stats) {
+        CollectSearchStats collect(*stats);
+        return astarSearchStats(g, ctx, start, goal, kind, landmarks, collect);
+    }
+    NoSearchStats none;
+    return astarSearchStats(g, ctx, start, goal, kind, landmarks, none);
+}
+
+#endif
@@ -0,0 +1,296 @@
+#ifndef BATCH_QUERY_H
+#define BATCH_QUERY_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "csr_graph.h"
+#include "search_context.h"
+#include "open_list.h"
+#include "astar_search.h"
+#include "search_stats.h"
+#include "path_cache.h"
+#include "spatial_index.h"
+#include "parallel.h"
+
+// One (start, goal) pair of a batch
+struct PathQuery {
+    NodeId start;
+    NodeId goal;
+};
+
+// A query between two arbitrary positions, answered between the nodes
+// nearest to them
+struct PointQuery {
+    double startX, startY;
+    double goalX, goalY;
+};
+
+// Answer to one PathQuery; cost is INFINITE_COST if there is no path
+struct PathResult {
+    double cost;
+    std::vector<NodeId> path;
+    std::vector<double> costs; // cost of reaching path[i]
+    double latencyMicros;
+};
+
+// Throughput and latency summary of one batch run
+struct BatchReport {
+    size_t queries;
+    unsigned threads;
+    double seconds;
+    double queriesPerSecond;
+    double p50Micros, p90Micros, p99Micros, maxMicros;
+};
+
+// Many-to-many query engine. A fixed pool of worker threads, each with its
+// own SearchContext, answers batches of queries against a shared read-only
+// CsrGraph. Each worker starts on an equal slice of the batch and steals
+// half of another worker's remaining slice when its own runs dry.
+class BatchQueryEngine {
+public:
+    // threads == 0 uses one worker per hardware thread
+    explicit BatchQueryEngine(unsigned threads = 0)
+        : graph(nullptr), queries(nullptr), results(nullptr), openList(OPEN_LIST_QUATERNARY_HEAP),
+          landmarks(nullptr), collecting(false), cache(nullptr), cacheVersion(0), jobId(0), pending(0),
+          stopping(false) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        ranges = std::vector<WorkRange>(threads);
+        contexts = std::vector<SearchContext>(threads);
+        workerStats = std::vector<SearchStats>(threads);
+        for (unsigned i = 0; i < threads; i++) {
+            workers.push_back(std::thread(&BatchQueryEngine::workerLoop, this, i));
+        }
+    }
+
+    ~BatchQueryEngine() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+    }
+
+    unsigned threadCount() const { return (unsigned)workers.size(); }
+
+    // Answer repeated queries from pathCache while the graph is at version,
+    // and store new results there; nullptr turns the cache off
+    void usePathCache(PathCache* pathCache, uint64_t version) {
+        std::lock_guard<std::mutex> lock(mutex);
+        cache = pathCache;
+        cacheVersion = version;
+    }
+
+    // Answer count queries into out (resized to count). Reusing the same
+    // out vector across batches keeps the path buffers allocated. A
+    // non-empty landmark table switches the searches to the ALT heuristic.
+    // With stats given, the counters of every query are added to it.
+    BatchReport run(const CsrGraph& g, const PathQuery* batch, size_t count, std::vector<PathResult>& out,
+                    OpenListKind kind = OPEN_LIST_QUATERNARY_HEAP, const LandmarkTable* table = nullptr,
+                    SearchStats* stats = nullptr) {
+        out.resize(count);
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+        if (count > 0) {
+            // Split the batch into one contiguous slice per worker
+            unsigned n = threadCount();
+            for (unsigned i = 0; i < n; i++) {
+                uint32_t from = (uint32_t)(count * i / n);
+                uint32_t to = (uint32_t)(count * (i + 1) / n);
+                ranges[i].bounds.store(pack(from, to));
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            graph = &g;
+            queries = batch;
+            results = &out[0];
+            openList = kind;
+            landmarks = table;
+            collecting = stats != nullptr;
+            for (unsigned i = 0; i < n; i++) workerStats[i].clear();
+            pending = n;
+            jobId++;
+            wake.notify_all();
+            done.wait(lock, [this] { return pending == 0; });
+            if (stats) {
+                for (unsigned i = 0; i < n; i++) stats->add(workerStats[i]);
+            }
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        return summarize(out, threadCount(), seconds);
+    }
+
+    BatchReport run(const CsrGraph& g, const std::vector<PathQuery>& batch, std::vector<PathResult>& out,
+                    OpenListKind kind = OPEN_LIST_QUATERNARY_HEAP, const LandmarkTable* table = nullptr,
+                    SearchStats* stats = nullptr) {
+        return run(g, batch.empty() ? nullptr : &batch[0], batch.size(), out, kind, table, stats);
+    }
+
+    // Snap both ends of every point query to their nearest nodes in index
+    // (built over g), then answer the batch like run() above
+    BatchReport run(const CsrGraph& g, const SpatialIndex& index, const std::vector<PointQuery>& batch,
+                    std::vector<PathResult>& out, OpenListKind kind = OPEN_LIST_QUATERNARY_HEAP,
+                    const LandmarkTable* table = nullptr, SearchStats* stats = nullptr) {
+        snapped.resize(batch.size());
+        parallelFor(batch.size(), threadCount(), [&](size_t i, unsigned) {
+            snapped[i].start = index.nearest(batch[i].startX, batch[i].startY);
+            snapped[i].goal = index.nearest(batch[i].goalX, batch[i].goalY);
+        }, 256);
+        return run(g, snapped, out, kind, table, stats);
+    }
+
+    // Percentiles over the per-query latencies of a finished batch
+    static BatchReport summarize(const std::vector<PathResult>& out, unsigned threads, double seconds) {
+        BatchReport report;
+        report.queries = out.size();
+        report.threads = threads;
+        report.seconds = seconds;
+        report.queriesPerSecond = seconds > 0 ? out.size() / seconds : 0;
+        report.p50Micros = report.p90Micros = report.p99Micros = report.maxMicros = 0;
+        if (out.empty()) return report;
+
+        std::vector<double> latencies(out.size());
+        for (size_t i = 0; i < out.size(); i++) latencies[i] = out[i].latencyMicros;
+        report.p50Micros = percentile(latencies, 0.50);
+        report.p90Micros = percentile(latencies, 0.90);
+        report.p99Micros = percentile(latencies, 0.99);
+        report.maxMicros = *std::max_element(latencies.begin(), latencies.end());
+        return report;
+    }
+
+private:
+    // Remaining [begin, end) slice of one worker packed into one atomic word,
+    // so the owner (taking from the front) and thieves (taking the back half)
+    // can both claim work with a single compare-and-swap
+    struct WorkRange {
+        std::atomic<uint64_t> bounds;
+        WorkRange() : bounds(0) {}
+        WorkRange(const WorkRange&) : bounds(0) {}
+    };
+
+    static const uint32_t CHUNK = 16;
+
+    static uint64_t pack(uint32_t begin, uint32_t end) { return ((uint64_t)begin << 32) | end; }
+    static uint32_t rangeBegin(uint64_t r) { return (uint32_t)(r >> 32); }
+    static uint32_t rangeEnd(uint64_t r) { return (uint32_t)r; }
+
+    static double percentile(std::vector<double>& values, double q) {
+        size_t k = (size_t)(q * (values.size() - 1) + 0.5);
+        std::nth_element(values.begin(), values.begin() + k, values.end());
+        return values[k];
+    }
+
+    // Claim up to CHUNK queries from the front of our own slice
+    bool takeOwn(unsigned self, uint32_t& from, uint32_t& to) {
+        uint64_t r = ranges[self].bounds.load();
+        while (rangeBegin(r) < rangeEnd(r)) {
+            uint32_t b = rangeBegin(r);
+            uint32_t e = std::min(rangeEnd(r), b + CHUNK);
+            if (ranges[self].bounds.compare_exchange_weak(r, pack(e, rangeEnd(r)))) {
+                from = b;
+                to = e;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Move the back half of another worker's slice into our own
+    bool steal(unsigned self) {
+        unsigned n = threadCount();
+        for (unsigned k = 1; k < n; k++) {
+            unsigned victim = (self + k) % n;
+            uint64_t r = ranges[victim].bounds.load();
+            while (rangeBegin(r) < rangeEnd(r)) {
+                uint32_t b = rangeBegin(r), e = rangeEnd(r);
+                uint32_t mid = b + (e - b) / 2;
+                if (ranges[victim].bounds.compare_exchange_weak(r, pack(b, mid))) {
+                    ranges[self].bounds.store(pack(mid, e));
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void workerLoop(unsigned self) {
+        uint64_t seenJob = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this, seenJob] { return stopping || jobId != seenJob; });
+                if (stopping) return;
+                seenJob = jobId;
+            }
+
+            SearchContext& ctx = contexts[self];
+            SearchStats* stats = collecting ? &workerStats[self] : nullptr;
+            uint32_t from, to;
+            while (takeOwn(self, from, to) || (steal(self) && takeOwn(self, from, to))) {
+                for (uint32_t i = from; i < to; i++) answer(ctx, queries[i], results[i], stats);
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) done.notify_one();
+        }
+    }
+
+    void answer(SearchContext& ctx, const PathQuery& q, PathResult& result, SearchStats* stats) {
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        result.path.clear();
+        result.costs.clear();
+        result.cost = INFINITE_COST;
+        bool known = q.start < graph->numNodes() && q.goal < graph->numNodes();
+        if (known && cache && cache->lookup(q.start, q.goal, cacheVersion, result.path, result.cost)) {
+            cachedPathCosts(*graph, result.path, result.costs);
+        } else if (known) {
+            result.cost = astarSearch(*graph, ctx, q.start, q.goal, openList, landmarks, stats);
+            if (result.cost != INFINITE_COST) {
+                std::chrono::steady_clock::time_point pathBegin = std::chrono::steady_clock::now();
+                const std::vector<NodeId>& path = ctx.buildPath(q.goal);
+                result.path.assign(path.begin(), path.end());
+                const std::vector<double>& costs = ctx.buildPathCosts();
+                result.costs.assign(costs.begin(), costs.end());
+                if (stats) {
+                    stats->pathMicros += std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - pathBegin).count();
+                }
+            }
+            if (cache) cache->insert(q.start, q.goal, cacheVersion, result.cost, result.path);
+        }
+        result.latencyMicros = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - begin).count();
+    }
+
+    // Current job, published under the mutex
+    const CsrGraph* graph;
+    const PathQuery* queries;
+    PathResult* results;
+    OpenListKind openList;
+    const LandmarkTable* landmarks;
+    bool collecting;
+    PathCache* cache;
+    uint64_t cacheVersion;
+
+    std::vector<WorkRange> ranges;
+    std::vector<SearchContext> contexts; // one per worker, reused across batches
+    std::vector<SearchStats> workerStats; // per worker, merged after each batch
+    std::vector<PathQuery> snapped; // point queries resolved to node ids
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    uint64_t jobId;
+    unsigned pending;
+    bool stopping;
+};
+
+#endif
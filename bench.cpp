@@ -0,0 +1,1180 @@
+// Benchmark program for the A* engine
+// Compares the open-list implementations on synthetic grids and road graphs,
+// and the grid-map searches on an obstacle map. With --suite it runs fixed
+// query sets through every engine on seeded graph families and sizes and
+// reports throughput, expansions, latency percentiles and peak RSS.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <atomic>
+#include <thread>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "csr_graph.h"
+#include "search_context.h"
+#include "open_list.h"
+#include "astar_search.h"
+#include "batch_query.h"
+#include "distance_table.h"
+#include "bidirectional_astar.h"
+#include "landmarks.h"
+#include "contraction_hierarchy.h"
+#include "grid_search.h"
+#include "incremental_search.h"
+#include "graph_snapshot.h"
+#include "compact_graph.h"
+#include "graph_reorder.h"
+#include "perf_counters.h"
+#include "delta_stepping.h"
+#include "isochrone.h"
+#include "graph_generators.h"
+
+// The Graph class, without the interactive program's main
+#define GRAPH_ASTAR_NO_MAIN
+#include "main.cpp"
+
+using namespace std;
+
+// Run every query with one open list, returns the total time in milliseconds
+double runQueries(const CsrGraph& g, const vector<pair<NodeId, NodeId>>& queries,
+                  OpenListKind kind, vector<double>& costs) {
+    SearchContext ctx;
+    costs.assign(queries.size(), 0);
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < queries.size(); i++) {
+        costs[i] = astarSearch(g, ctx, queries[i].first, queries[i].second, kind);
+    }
+    chrono::steady_clock::time_point end = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(end - begin).count();
+}
+
+void compareOpenLists(const string& label, const CsrGraph& g, size_t queryCount) {
+    vector<pair<NodeId, NodeId>> queries = makeQueries(g.numNodes(), queryCount, 7);
+    const OpenListKind kinds[] = {OPEN_LIST_BINARY_HEAP, OPEN_LIST_QUATERNARY_HEAP, OPEN_LIST_RADIX_HEAP};
+
+    cout << "\n" << label << " (" << g.numNodes() << " nodes, " << g.numEdges() << " edges, "
+         << queries.size() << " queries)" << endl;
+
+    vector<double> reference;
+    for (OpenListKind kind : kinds) {
+        vector<double> costs;
+        double ms = runQueries(g, queries, kind, costs);
+        if (reference.empty()) reference = costs;
+
+        // Radix keys are quantized, so allow a small difference in path cost
+        size_t mismatches = 0;
+        for (size_t i = 0; i < costs.size(); i++) {
+            if (fabs(costs[i] - reference[i]) > 1e-6 * max(1.0, reference[i]) && costs[i] != reference[i]) {
+                mismatches++;
+            }
+        }
+
+        cout << "  " << setw(8) << left << openListName(kind) << right
+             << setw(10) << fixed << setprecision(1) << ms << " ms"
+             << setw(12) << setprecision(0) << queries.size() / (ms / 1000.0) << " q/s";
+        if (mismatches > 0) cout << "  (" << mismatches << " cost mismatches)";
+        cout << endl;
+    }
+}
+
+// A* with the heuristic under Metric, its batch kernel forced to level
+template <class Metric>
+void runHeuristicQueries(const string& name, const CsrGraph& g, const vector<pair<NodeId, NodeId>>& queries,
+                         SimdLevel level, const vector<double>& reference, vector<double>& costs) {
+    SearchContext ctx;
+    costs.resize(queries.size());
+    uint64_t expanded = 0;
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < queries.size(); i++) {
+        CoordinateHeuristic<Metric> heuristic(g, queries[i].second, level);
+        costs[i] = astarSearchWith(g, ctx, ctx.quaternaryHeap, queries[i].first, queries[i].second, heuristic);
+        expanded += ctx.expandedCount();
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < costs.size() && i < reference.size(); i++) {
+        if (costs[i] != reference[i]) mismatches++;
+    }
+    cout << "  " << setw(18) << left << name << right << setw(10) << fixed << setprecision(1) << ms << " ms"
+         << setw(12) << setprecision(0) << queries.size() / (ms / 1000.0) << " q/s" << setw(10)
+         << expanded / queries.size() << " expanded/query";
+    if (mismatches > 0) cout << "  (" << mismatches << " cost mismatches)";
+    cout << endl;
+}
+
+// Scalar against SIMD heuristic kernels, and the metrics on an 8-connected grid
+void compareHeuristics(const string& label, const CsrGraph& g, const CsrGraph& grid, size_t queryCount) {
+    const char* levelNames[] = {"scalar", "AVX2", "AVX-512"};
+    SimdLevel best = detectSimdLevel();
+
+    vector<pair<NodeId, NodeId>> queries = makeQueries(g.numNodes(), queryCount, 59);
+    cout << "\n" << label << " heuristic kernels (" << levelNames[best] << " detected)" << endl;
+    vector<double> reference, costs;
+    for (int level = SIMD_SCALAR; level <= best; level++) {
+        runHeuristicQueries<EuclideanMetric>(string("euclidean ") + levelNames[level], g, queries,
+                                             (SimdLevel)level, reference, costs);
+        if (reference.empty()) reference = costs;
+    }
+
+    // Octile distance is a tighter lower bound on the grid, so it expands fewer nodes
+    queries = makeQueries(grid.numNodes(), queryCount, 61);
+    cout << "  grid " << grid.numNodes() << " nodes:" << endl;
+    reference.clear();
+    runHeuristicQueries<EuclideanMetric>("euclidean", grid, queries, best, reference, costs);
+    reference = costs;
+    runHeuristicQueries<OctileMetric>("octile", grid, queries, best, reference, costs);
+}
+
+// One AStar instantiation on queries; costs are compared with reference
+template <class GraphView, class Heuristic>
+void runSpecialized(const string& name, const GraphView& view, const CsrGraph& g,
+                    const vector<pair<NodeId, NodeId>>& queries, const vector<double>& reference, size_t weightBytes) {
+    SearchContext ctx;
+    NoSearchStats none;
+    uint64_t expanded = 0;
+    double worstError = 0;
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < queries.size(); i++) {
+        Heuristic heuristic(g, queries[i].second);
+        AStar<GraphView, Heuristic, IndexedDaryHeap<4>> search(view, ctx, ctx.quaternaryHeap, heuristic, none);
+        double cost = search.search(queries[i].first, queries[i].second);
+        expanded += ctx.expandedCount();
+        if (reference[i] != INFINITE_COST && reference[i] > 0) {
+            worstError = max(worstError, fabs(cost - reference[i]) / reference[i]);
+        }
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+    cout << "  " << setw(18) << left << name << right << setw(10) << fixed << setprecision(1) << ms << " ms"
+         << setw(10) << setprecision(0) << queries.size() / (ms / 1000.0) << " q/s" << setw(9)
+         << expanded / queries.size() << " expanded" << setw(7) << weightBytes / 1024 << " KiB weights"
+         << "  cost error " << scientific << setprecision(1) << worstError << fixed << endl;
+}
+
+// Dijkstra ignores its goal; adapts ZeroHeuristic to the (graph, goal) constructor above
+struct DijkstraHeuristic : ZeroHeuristic {
+    DijkstraHeuristic(const CsrGraph&, NodeId) {}
+};
+
+// Runtime-dispatched astarSearch against compile-time AStar instantiations
+void compareSpecializations(const string& label, const CsrGraph& g, size_t queryCount) {
+    vector<pair<NodeId, NodeId>> queries = makeQueries(g.numNodes(), queryCount, 67);
+    cout << "\n" << label << " A* specializations (" << queries.size() << " queries)" << endl;
+
+    vector<double> reference;
+    double ms = runQueries(g, queries, OPEN_LIST_QUATERNARY_HEAP, reference);
+    cout << "  " << setw(18) << left << "astarSearch" << right << setw(10) << fixed << setprecision(1) << ms
+         << " ms" << setw(10) << setprecision(0) << queries.size() / (ms / 1000.0) << " q/s" << endl;
+
+    runSpecialized<CsrGraph, EuclideanHeuristic>("double", g, g, queries, reference,
+                                                 g.numEdges() * sizeof(double));
+    CompactWeightGraph<float> floats(g);
+    runSpecialized<CompactWeightGraph<float>, EuclideanHeuristic>("float", floats, g, queries, reference,
+                                                                  floats.weightBytes());
+    CompactWeightGraph<uint32_t> fixed32(g);
+    runSpecialized<CompactWeightGraph<uint32_t>, EuclideanHeuristic>("uint32_t", fixed32, g, queries, reference,
+                                                                     fixed32.weightBytes());
+    runSpecialized<CsrGraph, DijkstraHeuristic>("double, Dijkstra", g, g, queries, reference,
+                                                g.numEdges() * sizeof(double));
+}
+
+// Edge span, query time and cache misses of the graph as given and after
+// each reordering; the same queries are translated to the new ids
+void benchmarkReordering(const string& label, const CsrGraph& g, size_t queryCount) {
+    vector<pair<NodeId, NodeId>> queries = makeQueries(g.numNodes(), queryCount, 71);
+    CacheMissCounter misses;
+    cout << "\n" << label << " node order (" << queries.size() << " queries"
+         << (misses.available() ? "" : ", cache-miss counter unavailable") << ")" << endl;
+
+    vector<double> reference;
+    for (int order = -1; order <= ORDER_RCM; order++) {
+        CsrGraph layout = g;
+        vector<pair<NodeId, NodeId>> translated = queries;
+        double reorderMs = 0;
+        if (order >= 0) {
+            chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+            vector<NodeId> oldToNew;
+            layout = reorderGraph(g, computeNodeOrder(g, (NodeOrder)order), &oldToNew);
+            reorderMs = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+            for (size_t i = 0; i < queries.size(); i++) {
+                translated[i] = make_pair(oldToNew[queries[i].first], oldToNew[queries[i].second]);
+            }
+        }
+
+        LayoutStats stats = measureLayout(layout);
+        vector<double> costs;
+        misses.start();
+        double ms = runQueries(layout, translated, OPEN_LIST_QUATERNARY_HEAP, costs);
+        uint64_t missCount = misses.stop();
+        if (reference.empty()) reference = costs;
+        size_t mismatches = 0;
+        for (size_t i = 0; i < costs.size(); i++) {
+            if (fabs(costs[i] - reference[i]) > 1e-9 * max(1.0, reference[i])) mismatches++;
+        }
+
+        cout << "  " << setw(10) << left << (order < 0 ? "as given" : nodeOrderName((NodeOrder)order)) << right
+             << fixed << setprecision(0) << "span mean " << setw(7) << stats.meanSpan << " p50 " << setw(6)
+             << stats.medianSpan << " p90 " << setw(6) << stats.p90Span << "  near " << setprecision(2)
+             << stats.nearFraction << setprecision(1) << setw(9) << ms << " ms";
+        if (misses.available()) cout << setw(10) << missCount / queries.size() << " misses/query";
+        if (order >= 0) cout << "  (reordered in " << reorderMs << " ms)";
+        if (mismatches > 0) cout << "  (" << mismatches << " cost mismatches)";
+        cout << endl;
+    }
+}
+
+// Unidirectional vs bidirectional A* on the same queries
+void compareBidirectional(const string& label, const CsrGraph& g, size_t queryCount) {
+    vector<pair<NodeId, NodeId>> queries = makeQueries(g.numNodes(), queryCount, 13);
+    SearchContext ctx;
+    BidirectionalAStar bidirectional;
+
+    vector<double> reference(queries.size());
+    for (size_t i = 0; i < queries.size(); i++) {
+        reference[i] = astarSearch(g, ctx, queries[i].first, queries[i].second);
+    }
+
+    cout << "\n" << label << " unidirectional vs bidirectional A*" << endl;
+    const char* names[] = {"uni", "bidir", "bidir-mt"};
+    for (int mode = 0; mode < 3; mode++) {
+        uint64_t expanded = 0;
+        size_t mismatches = 0;
+        chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); i++) {
+            double cost;
+            if (mode == 0) {
+                cost = astarSearch(g, ctx, queries[i].first, queries[i].second);
+                expanded += ctx.expandedCount();
+            } else {
+                cost = bidirectional.search(g, queries[i].first, queries[i].second, mode == 2);
+                expanded += bidirectional.expandedCount();
+            }
+            if (fabs(cost - reference[i]) > 1e-9 * max(1.0, reference[i]) && cost != reference[i]) mismatches++;
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+        cout << "  " << setw(8) << left << names[mode] << right
+             << setw(12) << fixed << setprecision(0) << (double)expanded / queries.size() << " expanded/query"
+             << setw(10) << setprecision(1) << ms << " ms";
+        if (mismatches > 0) cout << "  (" << mismatches << " cost mismatches)";
+        cout << endl;
+    }
+}
+
+// Euclidean vs ALT heuristic, including landmark preprocessing time
+void compareLandmarks(const string& label, const CsrGraph& g, size_t queryCount, uint32_t count) {
+    vector<pair<NodeId, NodeId>> queries = makeQueries(g.numNodes(), queryCount, 17);
+    SearchContext ctx;
+
+    cout << "\n" << label << " Euclidean vs ALT (" << count << " landmarks)" << endl;
+    const LandmarkSelection selections[] = {LANDMARKS_FARTHEST, LANDMARKS_AVOID};
+    const char* names[] = {"farthest", "avoid"};
+    vector<double> reference(queries.size());
+    for (int mode = -1; mode < 2; mode++) {
+        LandmarkTable table;
+        double buildMs = 0;
+        if (mode >= 0) {
+            chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+            table.build(g, count, selections[mode]);
+            buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+        }
+
+        uint64_t expanded = 0;
+        size_t mismatches = 0;
+        chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); i++) {
+            double cost = astarSearch(g, ctx, queries[i].first, queries[i].second, OPEN_LIST_QUATERNARY_HEAP,
+                                      mode >= 0 ? &table : nullptr);
+            expanded += ctx.expandedCount();
+            if (mode < 0) reference[i] = cost;
+            else if (fabs(cost - reference[i]) > 1e-9 * max(1.0, reference[i]) && cost != reference[i]) mismatches++;
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+        cout << "  " << setw(10) << left << (mode < 0 ? "euclidean" : names[mode]) << right
+             << setw(12) << fixed << setprecision(0) << (double)expanded / queries.size() << " expanded/query"
+             << setw(10) << setprecision(1) << ms << " ms";
+        if (mode >= 0) {
+            cout << "  build " << buildMs << " ms, " << table.memoryBytes() / (1024 * 1024.0) << " MiB";
+        }
+        if (mismatches > 0) cout << "  (" << mismatches << " cost mismatches)";
+        cout << endl;
+    }
+}
+
+// Contraction hierarchy preprocessing and query time against plain A*
+void benchmarkHierarchy(const string& label, const CsrGraph& g, size_t queryCount) {
+    vector<pair<NodeId, NodeId>> queries = makeQueries(g.numNodes(), queryCount, 19);
+    SearchContext ctx;
+    vector<double> reference(queries.size());
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < queries.size(); i++) {
+        reference[i] = astarSearch(g, ctx, queries[i].first, queries[i].second);
+    }
+    double astarMs = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+
+    ContractionHierarchy ch;
+    begin = chrono::steady_clock::now();
+    ch.build(g);
+    double buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+
+    ChQuery query;
+    uint64_t settled = 0;
+    size_t mismatches = 0;
+    begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < queries.size(); i++) {
+        double cost = query.search(ch, queries[i].first, queries[i].second);
+        settled += query.expandedCount();
+        if (fabs(cost - reference[i]) > 1e-9 * max(1.0, reference[i]) && cost != reference[i]) mismatches++;
+    }
+    double chMs = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+
+    cout << "\n" << label << " contraction hierarchy (" << ch.numShortcuts() << " shortcuts, built in "
+         << fixed << setprecision(0) << buildMs << " ms)" << endl;
+    cout << "  " << setw(8) << left << "A*" << right << setw(10) << setprecision(1)
+         << astarMs * 1000 / queries.size() << " us/query" << endl;
+    cout << "  " << setw(8) << left << "CH" << right << setw(10) << setprecision(1)
+         << chMs * 1000 / queries.size() << " us/query" << setw(8) << setprecision(0)
+         << (double)settled / queries.size() << " settled/query";
+    if (mismatches > 0) cout << "  (" << mismatches << " cost mismatches)";
+    cout << endl;
+}
+
+// Throughput of the multi-threaded batch engine
+void benchmarkBatch(const string& label, const CsrGraph& g, size_t queryCount) {
+    vector<pair<NodeId, NodeId>> pairs = makeQueries(g.numNodes(), queryCount, 11);
+    vector<PathQuery> batch(pairs.size());
+    for (size_t i = 0; i < pairs.size(); i++) {
+        batch[i].start = pairs[i].first;
+        batch[i].goal = pairs[i].second;
+    }
+
+    BatchQueryEngine engine;
+    vector<PathResult> results;
+    BatchReport report = engine.run(g, batch, results);
+
+    cout << "\n" << label << " batch of " << report.queries << " queries on "
+         << report.threads << " thread(s)" << endl;
+    cout << "  " << fixed << setprecision(0) << report.queriesPerSecond << " q/s"
+         << "  p50 " << setprecision(1) << report.p50Micros << " us"
+         << "  p90 " << report.p90Micros << " us"
+         << "  p99 " << report.p99Micros << " us"
+         << "  max " << report.maxMicros << " us" << endl;
+
+    // Same batch with the search counters on
+    SearchStats stats;
+    report = engine.run(g, batch, results, OPEN_LIST_QUATERNARY_HEAP, nullptr, &stats);
+    cout << "  with stats " << setprecision(0) << report.queriesPerSecond << " q/s" << endl;
+    cout << "  " << stats.toJson() << endl;
+}
+
+// Many-to-many tables between nodes of one neighborhood: the bucket
+// strategy against one forward search per source, with the nodes each
+// settles per source and a check that the bucket searches stop well
+// before a full search would
+void benchmarkDistanceTable(const string& label, const CsrGraph& g, size_t count) {
+    vector<pair<NodeId, NodeId>> centers = makeQueries(g.numNodes(), 1, 73);
+    IsochroneEngine area;
+    Isochrone around;
+    area.reachable(g, centers[0].first, 8 * DeltaStepping::defaultDelta(g), around);
+    vector<NodeId> sources, targets;
+    for (size_t i = 0; i < around.size() && targets.size() < count; i++) {
+        (i % 2 == 0 ? sources : targets).push_back(around.nodes[i]);
+    }
+    cout << "\n" << label << " distance table, " << sources.size() << " x " << targets.size()
+         << " nodes of one neighborhood" << endl;
+
+    DistanceTableEngine engine;
+    DistanceTable forward, buckets;
+    TableOptions options;
+    const TableStrategy strategies[] = {TABLE_FORWARD, TABLE_BUCKETS};
+    const char* names[] = {"forward", "buckets"};
+    DistanceTable* tables[] = {&forward, &buckets};
+    uint64_t bucketSettled = 0;
+    for (int k = 0; k < 2; k++) {
+        options.strategy = strategies[k];
+        chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+        engine.manyToMany(g, sources, targets, options, *tables[k]);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+        uint64_t settled = engine.settledCount();
+        if (strategies[k] == TABLE_BUCKETS) bucketSettled = settled;
+        cout << "  " << setw(10) << left << names[k] << right << fixed << setprecision(2) << setw(9) << ms
+             << " ms" << setw(10) << settled / max<size_t>(1, sources.size()) << " settled/source" << endl;
+    }
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < forward.costs.size(); i++) {
+        // The two strategies add the same edges in another order
+        if (!(fabs(forward.costs[i] - buckets.costs[i]) <= 1e-9 * forward.costs[i]) &&
+            forward.costs[i] != buckets.costs[i]) {
+            mismatches++;
+        }
+    }
+    bool bounded = bucketSettled < (uint64_t)sources.size() * g.numNodes();
+    cout << "  full search " << g.numNodes() << " settled/source, buckets "
+         << (bounded ? "stop early" : "DO NOT STOP EARLY") << "  (" << mismatches << " mismatches)" << endl;
+}
+
+// LPA* repair after small sets of weight changes against replanning from
+// scratch. Changed edges are random, or half of them on the current path;
+// every change multiplies a weight by 1.5 to 4 or removes the edge.
+// Weights are restored after each route.
+void benchmarkReplanning(const string& label, CsrGraph g, size_t routeCount) {
+    vector<pair<NodeId, NodeId>> routes = makeQueries(g.numNodes(), routeCount, 29);
+    const size_t changeCounts[] = {1, 10, 100};
+    mt19937 rng(31);
+    SearchContext ctx;
+
+    cout << "\n" << label << " incremental replanning (LPA*) vs A* from scratch, " << routes.size() << " routes"
+         << endl;
+    for (int onPath = 0; onPath < 2; onPath++) {
+        for (size_t changes : changeCounts) {
+            double repairMs = 0, coldMs = 0;
+            uint64_t repairExpanded = 0, coldExpanded = 0;
+            size_t mismatches = 0;
+            for (size_t r = 0; r < routes.size(); r++) {
+                LpaStar planner;
+                planner.search(g, routes[r].first, routes[r].second);
+                const vector<NodeId>& path = planner.buildPath();
+
+                vector<EdgeId> changed;
+                vector<double> original;
+                for (size_t k = 0; k < changes; k++) {
+                    EdgeId e = (EdgeId)(rng() % g.numEdges());
+                    if (onPath && k % 2 == 0 && path.size() > 1) {
+                        size_t i = rng() % (path.size() - 1);
+                        e = g.findEdge(path[i], path[i + 1]);
+                    }
+                    changed.push_back(e);
+                    original.push_back(g.weight(e));
+                    g.setWeight(e, rng() % 5 == 0 ? INFINITE_COST : g.weight(e) * (1.5 + (rng() % 6) * 0.5));
+                }
+
+                chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+                double repaired = planner.update(changed);
+                repairMs += chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+                repairExpanded += planner.expandedCount();
+
+                begin = chrono::steady_clock::now();
+                double cold = astarSearch(g, ctx, routes[r].first, routes[r].second);
+                coldMs += chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+                coldExpanded += ctx.expandedCount();
+                if (fabs(repaired - cold) > 1e-9 * max(1.0, cold) && repaired != cold) mismatches++;
+
+                // Restore in reverse so repeated edges get their first weight back
+                for (size_t k = changed.size(); k-- > 0;) g.setWeight(changed[k], original[k]);
+            }
+            cout << "  " << setw(4) << changes << (onPath ? " on path" : " random ") << "  repair " << fixed
+                 << setprecision(1) << setw(8) << repairMs * 1000 / routes.size() << " us" << setw(8) << setprecision(0)
+                 << (double)repairExpanded / routes.size() << " expanded   cold " << setprecision(1) << setw(8)
+                 << coldMs * 1000 / routes.size() << " us" << setw(8) << setprecision(0)
+                 << (double)coldExpanded / routes.size() << " expanded   speedup " << setprecision(1)
+                 << (repairMs > 0 ? coldMs / repairMs : 0) << "x";
+            if (mismatches > 0) cout << "  (" << mismatches << " cost mismatches)";
+            cout << endl;
+        }
+    }
+}
+
+// Query throughput on pinned snapshots, alone and while a writer
+// publishes a new version with changedEdges reweighted every 10 ms
+void benchmarkSnapshots(const string& label, const CsrGraph& g, unsigned threads, size_t changedEdges) {
+    cout << "\n" << label << " snapshot reads, " << threads << " query thread(s)" << endl;
+    vector<pair<NodeId, NodeId>> queries = makeQueries(g.numNodes(), 4096, 37);
+    for (int withUpdates = 0; withUpdates < 2; withUpdates++) {
+        SnapshotGraph store(g);
+        atomic<bool> stop(false);
+        atomic<uint64_t> answered(0);
+        vector<thread> readers;
+        for (unsigned t = 0; t < threads; t++) {
+            readers.push_back(thread([&, t] {
+                SnapshotGraph::Reader reader(store);
+                SearchContext ctx;
+                for (size_t i = t; !stop.load(); i += threads) {
+                    SnapshotGraph::Pin pin(reader);
+                    const pair<NodeId, NodeId>& q = queries[i % queries.size()];
+                    astarSearch(pin.graph(), ctx, q.first, q.second);
+                    answered.fetch_add(1);
+                }
+            }));
+        }
+
+        size_t versions = 0;
+        mt19937 rng(41);
+        chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+        chrono::steady_clock::time_point end = begin + chrono::seconds(2);
+        while (chrono::steady_clock::now() < end) {
+            if (withUpdates) {
+                // Random slowdowns, so weights stay above the Euclidean bound
+                vector<pair<EdgeId, double>> changes(changedEdges);
+                for (size_t k = 0; k < changedEdges; k++) {
+                    EdgeId e = (EdgeId)(rng() % g.numEdges());
+                    changes[k] = make_pair(e, g.weight(e) * (1.0 + (rng() % 100) / 100.0));
+                }
+                store.updateWeights(changes);
+                versions++;
+            }
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        stop = true;
+        for (size_t t = 0; t < readers.size(); t++) readers[t].join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+        cout << "  " << setw(14) << left << (withUpdates ? "with updates" : "no updates") << right << fixed
+             << setprecision(0) << setw(10) << answered.load() / seconds << " q/s";
+        if (withUpdates) cout << "  " << versions << " versions of " << changedEdges << " changed edges published";
+        cout << endl;
+    }
+}
+
+// Graph::aStar on a skewed workload, a Zipf(1) draw over a fixed set of
+// (start, goal) pairs, with and without the path cache
+void benchmarkPathCache(const string& label, const CsrGraph& g, size_t pairCount, size_t queryCount) {
+    vector<pair<NodeId, NodeId>> pairs = makeQueries(g.numNodes(), pairCount, 43);
+    vector<double> cumulative(pairs.size());
+    double total = 0;
+    for (size_t i = 0; i < pairs.size(); i++) {
+        total += 1.0 / (i + 1);
+        cumulative[i] = total;
+    }
+    mt19937 rng(47);
+    uniform_real_distribution<double> pick(0, total);
+    vector<pair<string, string>> queries(queryCount);
+    for (size_t i = 0; i < queryCount; i++) {
+        size_t k = lower_bound(cumulative.begin(), cumulative.end(), pick(rng)) - cumulative.begin();
+        k = min(k, pairs.size() - 1);
+        queries[i] = make_pair(g.name(pairs[k].first), g.name(pairs[k].second));
+    }
+
+    cout << "\n" << label << " path cache, " << queryCount << " Zipf queries over " << pairs.size() << " pairs" << endl;
+    for (int cached = 0; cached < 2; cached++) {
+        Graph graph;
+        graph.assign(g);
+        if (cached) graph.enablePathCache(16 << 20);
+        chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); i++) graph.aStar(queries[i].first, queries[i].second);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+        cout << "  " << setw(9) << left << (cached ? "cache" : "no cache") << right << fixed << setprecision(0)
+             << setw(10) << queries.size() / seconds << " q/s";
+        if (cached) {
+            PathCacheStats stats = graph.pathCacheStats();
+            cout << "  hit ratio " << setprecision(3) << stats.hitRatio() << ", " << stats.entries << " entries in "
+                 << stats.bytes / 1024 << " KiB";
+        }
+        cout << endl;
+    }
+}
+
+double squaredDistance(const CsrGraph& g, NodeId u, const pair<double, double>& p) {
+    double dx = g.x(u) - p.first, dy = g.y(u) - p.second;
+    return dx * dx + dy * dy;
+}
+
+// Nearest-node snapping with the spatial index against a linear scan
+void benchmarkSpatialIndex(const string& label, const CsrGraph& g, size_t queryCount) {
+    SpatialIndex index;
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    index.build(g);
+    double buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+
+    double minX = 0, minY = 0, maxX = 0, maxY = 0;
+    index.bounds(minX, minY, maxX, maxY);
+    mt19937 rng(53);
+    uniform_real_distribution<double> pickX(minX, maxX), pickY(minY, maxY);
+    vector<pair<double, double>> points(queryCount);
+    for (size_t i = 0; i < queryCount; i++) points[i] = make_pair(pickX(rng), pickY(rng));
+
+    cout << "\n" << label << " spatial index (" << index.memoryBytes() / 1024 << " KiB built in " << fixed
+         << setprecision(1) << buildMs << " ms), " << queryCount << " nearest-node queries" << endl;
+
+    vector<NodeId> fromIndex(queryCount);
+    begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < queryCount; i++) fromIndex[i] = index.nearest(points[i].first, points[i].second);
+    double indexSeconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    size_t scanned = min<size_t>(queryCount, 200), mismatches = 0;
+    begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < scanned; i++) {
+        NodeId best = 0;
+        for (NodeId u = 1; u < g.numNodes(); u++) {
+            if (squaredDistance(g, u, points[i]) < squaredDistance(g, best, points[i])) best = u;
+        }
+        // Compare distances, ties may pick another node at the same distance
+        if (squaredDistance(g, fromIndex[i], points[i]) != squaredDistance(g, best, points[i])) mismatches++;
+    }
+    double scanSeconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    cout << "  " << setw(12) << left << "k-d tree" << right << setprecision(0) << setw(12)
+         << queryCount / indexSeconds << " q/s" << endl;
+    cout << "  " << setw(12) << left << "linear scan" << right << setw(12) << scanned / scanSeconds << " q/s  ("
+         << mismatches << " mismatches over " << scanned << " queries)" << endl;
+}
+
+// Rebuild g through CsrBuilder with long node names, as a parsed file
+// would, and report the bytes held per node and edge while building and
+// once frozen
+void benchmarkMemory(const string& label, const CsrGraph& g) {
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    CsrBuilder builder;
+    for (NodeId u = 0; u < g.numNodes(); u++) builder.addNode("node_" + g.name(u), g.x(u), g.y(u));
+    size_t nodeBytes = builder.memoryBytes();
+    for (NodeId u = 0; u < g.numNodes(); u++) {
+        for (EdgeId e = g.edgeBegin(u); e < g.edgeEnd(u); e++) builder.addEdge(u, g.target(e), g.weight(e));
+    }
+    size_t edgeBytes = builder.memoryBytes() - nodeBytes;
+    CsrGraph frozen = builder.finalize();
+    double buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+
+    cout << "\n" << label << " memory (" << g.numNodes() << " nodes, " << g.numEdges() << " edges, built in "
+         << fixed << setprecision(0) << buildMs << " ms)" << endl;
+    cout << setprecision(1);
+    cout << "  " << setw(12) << left << "builder" << right << setw(8) << (double)nodeBytes / g.numNodes()
+         << " B/node" << setw(8) << (double)edgeBytes / g.numEdges() << " B/edge" << endl;
+    cout << "  " << setw(12) << left << "frozen" << right << setw(8)
+         << (double)(frozen.memoryBytes() - frozen.edgeBytes()) / g.numNodes() << " B/node" << setw(8)
+         << (double)frozen.edgeBytes() / g.numEdges() << " B/edge" << endl;
+}
+
+// Full single-source distances: sequential Dijkstra against
+// delta-stepping on 1, 2, 4, ... workers up to threads, each run checked
+// against the Dijkstra distances
+void benchmarkSingleSource(const string& label, const CsrGraph& g, unsigned threads, size_t sourceCount) {
+    vector<pair<NodeId, NodeId>> sources = makeQueries(g.numNodes(), sourceCount, 61);
+    cout << "\n" << label << " single-source distances, " << sourceCount << " sources (delta "
+         << fixed << setprecision(2) << DeltaStepping::defaultDelta(g) << ")" << endl;
+
+    SearchContext ctx;
+    vector<vector<double>> expected(sourceCount);
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < sourceCount; i++) dijkstraDistances(g, ctx, sources[i].first, expected[i]);
+    double dijkstraMs = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count() / sourceCount;
+    cout << "  " << setw(20) << left << "Dijkstra" << right << setprecision(1) << setw(10) << dijkstraMs
+         << " ms/source" << endl;
+
+    vector<double> dist;
+    vector<NodeId> parent;
+    for (unsigned workers = 1; workers <= threads; workers *= 2) {
+        DeltaStepping engine(workers);
+        double totalMs = 0;
+        size_t mismatches = 0, phases = 0;
+        for (size_t i = 0; i < sourceCount; i++) {
+            SsspReport report = engine.run(g, sources[i].first, dist, parent);
+            totalMs += report.seconds * 1000;
+            phases += report.phases;
+            for (NodeId v = 0; v < g.numNodes(); v++) {
+                if (dist[v] != expected[i][v]) mismatches++;
+            }
+            mismatches += checkShortestPaths(g, sources[i].first, dist, parent);
+        }
+        cout << "  " << setw(20) << left << ("delta-stepping x" + to_string(workers)) << right << setw(10)
+             << totalMs / sourceCount << " ms/source  (" << phases / sourceCount << " rounds, " << mismatches
+             << " mismatches)" << endl;
+    }
+}
+
+// Reachable sets within budgets of 1x, 4x and 16x the mean edge weight:
+// the bounded search against a full Dijkstra filtered afterwards, and a
+// parallel batch of the same queries
+void benchmarkIsochrones(const string& label, const CsrGraph& g, unsigned threads, size_t sourceCount) {
+    vector<pair<NodeId, NodeId>> pairs = makeQueries(g.numNodes(), sourceCount, 67);
+    vector<NodeId> sources;
+    for (size_t i = 0; i < pairs.size(); i++) sources.push_back(pairs[i].first);
+    double meanWeight = DeltaStepping::defaultDelta(g) / 2;
+    cout << "\n" << label << " isochrones, " << sourceCount << " sources" << endl;
+
+    IsochroneEngine engine;
+    Isochrone iso;
+    SearchContext ctx;
+    vector<double> dist;
+    vector<IsochroneEngine> engines;
+    vector<Isochrone> batch;
+    for (double factor : {1.0, 4.0, 16.0}) {
+        double budget = factor * meanWeight;
+        size_t reached = 0, mismatches = 0;
+        chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+        for (size_t i = 0; i < sources.size(); i++) {
+            engine.reachable(g, sources[i], budget, iso, true);
+            reached += iso.size();
+        }
+        double boundedUs = chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count();
+
+        // Full searches are slow; a few suffice for the time and the check
+        size_t fullCount = min<size_t>(sources.size(), 10);
+        double fullUs = 0;
+        for (size_t i = 0; i < fullCount; i++) {
+            begin = chrono::steady_clock::now();
+            dijkstraDistances(g, ctx, sources[i], dist);
+            fullUs += chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count();
+            engine.reachable(g, sources[i], budget, iso);
+            size_t inside = 0;
+            for (NodeId v = 0; v < g.numNodes(); v++) {
+                if (dist[v] <= budget) {
+                    inside++;
+                    if (iso.costOf(v) != dist[v]) mismatches++;
+                }
+            }
+            if (inside != iso.size()) mismatches++;
+        }
+
+        begin = chrono::steady_clock::now();
+        reachableBatch(g, sources, budget, batch, engines, threads, true);
+        double batchUs = chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count();
+
+        cout << "  budget " << fixed << setprecision(1) << setw(6) << budget << setw(9) << reached / sources.size()
+             << " nodes" << setprecision(0) << setw(9) << boundedUs / sources.size() << " us bounded"
+             << setw(9) << fullUs / fullCount << " us full" << setw(9) << batchUs / sources.size()
+             << " us batched x" << threads << "  (" << mismatches << " mismatches)" << endl;
+    }
+}
+
+// Writing a batch of path results: one flushed stream write per line
+// with every hop weight looked up in the graph, as the menu used to,
+// against ResultWriter's block-flushed text, NDJSON and binary records
+// with the weights the searches recorded. Output goes to the null device.
+void benchmarkResultOutput(const string& label, const CsrGraph& g, size_t queryCount) {
+#ifdef _WIN32
+    const char* nullDevice = "NUL";
+#else
+    const char* nullDevice = "/dev/null";
+#endif
+    vector<pair<NodeId, NodeId>> pairs = makeQueries(g.numNodes(), queryCount, 71);
+    vector<PathQuery> batch(pairs.size());
+    for (size_t i = 0; i < pairs.size(); i++) {
+        batch[i].start = pairs[i].first;
+        batch[i].goal = pairs[i].second;
+    }
+    BatchQueryEngine engine;
+    vector<PathResult> results;
+    engine.run(g, batch, results);
+    size_t hops = 0;
+    for (size_t i = 0; i < results.size(); i++) hops += results[i].path.size();
+    cout << "\n" << label << " result output, " << results.size() << " paths, " << hops << " path nodes" << endl;
+
+    ofstream lines(nullDevice);
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    size_t writes = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        const vector<NodeId>& path = results[i].path;
+        if (path.empty()) {
+            lines << "No path found!" << endl;
+            writes++;
+            continue;
+        }
+        lines << "Path found: ";
+        for (size_t k = 0; k < path.size(); k++) {
+            lines << g.name(path[k]);
+            if (k + 1 < path.size()) lines << " -(" << g.weight(g.findEdge(path[k], path[k + 1])) << ")-> ";
+        }
+        lines << endl;
+        lines << "Total path cost: " << fixed << setprecision(2) << results[i].cost << endl;
+        lines << "Number of nodes in path: " << path.size() << endl;
+        lines.unsetf(ios::fixed);
+        lines << setprecision(6);
+        writes += 3;
+    }
+    double lineMs = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+    cout << "  " << setw(20) << left << "cout + endl" << right << fixed << setprecision(1) << setw(9) << lineMs
+         << " ms" << setw(10) << writes << " writes" << endl;
+
+    const ResultFormat formats[] = {RESULT_TEXT, RESULT_NDJSON, RESULT_BINARY};
+    const char* names[] = {"ResultWriter text", "ResultWriter ndjson", "ResultWriter binary"};
+    for (int f = 0; f < 3; f++) {
+        ofstream sink(nullDevice, ios::binary);
+        OutputBuffer out(sink);
+        ResultWriter writer(out, formats[f]);
+        begin = chrono::steady_clock::now();
+        for (size_t i = 0; i < results.size(); i++) {
+            writer.writePath(g, i, batch[i].start, batch[i].goal, results[i].cost, results[i].path,
+                             results[i].costs);
+        }
+        out.flush();
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+        cout << "  " << setw(20) << left << names[f] << right << setw(9) << ms << " ms" << setw(10)
+             << out.flushCount() << " writes" << setw(9) << out.bytesWritten() / ms / 1000 << " MB/s" << endl;
+    }
+}
+
+// Grid map searches: plain A* against JPS and JPS+
+void compareGridSearch(const string& label, const GridMap& map, size_t queryCount) {
+    // Random passable (start, goal) pairs
+    vector<pair<NodeId, NodeId>> queries;
+    vector<pair<NodeId, NodeId>> candidates = makeQueries(map.cellCount(), queryCount * 4, 23);
+    for (size_t i = 0; i < candidates.size() && queries.size() < queryCount; i++) {
+        NodeId s = candidates[i].first, t = candidates[i].second;
+        if (map.passable(map.cellX(s), map.cellY(s)) && map.passable(map.cellX(t), map.cellY(t))) {
+            queries.push_back(candidates[i]);
+        }
+    }
+
+    JumpTable table;
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    table.build(map);
+    double buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+
+    cout << "\n" << label << " grid search (map " << map.memoryBytes() / 1024 << " KiB, JPS+ table "
+         << table.memoryBytes() / (1024 * 1024) << " MiB built in " << fixed << setprecision(0) << buildMs << " ms)"
+         << endl;
+    const char* names[] = {"A*", "JPS", "JPS+"};
+    GridSearch search;
+    vector<double> reference(queries.size());
+    for (int mode = GRID_ASTAR; mode <= GRID_JPS_PLUS; mode++) {
+        uint64_t expanded = 0;
+        size_t mismatches = 0;
+        begin = chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); i++) {
+            double cost = search.search(map, queries[i].first, queries[i].second, (GridSearchMode)mode, &table);
+            expanded += search.expandedCount();
+            if (mode == GRID_ASTAR) reference[i] = cost;
+            else if (fabs(cost - reference[i]) > 1e-9 * max(1.0, reference[i]) && cost != reference[i]) mismatches++;
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+        cout << "  " << setw(6) << left << names[mode] << right << setw(10) << setprecision(1)
+             << ms * 1000 / queries.size() << " us/query" << setw(10) << setprecision(0)
+             << (double)expanded / queries.size() << " expanded/query";
+        if (mismatches > 0) cout << "  (" << mismatches << " cost mismatches)";
+        cout << endl;
+    }
+}
+
+// Peak resident set size of the process so far, in KiB
+long peakRssKiB() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return (long)(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+// One engine on one graph in the suite
+struct SuiteRow {
+    string family;
+    uint32_t requestedNodes;
+    NodeId nodes;
+    EdgeId edges;
+    string engine;
+    size_t queries;
+    double queriesPerSecond;
+    double expandedPerQuery;
+    double p50Micros, p99Micros;
+    size_t mismatches; // path costs that differ from plain A*
+    long peakRssKiB;
+};
+
+struct SuiteOptions {
+    vector<uint32_t> sizes;
+    size_t queries;
+    uint32_t seed;
+    uint32_t hierarchyLimit; // largest graph that gets contracted
+    string csvPath, jsonPath;
+
+    SuiteOptions() : queries(200), seed(1), hierarchyLimit(100000) {
+        sizes.push_back(1000);
+        sizes.push_back(10000);
+        sizes.push_back(100000);
+    }
+};
+
+class Suite {
+public:
+    explicit Suite(const SuiteOptions& opts) : options(opts) {}
+
+    void run() {
+        const char* families[] = {"geometric", "grid", "scale-free"};
+        cout << "=== A* BENCHMARK SUITE ===" << endl;
+        cout << left << setw(11) << "family" << right << setw(10) << "nodes" << setw(11) << "edges" << "  "
+             << left << setw(12) << "engine" << right << setw(11) << "q/s" << setw(11) << "expanded"
+             << setw(10) << "p50 us" << setw(10) << "p99 us" << setw(12) << "peak KiB" << endl;
+        for (uint32_t size : options.sizes) {
+            for (int f = 0; f < 3; f++) {
+                runFamily(families[f], size, options.seed + f);
+            }
+        }
+        cout << "==========================" << endl;
+    }
+
+    bool writeCsv(const string& path) const {
+        ofstream out(path.c_str());
+        if (!out) return false;
+        out << "family,requested_nodes,nodes,edges,engine,queries,queries_per_sec,expanded_per_query,"
+               "p50_us,p99_us,cost_mismatches,peak_rss_kib\n";
+        for (const SuiteRow& r : rows) {
+            out << r.family << "," << r.requestedNodes << "," << r.nodes << "," << r.edges << "," << r.engine
+                << "," << r.queries << "," << fixed << setprecision(1) << r.queriesPerSecond << ","
+                << r.expandedPerQuery << "," << setprecision(2) << r.p50Micros << "," << r.p99Micros << ","
+                << r.mismatches << "," << r.peakRssKiB << "\n";
+        }
+        return (bool)out;
+    }
+
+    bool writeJson(const string& path) const {
+        ofstream out(path.c_str());
+        if (!out) return false;
+        out << "{\n  \"seed\": " << options.seed << ",\n  \"queries\": " << options.queries
+            << ",\n  \"results\": [";
+        for (size_t i = 0; i < rows.size(); i++) {
+            const SuiteRow& r = rows[i];
+            out << (i ? "," : "") << "\n    {\"family\": \"" << r.family << "\", \"requested_nodes\": "
+                << r.requestedNodes << ", \"nodes\": " << r.nodes << ", \"edges\": " << r.edges
+                << ", \"engine\": \"" << r.engine << "\", \"queries\": " << r.queries << fixed
+                << setprecision(1) << ", \"queries_per_sec\": " << r.queriesPerSecond
+                << ", \"expanded_per_query\": " << r.expandedPerQuery << setprecision(2)
+                << ", \"p50_us\": " << r.p50Micros << ", \"p99_us\": " << r.p99Micros
+                << ", \"cost_mismatches\": " << r.mismatches << ", \"peak_rss_kib\": " << r.peakRssKiB << "}";
+        }
+        out << "\n  ]\n}\n";
+        return (bool)out;
+    }
+
+private:
+    void runFamily(const string& family, uint32_t size, uint32_t seed) {
+        GridMap map;
+        vector<NodeId> cellOf;
+        CsrGraph g;
+        if (family == "geometric") {
+            g = makeRoadGraph(size, 3, seed);
+        } else if (family == "grid") {
+            uint32_t side = max<uint32_t>(2, (uint32_t)sqrt((double)size));
+            map = makeObstacleGridMap(side, side, 0.25, seed);
+            g = makeGridMapGraph(map, &cellOf);
+        } else {
+            g = makeScaleFreeGraph(size, 2, seed);
+        }
+        vector<pair<NodeId, NodeId>> queries = makeQueries(g.numNodes(), options.queries, seed);
+
+        // Through the public name-based API first: its costs are the reference
+        Graph graph;
+        graph.assign(g);
+        vector<string> starts(queries.size()), goals(queries.size());
+        for (size_t i = 0; i < queries.size(); i++) {
+            starts[i] = g.name(queries[i].first);
+            goals[i] = g.name(queries[i].second);
+        }
+        reference.assign(queries.size(), INFINITE_COST);
+        measure(family, size, g, "graph-astar", queries, [&](size_t i, double& cost) {
+            vector<string> path = graph.aStar(starts[i], goals[i]);
+            if (!path.empty()) cost = pathCost(g, path);
+            return graph.searchExpandedCount();
+        });
+
+        SearchContext ctx;
+        measure(family, size, g, "astar", queries, [&](size_t i, double& cost) {
+            cost = astarSearch(g, ctx, queries[i].first, queries[i].second);
+            if (cost != INFINITE_COST) ctx.buildPath(queries[i].second);
+            return ctx.expandedCount();
+        });
+
+        BidirectionalAStar bidirectional;
+        measure(family, size, g, "bidir", queries, [&](size_t i, double& cost) {
+            cost = bidirectional.search(g, queries[i].first, queries[i].second);
+            return bidirectional.expandedCount();
+        });
+
+        LandmarkTable landmarks;
+        landmarks.build(g, 16, LANDMARKS_AVOID);
+        measure(family, size, g, "alt", queries, [&](size_t i, double& cost) {
+            cost = astarSearch(g, ctx, queries[i].first, queries[i].second, OPEN_LIST_QUATERNARY_HEAP, &landmarks);
+            return ctx.expandedCount();
+        });
+
+        // Contraction blows up around the hubs of scale-free graphs
+        uint32_t hierarchyLimit = family == "scale-free" ? min<uint32_t>(options.hierarchyLimit, 10000)
+                                                         : options.hierarchyLimit;
+        if (g.numNodes() <= hierarchyLimit) {
+            ContractionHierarchy ch;
+            ch.build(g);
+            ChQuery query;
+            measure(family, size, g, "ch", queries, [&](size_t i, double& cost) {
+                cost = query.search(ch, queries[i].first, queries[i].second);
+                return query.expandedCount();
+            });
+        }
+
+        if (!map.empty()) {
+            JumpTable table;
+            table.build(map);
+            GridSearch search;
+            measure(family, size, g, "jps+", queries, [&](size_t i, double& cost) {
+                cost = search.search(map, cellOf[queries[i].first], cellOf[queries[i].second], GRID_JPS_PLUS, &table);
+                return search.expandedCount();
+            });
+        }
+    }
+
+    // Sum of the cheapest edge weights along a node-name path
+    static double pathCost(const CsrGraph& g, const vector<string>& path) {
+        double cost = 0;
+        for (size_t i = 0; i + 1 < path.size(); i++) {
+            cost += g.weight(g.findEdge(g.findNode(path[i]), g.findNode(path[i + 1])));
+        }
+        return cost;
+    }
+
+    // Time every query on its own; query(i, cost) returns the expansions
+    template <class Query>
+    void measure(const string& family, uint32_t size, const CsrGraph& g, const string& engine,
+                 const vector<pair<NodeId, NodeId>>& queries, Query query) {
+        bool isReference = engine == "graph-astar";
+        vector<double> latencies(queries.size());
+        uint64_t expanded = 0;
+        size_t mismatches = 0;
+        chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); i++) {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            double cost = INFINITE_COST;
+            expanded += query(i, cost);
+            latencies[i] = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+            if (isReference) reference[i] = cost;
+            else if (fabs(cost - reference[i]) > 1e-6 * max(1.0, reference[i]) && cost != reference[i]) mismatches++;
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+        SuiteRow row;
+        row.family = family;
+        row.requestedNodes = size;
+        row.nodes = g.numNodes();
+        row.edges = g.numEdges();
+        row.engine = engine;
+        row.queries = queries.size();
+        row.queriesPerSecond = seconds > 0 ? queries.size() / seconds : 0;
+        row.expandedPerQuery = queries.empty() ? 0 : (double)expanded / queries.size();
+        sort(latencies.begin(), latencies.end());
+        row.p50Micros = percentile(latencies, 0.50);
+        row.p99Micros = percentile(latencies, 0.99);
+        row.mismatches = mismatches;
+        row.peakRssKiB = peakRssKiB();
+        rows.push_back(row);
+
+        cout << left << setw(11) << row.family << right << setw(10) << row.nodes << setw(11) << row.edges << "  "
+             << left << setw(12) << row.engine << right << fixed << setprecision(0) << setw(11)
+             << row.queriesPerSecond << setw(11) << row.expandedPerQuery << setprecision(1) << setw(10)
+             << row.p50Micros << setw(10) << row.p99Micros << setw(12) << row.peakRssKiB;
+        if (mismatches > 0) cout << "  (" << mismatches << " cost mismatches)";
+        cout << endl;
+    }
+
+    static double percentile(const vector<double>& sorted, double q) {
+        if (sorted.empty()) return 0;
+        return sorted[(size_t)(q * (sorted.size() - 1) + 0.5)];
+    }
+
+    SuiteOptions options;
+    vector<SuiteRow> rows;
+    vector<double> reference;
+};
+
+// graph_bench --suite [--sizes N,N,...] [--queries N] [--seed N]
+//             [--ch-limit N] [--csv FILE] [--json FILE]
+int runSuite(int argc, char** argv) {
+    SuiteOptions options;
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Missing value for " << arg << endl;
+            return 1;
+        }
+        string value = argv[++i];
+        if (arg == "--sizes") {
+            options.sizes.clear();
+            stringstream list(value);
+            string item;
+            while (getline(list, item, ',')) {
+                if (atol(item.c_str()) > 0) options.sizes.push_back((uint32_t)atol(item.c_str()));
+            }
+        } else if (arg == "--queries") {
+            options.queries = (size_t)atol(value.c_str());
+        } else if (arg == "--seed") {
+            options.seed = (uint32_t)atol(value.c_str());
+        } else if (arg == "--ch-limit") {
+            options.hierarchyLimit = (uint32_t)atol(value.c_str());
+        } else if (arg == "--csv") {
+            options.csvPath = value;
+        } else if (arg == "--json") {
+            options.jsonPath = value;
+        } else {
+            cerr << "Unknown option " << arg << endl;
+            return 1;
+        }
+    }
+    if (options.sizes.empty() || options.queries == 0) {
+        cerr << "Need at least one size and one query" << endl;
+        return 1;
+    }
+
+    Suite suite(options);
+    suite.run();
+    if (!options.csvPath.empty() && !suite.writeCsv(options.csvPath)) {
+        cerr << "Error: cannot write " << options.csvPath << endl;
+        return 1;
+    }
+    if (!options.jsonPath.empty() && !suite.writeJson(options.jsonPath)) {
+        cerr << "Error: cannot write " << options.jsonPath << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && string(argv[1]) == "--suite") {
+        return runSuite(argc, argv);
+    }
+
+    // Optional scale factor for the graph sizes
+    double scale = argc > 1 ? atof(argv[1]) : 1.0;
+    if (scale <= 0) scale = 1.0;
+
+    cout << "=== A* OPEN LIST BENCHMARK ===" << endl;
+
+    uint32_t side = (uint32_t)(300 * sqrt(scale));
+    compareOpenLists("Grid " + to_string(side) + "x" + to_string(side), makeGridGraph(side, side, 1), 200);
+
+    uint32_t roadNodes = (uint32_t)(100000 * scale);
+    CsrGraph road = makeRoadGraph(roadNodes, 3, 2);
+    compareOpenLists("Road graph", road, 200);
+    compareHeuristics("Road graph", road, makeGridGraph(side, side, 1), 200);
+    compareSpecializations("Road graph", road, 200);
+    benchmarkReordering("Road graph", road, 200);
+    benchmarkMemory("Road graph", road);
+    benchmarkBatch("Road graph", road, 1000);
+    benchmarkDistanceTable("Road graph", road, 64);
+    compareBidirectional("Road graph", road, 200);
+    compareLandmarks("Road graph", road, 200, 16);
+    benchmarkHierarchy("Road graph", road, 1000);
+    benchmarkSingleSource("Road graph", road, max(1u, thread::hardware_concurrency()), 10);
+    benchmarkIsochrones("Road graph", road, max(1u, thread::hardware_concurrency()), 1000);
+    benchmarkReplanning("Road graph", makeRoadGraph(roadNodes, 3, 2), 100);
+    benchmarkPathCache("Road graph", road, 5000, 20000);
+    benchmarkSpatialIndex("Road graph", road, 100000);
+    benchmarkSnapshots("Road graph", road, max(1u, thread::hardware_concurrency()), 1000);
+    benchmarkResultOutput("Road graph", road, 2000);
+
+    uint32_t mapSide = (uint32_t)(1024 * sqrt(scale));
+    compareGridSearch("Obstacle map " + to_string(mapSide) + "x" + to_string(mapSide),
+                      makeObstacleGridMap(mapSide, mapSide, 0.25, 3), 200);
+
+    cout << "==============================" << endl;
+    return 0;
+}
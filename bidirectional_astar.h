@@ -0,0 +1,226 @@
+#ifndef BIDIRECTIONAL_ASTAR_H
+#define BIDIRECTIONAL_ASTAR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "csr_graph.h"
+#include "search_context.h"
+#include "open_list.h"
+
+// Bidirectional A* with the average potential
+//   pf(v) = (h(v, goal) - h(start, v)) / 2,   pr(v) = -pf(v)
+// built from the Euclidean heuristic. Both searches then run on the same
+// reduced-cost graph, so they may stop as soon as
+//   topKey(forward) + topKey(backward) >= best path cost seen so far.
+// The result is exact whenever the Euclidean heuristic is consistent
+// (edge weights never shorter than the straight-line distance).
+//
+// With parallel == true the backward search runs on a second thread. The
+// per-node labels are atomics: each side writes its own label before
+// reading the other side's, so at least one of them sees both when the
+// frontiers cross. A thread is started per query, so this only pays off
+// for long-range queries.
+class BidirectionalAStar {
+public:
+    BidirectionalAStar() : capacity(0), generation(0), start(INVALID_NODE), goal(INVALID_NODE),
+                           meeting(INVALID_NODE), bestCost(INFINITE_COST) {}
+
+    // Returns the path cost or INFINITE_COST; buildPath() gives the nodes
+    double search(const CsrGraph& g, NodeId startNode, NodeId goalNode, bool parallel = false) {
+        prepare(g, startNode, goalNode);
+        if (startNode == goalNode) {
+            meeting = startNode;
+            bestCost = 0;
+            return 0;
+        }
+
+        ReverseView reverse(g);
+        if (parallel) {
+            std::thread backward([this, &reverse] { runSide(reverse, BACKWARD); });
+            runSide(g, FORWARD);
+            backward.join();
+        } else {
+            // Expand whichever side has the smaller open list
+            while (!side[FORWARD].open.empty() && !side[BACKWARD].open.empty()) {
+                if (side[FORWARD].open.topKey() + side[BACKWARD].open.topKey() >= bestCost.load(std::memory_order_relaxed)) {
+                    break;
+                }
+                if (side[FORWARD].open.size() <= side[BACKWARD].open.size()) {
+                    expand(g, FORWARD, std::memory_order_relaxed);
+                } else {
+                    expand(reverse, BACKWARD, std::memory_order_relaxed);
+                }
+            }
+        }
+        return bestCost.load();
+    }
+
+    // Node ids from start to goal through the meeting node
+    const std::vector<NodeId>& buildPath() {
+        pathBuffer.clear();
+        if (meeting == INVALID_NODE) return pathBuffer;
+        for (NodeId v = meeting; v != INVALID_NODE; v = side[FORWARD].parent[v]) pathBuffer.push_back(v);
+        std::reverse(pathBuffer.begin(), pathBuffer.end());
+        for (NodeId v = side[BACKWARD].parent[meeting]; v != INVALID_NODE; v = side[BACKWARD].parent[v]) {
+            pathBuffer.push_back(v);
+        }
+        return pathBuffer;
+    }
+
+    // Nodes expanded by the last search, both directions together
+    uint64_t expandedCount() const { return side[FORWARD].expanded + side[BACKWARD].expanded; }
+    uint64_t expandedForward() const { return side[FORWARD].expanded; }
+    uint64_t expandedBackward() const { return side[BACKWARD].expanded; }
+
+private:
+    enum Direction { FORWARD = 0, BACKWARD = 1 };
+
+    // Labels of one search direction. gScore and stamp are read by the
+    // other direction; everything else is only touched by the owner.
+    struct Side {
+        std::unique_ptr<std::atomic<double>[]> gScore;
+        std::unique_ptr<std::atomic<uint32_t>[]> stamp;
+        std::vector<NodeId> parent;
+        IndexedDaryHeap<4> open;
+        std::atomic<double> top; // smallest key still queued, for the other thread
+        std::atomic<bool> done;
+        uint64_t expanded;
+    };
+
+    void prepare(const CsrGraph& g, NodeId startNode, NodeId goalNode) {
+        NodeId n = g.numNodes();
+        if (capacity < n) {
+            for (int d = 0; d < 2; d++) {
+                side[d].gScore.reset(new std::atomic<double>[n]);
+                side[d].stamp.reset(new std::atomic<uint32_t>[n]);
+                for (NodeId u = 0; u < n; u++) side[d].stamp[u].store(0, std::memory_order_relaxed);
+                side[d].parent.resize(n);
+            }
+            capacity = n;
+            generation = 0;
+        }
+        generation++;
+        if (generation == 0) {
+            for (int d = 0; d < 2; d++) {
+                for (NodeId u = 0; u < capacity; u++) side[d].stamp[u].store(0, std::memory_order_relaxed);
+            }
+            generation = 1;
+        }
+
+        start = startNode;
+        goal = goalNode;
+        meeting = INVALID_NODE;
+        bestCost.store(INFINITE_COST);
+        graphX = g.xData();
+        graphY = g.yData();
+        pathBuffer.clear();
+
+        NodeId roots[2] = {startNode, goalNode};
+        for (int d = 0; d < 2; d++) {
+            side[d].open.reset(n);
+            side[d].expanded = 0;
+            side[d].done.store(false);
+            label((Direction)d, roots[d], 0, INVALID_NODE, std::memory_order_relaxed);
+            double key = potential((Direction)d, roots[d]);
+            side[d].open.push(roots[d], key);
+            side[d].top.store(key);
+        }
+    }
+
+    // Potential of v for one direction; the two always sum to zero
+    double potential(Direction d, NodeId v) const {
+        double toGoal = distance(v, goal);
+        double fromStart = distance(start, v);
+        double pf = (toGoal - fromStart) / 2;
+        return d == FORWARD ? pf : -pf;
+    }
+
+    double distance(NodeId a, NodeId b) const {
+        double dx = graphX[b] - graphX[a];
+        double dy = graphY[b] - graphY[a];
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    double labelOf(Direction d, NodeId v, std::memory_order order) const {
+        if (side[d].stamp[v].load(order) != generation) return INFINITE_COST;
+        return side[d].gScore[v].load(order);
+    }
+
+    void label(Direction d, NodeId v, double cost, NodeId from, std::memory_order order) {
+        Side& s = side[d];
+        bool fresh = s.stamp[v].load(std::memory_order_relaxed) != generation;
+        s.gScore[v].store(cost, order);
+        if (fresh) s.stamp[v].store(generation, order);
+        s.parent[v] = from;
+    }
+
+    void offerMeeting(NodeId v, double cost, bool parallel) {
+        if (parallel) {
+            std::lock_guard<std::mutex> lock(meetingMutex);
+            if (cost < bestCost.load()) {
+                bestCost.store(cost);
+                meeting = v;
+            }
+        } else if (cost < bestCost.load(std::memory_order_relaxed)) {
+            bestCost.store(cost, std::memory_order_relaxed);
+            meeting = v;
+        }
+    }
+
+    // Pop and expand one node of direction d
+    template <class View>
+    void expand(const View& view, Direction d, std::memory_order order) {
+        Side& s = side[d];
+        Direction other = d == FORWARD ? BACKWARD : FORWARD;
+        bool parallel = order != std::memory_order_relaxed;
+
+        NodeId current = s.open.pop();
+        s.expanded++;
+
+        double currentG = s.gScore[current].load(std::memory_order_relaxed);
+        for (EdgeId e = view.edgeBegin(current); e < view.edgeEnd(current); e++) {
+            NodeId neighbor = view.target(e);
+            double tentative = currentG + view.weight(e);
+            if (tentative < labelOf(d, neighbor, std::memory_order_relaxed)) {
+                label(d, neighbor, tentative, current, order);
+                s.open.push(neighbor, tentative + potential(d, neighbor));
+
+                double across = labelOf(other, neighbor, order);
+                if (across != INFINITE_COST) offerMeeting(neighbor, tentative + across, parallel);
+            }
+        }
+    }
+
+    // Thread body for one direction in parallel mode
+    template <class View>
+    void runSide(const View& view, Direction d) {
+        Side& s = side[d];
+        Side& o = side[d == FORWARD ? BACKWARD : FORWARD];
+        while (!s.open.empty() && !o.done.load()) {
+            double top = s.open.topKey();
+            s.top.store(top);
+            if (top + o.top.load() >= bestCost.load()) break;
+            expand(view, d, std::memory_order_seq_cst);
+        }
+        s.done.store(true);
+    }
+
+    NodeId capacity;
+    uint32_t generation;
+    Side side[2];
+    NodeId start, goal, meeting;
+    std::atomic<double> bestCost;
+    std::mutex meetingMutex;
+    const double* graphX;
+    const double* graphY;
+    std::vector<NodeId> pathBuffer;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef COMPACT_GRAPH_H
+#define COMPACT_GRAPH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "csr_graph.h"
+
+// How a weight of type Weight is stored and read back. unit is the cost
+// of one step of a fixed-point type. Weights are rounded up, never down.
+template <class Weight>
+struct WeightEncoding;
+
+template <>
+struct WeightEncoding<float> {
+    static float encode(double w, double) {
+        float f = (float)w;
+        if ((double)f < w) f = std::nextafter(f, std::numeric_limits<float>::infinity());
+        return f;
+    }
+    static double decode(float w, double) { return w; }
+};
+
+// Fixed point; the largest value stands for an infinite (removed) edge
+template <>
+struct WeightEncoding<uint32_t> {
+    static const uint32_t INFINITE = UINT32_MAX;
+
+    static uint32_t encode(double w, double unit) {
+        double steps = std::ceil(w / unit);
+        return steps >= (double)INFINITE ? INFINITE : (uint32_t)steps;
+    }
+    static double decode(uint32_t w, double unit) {
+        return w == INFINITE ? std::numeric_limits<double>::infinity() : w * unit;
+    }
+};
+
+const uint32_t WeightEncoding<uint32_t>::INFINITE;
+
+// A CsrGraph's topology and coordinates with its own copy of the edge
+// weights stored as Weight (float, or uint32_t fixed point) instead of
+// double, halving the weight array. Rounding up keeps every weight at
+// least its original value, so coordinate heuristics stay admissible;
+// path costs come out slightly high. A graph view for AStar.
+template <class Weight>
+class CompactWeightGraph {
+public:
+    // unit is the fixed-point step; 0 spreads the largest finite weight
+    // over the whole range of Weight. Ignored for float.
+    explicit CompactWeightGraph(const CsrGraph& graph, double unit = 0) : base(graph), step(unit) {
+        if (step <= 0) {
+            double largest = 0;
+            for (EdgeId e = 0; e < graph.numEdges(); e++) {
+                if (graph.weight(e) != std::numeric_limits<double>::infinity()) {
+                    largest = std::max(largest, graph.weight(e));
+                }
+            }
+            step = largest > 0 ? largest / ((double)std::numeric_limits<Weight>::max() - 1) : 1;
+        }
+        weights.resize(graph.numEdges());
+        for (EdgeId e = 0; e < graph.numEdges(); e++) {
+            weights[e] = WeightEncoding<Weight>::encode(graph.weight(e), step);
+        }
+    }
+
+    NodeId numNodes() const { return base.numNodes(); }
+    EdgeId numEdges() const { return base.numEdges(); }
+    EdgeId edgeBegin(NodeId u) const { return base.edgeBegin(u); }
+    EdgeId edgeEnd(NodeId u) const { return base.edgeEnd(u); }
+    NodeId target(EdgeId e) const { return base.target(e); }
+    double weight(EdgeId e) const { return WeightEncoding<Weight>::decode(weights[e], step); }
+    double x(NodeId u) const { return base.x(u); }
+    double y(NodeId u) const { return base.y(u); }
+
+    // The full-precision graph, e.g. for building coordinate heuristics
+    const CsrGraph& graph() const { return base; }
+    double unit() const { return step; }
+    size_t weightBytes() const { return weights.capacity() * sizeof(Weight); }
+
+private:
+    CsrGraph base;
+    double step;
+    std::vector<Weight> weights;
+};
+
+#endif
@@ -0,0 +1,540 @@
+#ifndef CONTRACTION_HIERARCHY_H
+#define CONTRACTION_HIERARCHY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "csr_graph.h"
+#include "search_context.h"
+#include "open_list.h"
+#include "parallel.h"
+
+// Arc of the hierarchy. For a shortcut, middle is the contracted node it
+// bypasses; original edges have middle == INVALID_NODE.
+struct ChArc {
+    NodeId other;
+    NodeId middle;
+    double weight;
+};
+
+// Contraction Hierarchy over a frozen CsrGraph.
+// Nodes are contracted in order of edge difference (shortcuts added minus
+// edges removed, plus the number of already contracted neighbours). Each
+// round contracts a set of nodes with no two of them adjacent: their
+// witness searches run in parallel and ignore every node of the round, so
+// one round's contractions never rely on each other.
+//
+// Every arc is stored at its lower-ranked endpoint:
+//   up(v)   arcs v -> u with rank(u) > rank(v)
+//   down(v) arcs u -> v with rank(u) > rank(v), stored as (other = u)
+// so the forward query only walks up(), the backward query only down().
+class ContractionHierarchy {
+public:
+    ContractionHierarchy() : fingerprint(0), shortcuts(0), upOffsets(1, 0), downOffsets(1, 0) {}
+
+    bool empty() const { return rank.empty(); }
+    NodeId numNodes() const { return (NodeId)rank.size(); }
+    size_t numArcs() const { return upArcs.size() + downArcs.size(); }
+    uint64_t numShortcuts() const { return shortcuts; }
+    uint32_t rankOf(NodeId v) const { return rank[v]; }
+
+    uint32_t upBegin(NodeId v) const { return upOffsets[v]; }
+    uint32_t upEnd(NodeId v) const { return upOffsets[v + 1]; }
+    const ChArc& upArc(uint32_t a) const { return upArcs[a]; }
+    uint32_t downBegin(NodeId v) const { return downOffsets[v]; }
+    uint32_t downEnd(NodeId v) const { return downOffsets[v + 1]; }
+    const ChArc& downArc(uint32_t a) const { return downArcs[a]; }
+
+    // True if the hierarchy was built for exactly this graph
+    bool matches(const CsrGraph& g) const {
+        return !empty() && numNodes() == g.numNodes() && fingerprint == graphFingerprint(g);
+    }
+
+    // Contract every node of g using up to threads workers (0 = all cores)
+    void build(const CsrGraph& g, unsigned threads = 0) {
+        NodeId n = g.numNodes();
+        fingerprint = graphFingerprint(g);
+        shortcuts = 0;
+        if (threads == 0) threads = defaultThreadCount();
+
+        Contraction work(n, threads);
+        for (NodeId u = 0; u < n; u++) {
+            for (EdgeId e = g.edgeBegin(u); e < g.edgeEnd(u); e++) {
+                if (g.target(e) != u) work.addArc(u, g.target(e), g.weight(e), INVALID_NODE);
+            }
+        }
+        work.run();
+
+        rank.swap(work.rank);
+        shortcuts = work.shortcuts;
+        toCsr(work.up, upOffsets, upArcs);
+        toCsr(work.down, downOffsets, downArcs);
+    }
+
+    // Binary file: header, ranks, then the up and down CSR arrays
+    bool save(const std::string& path, std::string& error) const {
+        std::ofstream out(path.c_str(), std::ios::binary);
+        if (!out) {
+            error = "cannot open " + path + " for writing";
+            return false;
+        }
+        uint32_t header[5] = {FILE_MAGIC, FILE_VERSION, numNodes(), (uint32_t)upArcs.size(), (uint32_t)downArcs.size()};
+        out.write((const char*)header, sizeof(header));
+        out.write((const char*)&fingerprint, sizeof(fingerprint));
+        out.write((const char*)&shortcuts, sizeof(shortcuts));
+        out.write((const char*)rank.data(), rank.size() * sizeof(uint32_t));
+        out.write((const char*)upOffsets.data(), upOffsets.size() * sizeof(uint32_t));
+        out.write((const char*)upArcs.data(), upArcs.size() * sizeof(ChArc));
+        out.write((const char*)downOffsets.data(), downOffsets.size() * sizeof(uint32_t));
+        out.write((const char*)downArcs.data(), downArcs.size() * sizeof(ChArc));
+        if (!out) {
+            error = "write to " + path + " failed";
+            return false;
+        }
+        return true;
+    }
+
+    // Load a hierarchy saved by save(); fails if it was built for another graph
+    bool load(const std::string& path, const CsrGraph& g, std::string& error) {
+        std::ifstream in(path.c_str(), std::ios::binary);
+        if (!in) {
+            error = "cannot open " + path;
+            return false;
+        }
+        uint32_t header[5];
+        uint64_t fileFingerprint = 0, fileShortcuts = 0;
+        in.read((char*)header, sizeof(header));
+        in.read((char*)&fileFingerprint, sizeof(fileFingerprint));
+        in.read((char*)&fileShortcuts, sizeof(fileShortcuts));
+        if (!in || header[0] != FILE_MAGIC || header[1] != FILE_VERSION) {
+            error = path + " is not a contraction hierarchy";
+            return false;
+        }
+        if (header[2] != g.numNodes() || fileFingerprint != graphFingerprint(g)) {
+            error = path + " was built for a different graph version";
+            return false;
+        }
+
+        rank.resize(header[2]);
+        upOffsets.resize(header[2] + 1);
+        upArcs.resize(header[3]);
+        downOffsets.resize(header[2] + 1);
+        downArcs.resize(header[4]);
+        in.read((char*)rank.data(), rank.size() * sizeof(uint32_t));
+        in.read((char*)upOffsets.data(), upOffsets.size() * sizeof(uint32_t));
+        in.read((char*)upArcs.data(), upArcs.size() * sizeof(ChArc));
+        in.read((char*)downOffsets.data(), downOffsets.size() * sizeof(uint32_t));
+        in.read((char*)downArcs.data(), downArcs.size() * sizeof(ChArc));
+        if (!in || upOffsets.back() != upArcs.size() || downOffsets.back() != downArcs.size()) {
+            error = path + " is truncated";
+            *this = ContractionHierarchy();
+            return false;
+        }
+        fingerprint = fileFingerprint;
+        shortcuts = fileShortcuts;
+        return true;
+    }
+
+private:
+    static const uint32_t FILE_MAGIC = 0x31424843; // "CHB1" little-endian
+    static const uint32_t FILE_VERSION = 1;
+
+    // Mutable graph and bookkeeping used while contracting
+    struct Contraction {
+        // Witness searches give up after settling this many nodes; a
+        // missing witness only costs an unnecessary shortcut. Estimating
+        // priorities uses a cheaper search than the real contraction.
+        static const uint32_t WITNESS_SETTLE_LIMIT = 500;
+        static const uint32_t PRIORITY_SETTLE_LIMIT = 50;
+
+        struct Shortcut {
+            NodeId from, to;
+            double weight;
+        };
+
+        NodeId n;
+        unsigned threads;
+        std::vector<std::vector<ChArc> > out, in; // arcs between uncontracted nodes
+        std::vector<std::vector<ChArc> > up, down; // final arcs of contracted nodes
+        std::vector<int> priority;
+        std::vector<uint32_t> deletedNeighbors;
+        std::vector<uint32_t> rank;
+        std::vector<char> inRound, contracted;
+        std::vector<SearchContext> contexts; // one per worker
+        uint64_t shortcuts;
+
+        Contraction(NodeId nodes, unsigned workerCount)
+            : n(nodes), threads(workerCount), out(nodes), in(nodes), up(nodes), down(nodes),
+              priority(nodes, 0), deletedNeighbors(nodes, 0), rank(nodes, 0), inRound(nodes, 0),
+              contracted(nodes, 0), contexts(workerCount), shortcuts(0) {}
+
+        // Insert from -> to, keeping only the lighter of parallel arcs
+        void addArc(NodeId from, NodeId to, double weight, NodeId middle) {
+            std::vector<ChArc>& arcs = out[from];
+            for (size_t i = 0; i < arcs.size(); i++) {
+                if (arcs[i].other != to) continue;
+                if (weight < arcs[i].weight) {
+                    arcs[i].weight = weight;
+                    arcs[i].middle = middle;
+                    std::vector<ChArc>& back = in[to];
+                    for (size_t j = 0; j < back.size(); j++) {
+                        if (back[j].other == from) {
+                            back[j].weight = weight;
+                            back[j].middle = middle;
+                        }
+                    }
+                }
+                return;
+            }
+            ChArc forward = {to, middle, weight};
+            ChArc backward = {from, middle, weight};
+            arcs.push_back(forward);
+            in[to].push_back(backward);
+        }
+
+        static void removeArc(std::vector<ChArc>& arcs, NodeId other) {
+            for (size_t i = 0; i < arcs.size(); i++) {
+                if (arcs[i].other == other) {
+                    arcs[i] = arcs.back();
+                    arcs.pop_back();
+                    return;
+                }
+            }
+        }
+
+        // Bounded Dijkstra from u that avoids v and every node of the
+        // current round. Stops as soon as every out-neighbour w of v is
+        // reached within toV + weight(v, w), i.e. has a witness; ctx.g()
+        // then holds upper bounds on the distances from u.
+        void witnessSearch(SearchContext& ctx, NodeId u, NodeId v, double toV, double limit, uint32_t settleLimit) {
+            IndexedDaryHeap<4>& open = ctx.quaternaryHeap;
+            ctx.reset(n);
+            open.reset(n);
+            ctx.setG(u, 0, INVALID_NODE);
+            open.push(u, 0);
+            uint32_t settled = 0;
+            while (!open.empty() && open.topKey() <= limit && settled++ < settleLimit) {
+                NodeId current = open.pop();
+                double currentG = ctx.g(current);
+                for (size_t i = 0; i < out[current].size(); i++) {
+                    const ChArc& arc = out[current][i];
+                    if (arc.other == v || inRound[arc.other]) continue;
+                    double tentative = currentG + arc.weight;
+                    if (tentative < ctx.g(arc.other) && tentative <= limit) {
+                        ctx.setG(arc.other, tentative, current);
+                        open.push(arc.other, tentative);
+                    }
+                }
+                if (allWitnessed(ctx, u, v, toV)) return;
+            }
+        }
+
+        bool allWitnessed(const SearchContext& ctx, NodeId u, NodeId v, double toV) const {
+            for (size_t j = 0; j < out[v].size(); j++) {
+                NodeId w = out[v][j].other;
+                if (w != u && ctx.g(w) > toV + out[v][j].weight) return false;
+            }
+            return true;
+        }
+
+        // Shortcuts needed to contract v, passed to visit(from, to, weight)
+        template <class Visit>
+        void findShortcuts(SearchContext& ctx, NodeId v, uint32_t settleLimit, Visit visit) {
+            for (size_t i = 0; i < in[v].size(); i++) {
+                NodeId u = in[v][i].other;
+                double toV = in[v][i].weight;
+                double maxOut = -1;
+                for (size_t j = 0; j < out[v].size(); j++) {
+                    if (out[v][j].other != u) maxOut = std::max(maxOut, out[v][j].weight);
+                }
+                if (maxOut < 0) continue; // no neighbour to connect u to
+
+                witnessSearch(ctx, u, v, toV, toV + maxOut, settleLimit);
+                for (size_t j = 0; j < out[v].size(); j++) {
+                    NodeId w = out[v][j].other;
+                    double via = toV + out[v][j].weight;
+                    if (w != u && ctx.g(w) > via) visit(u, w, via);
+                }
+            }
+        }
+
+        void updatePriority(SearchContext& ctx, NodeId v) {
+            int added = 0;
+            findShortcuts(ctx, v, PRIORITY_SETTLE_LIMIT, [&added](NodeId, NodeId, double) { added++; });
+            priority[v] = added - (int)(in[v].size() + out[v].size()) + (int)deletedNeighbors[v];
+        }
+
+        // Contraction order: lower priority first, ties by id
+        bool before(NodeId a, NodeId b) const {
+            return priority[a] < priority[b] || (priority[a] == priority[b] && a < b);
+        }
+
+        bool isLocalMinimum(NodeId v) const {
+            for (size_t i = 0; i < out[v].size(); i++) {
+                if (!before(v, out[v][i].other)) return false;
+            }
+            for (size_t i = 0; i < in[v].size(); i++) {
+                if (!before(v, in[v][i].other)) return false;
+            }
+            return true;
+        }
+
+        void run() {
+            std::vector<NodeId> remaining(n);
+            for (NodeId v = 0; v < n; v++) remaining[v] = v;
+            parallelFor(n, threads, [this](size_t v, unsigned w) { updatePriority(contexts[w], (NodeId)v); }, 64);
+
+            std::vector<NodeId> round, touched;
+            std::vector<std::vector<Shortcut> > found;
+            std::vector<char> isTouched(n, 0);
+            uint32_t nextRank = 0;
+            while (!remaining.empty()) {
+                // Independent set: nodes that come before all their neighbours
+                round.clear();
+                for (size_t i = 0; i < remaining.size(); i++) {
+                    if (isLocalMinimum(remaining[i])) round.push_back(remaining[i]);
+                }
+                for (size_t i = 0; i < round.size(); i++) inRound[round[i]] = 1;
+
+                // Witness searches of the whole round in parallel
+                found.resize(round.size());
+                parallelFor(round.size(), threads, [this, &round, &found](size_t i, unsigned w) {
+                    found[i].clear();
+                    std::vector<Shortcut>& list = found[i];
+                    findShortcuts(contexts[w], round[i], WITNESS_SETTLE_LIMIT, [&list](NodeId from, NodeId to, double weight) {
+                        Shortcut s = {from, to, weight};
+                        list.push_back(s);
+                    });
+                }, 16);
+
+                // Apply the contractions; cheap compared to the searches
+                touched.clear();
+                for (size_t i = 0; i < round.size(); i++) {
+                    NodeId v = round[i];
+                    rank[v] = nextRank++;
+                    contracted[v] = 1;
+                    for (size_t j = 0; j < out[v].size(); j++) {
+                        NodeId w = out[v][j].other;
+                        removeArc(in[w], v);
+                        deletedNeighbors[w]++;
+                        if (!isTouched[w]) touched.push_back(w);
+                        isTouched[w] = 1;
+                    }
+                    for (size_t j = 0; j < in[v].size(); j++) {
+                        NodeId u = in[v][j].other;
+                        removeArc(out[u], v);
+                        deletedNeighbors[u]++;
+                        if (!isTouched[u]) touched.push_back(u);
+                        isTouched[u] = 1;
+                    }
+                    for (size_t j = 0; j < found[i].size(); j++) {
+                        addArc(found[i][j].from, found[i][j].to, found[i][j].weight, v);
+                    }
+                    shortcuts += found[i].size();
+                    up[v].swap(out[v]);
+                    down[v].swap(in[v]);
+                    std::vector<ChArc>().swap(out[v]);
+                    std::vector<ChArc>().swap(in[v]);
+                }
+                for (size_t i = 0; i < round.size(); i++) inRound[round[i]] = 0;
+
+                // Re-evaluate the neighbours whose edges changed
+                parallelFor(touched.size(), threads, [this, &touched](size_t i, unsigned w) {
+                    updatePriority(contexts[w], touched[i]);
+                }, 64);
+                for (size_t i = 0; i < touched.size(); i++) isTouched[touched[i]] = 0;
+
+                size_t kept = 0;
+                for (size_t i = 0; i < remaining.size(); i++) {
+                    if (!contracted[remaining[i]]) remaining[kept++] = remaining[i];
+                }
+                remaining.resize(kept);
+            }
+        }
+    };
+
+    static void toCsr(const std::vector<std::vector<ChArc> >& lists, std::vector<uint32_t>& offsets,
+                      std::vector<ChArc>& arcs) {
+        offsets.assign(lists.size() + 1, 0);
+        for (size_t v = 0; v < lists.size(); v++) offsets[v + 1] = offsets[v] + (uint32_t)lists[v].size();
+        arcs.resize(offsets.back());
+        for (size_t v = 0; v < lists.size(); v++) {
+            std::copy(lists[v].begin(), lists[v].end(), arcs.begin() + offsets[v]);
+        }
+    }
+
+    uint64_t fingerprint;
+    uint64_t shortcuts;
+    std::vector<uint32_t> rank;
+    std::vector<uint32_t> upOffsets;
+    std::vector<ChArc> upArcs;
+    std::vector<uint32_t> downOffsets;
+    std::vector<ChArc> downArcs;
+};
+
+const uint32_t ContractionHierarchy::FILE_MAGIC;
+const uint32_t ContractionHierarchy::FILE_VERSION;
+const uint32_t ContractionHierarchy::Contraction::WITNESS_SETTLE_LIMIT;
+const uint32_t ContractionHierarchy::Contraction::PRIORITY_SETTLE_LIMIT;
+
+// Point-to-point query on a ContractionHierarchy: forward search from the
+// start over up() arcs and backward search from the goal over down() arcs,
+// both only ever climbing in rank. A node is stalled (settled but not
+// expanded) when a higher-ranked neighbour already reaches it more
+// cheaply, since then its label cannot lie on a shortest path.
+class ChQuery {
+public:
+    ChQuery() : start(INVALID_NODE), goal(INVALID_NODE), meeting(INVALID_NODE), bestCost(INFINITE_COST),
+                stalled(0) {}
+
+    // Returns the path cost or INFINITE_COST; buildPath() gives the nodes
+    double search(const ContractionHierarchy& ch, NodeId startNode, NodeId goalNode) {
+        NodeId roots[2] = {startNode, goalNode};
+        for (int d = 0; d < 2; d++) {
+            side[d].reset(ch.numNodes());
+            side[d].quaternaryHeap.reset(ch.numNodes());
+            side[d].setG(roots[d], 0, INVALID_NODE);
+            side[d].quaternaryHeap.push(roots[d], 0);
+        }
+        start = startNode;
+        goal = goalNode;
+        meeting = INVALID_NODE;
+        bestCost = INFINITE_COST;
+        stalled = 0;
+
+        // Each side stops once its smallest key reaches the best meeting cost
+        while (true) {
+            bool forward = canExpand(FORWARD), backward = canExpand(BACKWARD);
+            if (!forward && !backward) break;
+            Direction d = FORWARD;
+            if (!forward || (backward && side[BACKWARD].quaternaryHeap.topKey() < side[FORWARD].quaternaryHeap.topKey())) {
+                d = BACKWARD;
+            }
+            expand(ch, d);
+        }
+        return bestCost;
+    }
+
+    // Original node ids from start to goal with every shortcut unpacked
+    const std::vector<NodeId>& buildPath(const ContractionHierarchy& ch) {
+        pathBuffer.clear();
+        if (meeting == INVALID_NODE) return pathBuffer;
+
+        // Hierarchy nodes from start up to the meeting node and down to the goal
+        hops.clear();
+        for (NodeId v = meeting; v != INVALID_NODE; v = side[FORWARD].parentOf(v)) hops.push_back(v);
+        std::reverse(hops.begin(), hops.end());
+        for (NodeId v = side[BACKWARD].parentOf(meeting); v != INVALID_NODE; v = side[BACKWARD].parentOf(v)) {
+            hops.push_back(v);
+        }
+
+        pathBuffer.push_back(hops[0]);
+        for (size_t i = 0; i + 1 < hops.size(); i++) {
+            NodeId from = hops[i], to = hops[i + 1];
+            // The arc is stored at whichever endpoint has the lower rank
+            NodeId middle = ch.rankOf(from) < ch.rankOf(to) ? upMiddle(ch, from, to) : downMiddle(ch, to, from);
+            unpack(ch, from, to, middle);
+        }
+        return pathBuffer;
+    }
+
+    // Nodes settled by the last search (both sides, stalled ones included)
+    uint64_t expandedCount() const { return side[FORWARD].expandedCount() + side[BACKWARD].expandedCount(); }
+    uint64_t stalledCount() const { return stalled; }
+
+private:
+    enum Direction { FORWARD = 0, BACKWARD = 1 };
+
+    struct Segment {
+        NodeId from, to, middle;
+    };
+
+    bool canExpand(Direction d) const {
+        return !side[d].quaternaryHeap.empty() && side[d].quaternaryHeap.topKey() < bestCost;
+    }
+
+    void expand(const ContractionHierarchy& ch, Direction d) {
+        SearchContext& s = side[d];
+        const SearchContext& o = side[d == FORWARD ? BACKWARD : FORWARD];
+        NodeId v = s.quaternaryHeap.pop();
+        double dist = s.g(v);
+        s.countExpansion();
+
+        if (o.touched(v) && dist + o.g(v) < bestCost) {
+            bestCost = dist + o.g(v);
+            meeting = v;
+        }
+
+        // Stall-on-demand over the arcs coming from higher-ranked nodes
+        uint32_t begin = d == FORWARD ? ch.downBegin(v) : ch.upBegin(v);
+        uint32_t end = d == FORWARD ? ch.downEnd(v) : ch.upEnd(v);
+        for (uint32_t a = begin; a < end; a++) {
+            const ChArc& arc = d == FORWARD ? ch.downArc(a) : ch.upArc(a);
+            if (s.g(arc.other) + arc.weight < dist) {
+                stalled++;
+                return;
+            }
+        }
+
+        begin = d == FORWARD ? ch.upBegin(v) : ch.downBegin(v);
+        end = d == FORWARD ? ch.upEnd(v) : ch.downEnd(v);
+        for (uint32_t a = begin; a < end; a++) {
+            const ChArc& arc = d == FORWARD ? ch.upArc(a) : ch.downArc(a);
+            double tentative = dist + arc.weight;
+            if (tentative < s.g(arc.other)) {
+                s.setG(arc.other, tentative, v);
+                s.quaternaryHeap.push(arc.other, tentative);
+            }
+        }
+    }
+
+    // Middle node of arc from -> to stored in up(from)
+    static NodeId upMiddle(const ContractionHierarchy& ch, NodeId from, NodeId to) {
+        for (uint32_t a = ch.upBegin(from); a < ch.upEnd(from); a++) {
+            if (ch.upArc(a).other == to) return ch.upArc(a).middle;
+        }
+        return INVALID_NODE;
+    }
+
+    // Middle node of arc from -> to stored in down(to)
+    static NodeId downMiddle(const ContractionHierarchy& ch, NodeId to, NodeId from) {
+        for (uint32_t a = ch.downBegin(to); a < ch.downEnd(to); a++) {
+            if (ch.downArc(a).other == from) return ch.downArc(a).middle;
+        }
+        return INVALID_NODE;
+    }
+
+    // Append the original nodes after from on the arc from -> to. A
+    // shortcut via m splits into from -> m (stored in down(m)) and
+    // m -> to (stored in up(m)); an explicit stack keeps deep nesting safe.
+    void unpack(const ContractionHierarchy& ch, NodeId from, NodeId to, NodeId middle) {
+        Segment first = {from, to, middle};
+        stack.clear();
+        stack.push_back(first);
+        while (!stack.empty()) {
+            Segment seg = stack.back();
+            stack.pop_back();
+            if (seg.middle == INVALID_NODE) {
+                pathBuffer.push_back(seg.to);
+                continue;
+            }
+            Segment second = {seg.middle, seg.to, upMiddle(ch, seg.middle, seg.to)};
+            Segment head = {seg.from, seg.middle, downMiddle(ch, seg.middle, seg.from)};
+            stack.push_back(second);
+            stack.push_back(head);
+        }
+    }
+
+    SearchContext side[2];
+    NodeId start, goal, meeting;
+    double bestCost;
+    uint64_t stalled;
+    std::vector<NodeId> hops;
+    std::vector<Segment> stack;
+    std::vector<NodeId> pathBuffer;
+};
+
+#endif
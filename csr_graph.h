@@ -0,0 +1,583 @@
+#ifndef CSR_GRAPH_H
+#define CSR_GRAPH_H
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <memory>
+
+#include "parallel.h"
+#include "arena.h"
+
+// Dense node and edge identifiers used by the search engines
+typedef uint32_t NodeId;
+typedef uint32_t EdgeId;
+
+const NodeId INVALID_NODE = 0xFFFFFFFFu;
+
+// Arrays behind a CsrGraph built in memory by CsrBuilder
+struct CsrStorage {
+    std::vector<EdgeId> offsets;       // numNodes + 1 entries
+    std::vector<NodeId> targets;       // numEdges entries
+    std::vector<double> weights;       // numEdges entries
+    std::vector<EdgeId> inOffsets;     // numNodes + 1 entries
+    std::vector<NodeId> inSources;     // numEdges entries
+    std::vector<EdgeId> inEdges;       // forward edge id of each incoming edge
+    std::vector<double> xs, ys;        // coordinates for the heuristic
+    std::vector<char> namePool;        // all names back to back
+    std::vector<uint32_t> nameOffsets; // numNodes + 1 entries into namePool
+    std::vector<NodeId> nameIndex;     // node ids sorted by name
+};
+
+// Raw array pointers and sizes of a frozen graph, wherever they live
+struct CsrArrays {
+    NodeId numNodes;
+    EdgeId numEdges;
+    const EdgeId* offsets;
+    const NodeId* targets;
+    const double* weights;
+    const EdgeId* inOffsets;
+    const NodeId* inSources;
+    const EdgeId* inEdges;
+    const double* xs;
+    const double* ys;
+    const char* namePool;
+    const uint32_t* nameOffsets;
+    const NodeId* nameIndex;
+};
+
+// Frozen, read-only graph in compressed-sparse-row form.
+// The outgoing edges of node u are [edgeBegin(u), edgeEnd(u)) in the
+// contiguous target/weight arrays. Incoming edges are kept in a second
+// CSR, [inBegin(u), inEnd(u)), for searches that run backwards. Names are
+// only needed at the API boundary, so they live in a single string pool
+// with a sorted index.
+//
+// The graph only holds pointers into its arrays plus a shared owner of
+// the memory behind them: either a CsrStorage from CsrBuilder or a
+// memory-mapped graph file (graph_file.h). Copies share the same arrays.
+class CsrGraph {
+public:
+    CsrGraph() {
+        std::shared_ptr<CsrStorage> storage = std::make_shared<CsrStorage>();
+        storage->offsets.assign(1, 0);
+        storage->inOffsets.assign(1, 0);
+        storage->nameOffsets.assign(1, 0);
+        adopt(storage);
+    }
+
+    // View arrays owned by backing (kept alive as long as any copy exists)
+    CsrGraph(const CsrArrays& arrays, const std::shared_ptr<const void>& backing)
+        : a(arrays), owner(backing), mutableWeights(nullptr) {}
+
+    NodeId numNodes() const { return a.numNodes; }
+    EdgeId numEdges() const { return a.numEdges; }
+
+    EdgeId edgeBegin(NodeId u) const { return a.offsets[u]; }
+    EdgeId edgeEnd(NodeId u) const { return a.offsets[u + 1]; }
+    NodeId target(EdgeId e) const { return a.targets[e]; }
+    double weight(EdgeId e) const { return a.weights[e]; }
+
+    // Incoming edges: source(e) -> u, stored as the id of the forward edge
+    EdgeId inBegin(NodeId u) const { return a.inOffsets[u]; }
+    EdgeId inEnd(NodeId u) const { return a.inOffsets[u + 1]; }
+    NodeId source(EdgeId e) const { return a.inSources[e]; }
+    EdgeId forwardEdge(EdgeId e) const { return a.inEdges[e]; }
+    double inWeight(EdgeId e) const { return a.weights[a.inEdges[e]]; }
+
+    double x(NodeId u) const { return a.xs[u]; }
+    double y(NodeId u) const { return a.ys[u]; }
+
+    // Raw array access for tight loops
+    const EdgeId* offsetData() const { return a.offsets; }
+    const NodeId* targetData() const { return a.targets; }
+    const double* weightData() const { return a.weights; }
+    const double* xData() const { return a.xs; }
+    const double* yData() const { return a.ys; }
+
+    // Weights of graphs built in memory can change in place; copies share
+    // the arrays and see the change. Mapped graph files are read-only.
+    bool weightsMutable() const { return mutableWeights != nullptr; }
+    void setWeight(EdgeId e, double w) { mutableWeights[e] = w; }
+
+    // Copy of this graph with its own weight array (numEdges entries);
+    // every other array stays shared
+    CsrGraph withWeights(const std::vector<double>& weights) const {
+        struct Backing {
+            std::shared_ptr<const void> base;
+            std::vector<double> weights;
+        };
+        std::shared_ptr<Backing> backing = std::make_shared<Backing>();
+        backing->base = owner;
+        backing->weights = weights;
+        CsrArrays arrays = a;
+        arrays.weights = backing->weights.data();
+        return CsrGraph(arrays, backing);
+    }
+
+    // Copy of this graph whose weights are its own and can change in
+    // place without reaching any other copy
+    CsrGraph withPrivateWeights() const {
+        CsrGraph copy = withWeights(std::vector<double>(a.weights, a.weights + a.numEdges));
+        copy.mutableWeights = const_cast<double*>(copy.a.weights); // owned by copy's backing
+        return copy;
+    }
+
+    // All array pointers at once, e.g. for writing a graph file
+    const CsrArrays& arrays() const { return a; }
+    uint32_t namePoolSize() const { return a.nameOffsets[a.numNodes]; }
+
+    // Bytes of the per-edge arrays: target, weight and the reverse CSR entry
+    size_t edgeBytes() const {
+        return (size_t)a.numEdges * (sizeof(NodeId) + sizeof(double) + sizeof(NodeId) + sizeof(EdgeId));
+    }
+
+    // Bytes of all arrays, whether in memory or mapped from a file
+    size_t memoryBytes() const {
+        size_t perNode = 2 * sizeof(EdgeId) + 2 * sizeof(double) + sizeof(uint32_t) + sizeof(NodeId);
+        return edgeBytes() + (size_t)a.numNodes * perNode + 2 * sizeof(EdgeId) + sizeof(uint32_t) + namePoolSize();
+    }
+
+    // Name of a node (allocates; use at the API boundary only)
+    std::string name(NodeId u) const {
+        return std::string(nameData(u), nameLength(u));
+    }
+
+    const char* nameData(NodeId u) const { return a.namePool + a.nameOffsets[u]; }
+    uint32_t nameLength(NodeId u) const { return a.nameOffsets[u + 1] - a.nameOffsets[u]; }
+
+    // Look up a node by name, INVALID_NODE if it doesn't exist
+    NodeId findNode(const std::string& nodeName) const {
+        size_t lo = 0, hi = a.numNodes;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (compareName(a.nameIndex[mid], nodeName) < 0) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo < a.numNodes && compareName(a.nameIndex[lo], nodeName) == 0) {
+            return a.nameIndex[lo];
+        }
+        return INVALID_NODE;
+    }
+
+    // Edge id of u -> v with the smallest weight, or numEdges() if none
+    EdgeId findEdge(NodeId u, NodeId v) const {
+        EdgeId best = numEdges();
+        for (EdgeId e = edgeBegin(u); e < edgeEnd(u); e++) {
+            if (a.targets[e] == v && (best == numEdges() || a.weights[e] < a.weights[best])) {
+                best = e;
+            }
+        }
+        return best;
+    }
+
+private:
+    friend class CsrBuilder;
+
+    // Point the views at arrays built in memory
+    void adopt(const std::shared_ptr<CsrStorage>& storage) {
+        a.numNodes = (NodeId)storage->xs.size();
+        a.numEdges = (EdgeId)storage->targets.size();
+        a.offsets = storage->offsets.data();
+        a.targets = storage->targets.data();
+        a.weights = storage->weights.data();
+        a.inOffsets = storage->inOffsets.data();
+        a.inSources = storage->inSources.data();
+        a.inEdges = storage->inEdges.data();
+        a.xs = storage->xs.data();
+        a.ys = storage->ys.data();
+        a.namePool = storage->namePool.data();
+        a.nameOffsets = storage->nameOffsets.data();
+        a.nameIndex = storage->nameIndex.data();
+        owner = storage;
+        mutableWeights = storage->weights.data();
+    }
+
+    int compareName(NodeId u, const std::string& other) const {
+        uint32_t len = nameLength(u);
+        size_t common = std::min<size_t>(len, other.size());
+        int cmp = std::memcmp(nameData(u), other.data(), common);
+        if (cmp != 0) return cmp;
+        if (len == other.size()) return 0;
+        return len < other.size() ? -1 : 1;
+    }
+
+    CsrArrays a;
+    std::shared_ptr<const void> owner;
+    double* mutableWeights; // same array as a.weights when owned, else null
+};
+
+// Adapter that presents the incoming edges of a CsrGraph through the same
+// interface as the outgoing ones, so searches can run backwards unchanged
+class ReverseView {
+public:
+    explicit ReverseView(const CsrGraph& graph) : g(graph) {}
+
+    NodeId numNodes() const { return g.numNodes(); }
+    EdgeId edgeBegin(NodeId u) const { return g.inBegin(u); }
+    EdgeId edgeEnd(NodeId u) const { return g.inEnd(u); }
+    NodeId target(EdgeId e) const { return g.source(e); }
+    double weight(EdgeId e) const { return g.inWeight(e); }
+    double x(NodeId u) const { return g.x(u); }
+    double y(NodeId u) const { return g.y(u); }
+
+private:
+    const CsrGraph& g;
+};
+
+// 64-bit FNV-1a over the CSR arrays. Preprocessed data saved to disk
+// stores it so files built for a different graph version are rejected.
+inline uint64_t graphFingerprint(const CsrGraph& g) {
+    uint64_t hash = 1469598103934665603ULL;
+    const uint64_t prime = 1099511628211ULL;
+    uint32_t counts[2] = {g.numNodes(), g.numEdges()};
+    const unsigned char* parts[4] = {
+        (const unsigned char*)counts,
+        (const unsigned char*)g.offsetData(),
+        (const unsigned char*)g.targetData(),
+        (const unsigned char*)g.weightData()
+    };
+    size_t sizes[4] = {
+        sizeof(counts),
+        ((size_t)g.numNodes() + 1) * sizeof(EdgeId),
+        (size_t)g.numEdges() * sizeof(NodeId),
+        (size_t)g.numEdges() * sizeof(double)
+    };
+    for (int p = 0; p < 4; p++) {
+        for (size_t i = 0; i < sizes[p]; i++) {
+            hash ^= parts[p][i];
+            hash *= prime;
+        }
+    }
+    return hash;
+}
+
+// First 8 bytes of a name as a big-endian integer, zero padded. Ordering
+// two keys orders the names unless the keys are equal.
+inline uint64_t namePrefixKey(const char* name, uint32_t length) {
+    uint64_t key = 0;
+    uint32_t bytes = std::min<uint32_t>(length, 8);
+    for (uint32_t i = 0; i < bytes; i++) key = key << 8 | (unsigned char)name[i];
+    return bytes == 0 ? 0 : key << (8 * (8 - bytes));
+}
+
+// Mutable builder behind Graph::addNode / addEdge.
+// Interns names to dense ids and collects edges until finalize(). Nodes
+// and edges are appended to blocks of a monotonic arena, so adding one
+// allocates nothing but the occasional block. Blocks and arena chunks
+// start small and double, so a small graph takes a few KiB. Names of up
+// to 8 bytes are kept inline and longer ones copied into the arena.
+// Names are found through an open-addressing table of node ids.
+class CsrBuilder {
+public:
+    CsrBuilder() : arena(new Arena(4 << 10, 1 << 20)), nodes(*arena), edges(*arena) {}
+
+    // Add a node or update the coordinates of an existing one
+    NodeId addNode(const std::string& name, double x, double y) {
+        if (slots.empty()) growSlots();
+        uint32_t hash = nameHash(name.data(), name.size());
+        size_t slot = findSlot(name.data(), (uint32_t)name.size(), hash);
+        if (slots[slot] != INVALID_NODE) {
+            nodes[slots[slot]].x = x;
+            nodes[slots[slot]].y = y;
+            return slots[slot];
+        }
+
+        NodeId id = (NodeId)nodes.size();
+        NodeRecord node;
+        node.length = (uint32_t)name.size();
+        node.hash = hash;
+        char* bytes = node.length <= INLINE_NAME ? node.inlineName : arena->allocateArray<char>(node.length);
+        std::memcpy(bytes, name.data(), node.length);
+        if (node.length > INLINE_NAME) node.pooledName = bytes;
+        node.x = x;
+        node.y = y;
+        nodes.push_back(node);
+        slots[slot] = id;
+        if (nodes.size() * 2 > slots.size()) growSlots();
+        return id;
+    }
+
+    NodeId findNode(const std::string& name) const {
+        if (slots.empty()) return INVALID_NODE;
+        return slots[findSlot(name.data(), (uint32_t)name.size(), nameHash(name.data(), name.size()))];
+    }
+
+    void addEdge(NodeId from, NodeId to, double weight) {
+        EdgeRecord edge = {from, to, weight};
+        edges.push_back(edge);
+    }
+
+    NodeId numNodes() const { return (NodeId)nodes.size(); }
+    size_t numEdges() const { return edges.size(); }
+
+    // Bytes held for nodes, names, edges and the name table
+    size_t memoryBytes() const { return arena->bytesReserved() + slots.capacity() * sizeof(NodeId); }
+
+    // Start over from the nodes and edges of a frozen graph, e.g. one
+    // loaded from a file, so it can be edited again. Removed edges
+    // (infinite weight) are dropped.
+    void assign(const CsrGraph& g) {
+        nodes.clear();
+        edges.clear();
+        slots.clear();
+        arena->reset();
+        for (NodeId u = 0; u < g.numNodes(); u++) {
+            addNode(g.name(u), g.x(u), g.y(u));
+        }
+        for (NodeId u = 0; u < g.numNodes(); u++) {
+            for (EdgeId e = g.edgeBegin(u); e < g.edgeEnd(u); e++) {
+                if (g.weight(e) != std::numeric_limits<double>::infinity()) addEdge(u, g.target(e), g.weight(e));
+            }
+        }
+    }
+
+    // Freeze into CSR with one counting-sort pass over the edges.
+    // Edges keep their insertion order within each source node.
+    CsrGraph finalize() const {
+        std::shared_ptr<CsrStorage> storage = std::make_shared<CsrStorage>();
+        CsrStorage& s = *storage;
+        NodeId n = numNodes();
+
+        s.xs.resize(n);
+        s.ys.resize(n);
+        s.nameOffsets.assign(1, 0);
+        s.nameOffsets.reserve(n + 1);
+        for (NodeId u = 0; u < n; u++) {
+            const NodeRecord& node = nodes[u];
+            s.xs[u] = node.x;
+            s.ys[u] = node.y;
+            s.namePool.insert(s.namePool.end(), node.name(), node.name() + node.length);
+            s.nameOffsets.push_back((uint32_t)s.namePool.size());
+        }
+
+        return assembleEdges(storage, EdgeListSource(edges), edges.size());
+    }
+
+    // Build the forward and reverse CSR and the name index for storage,
+    // whose coordinates and name pool are already filled in, from count
+    // edges given as parallel arrays. Shared with the bulk importers, which
+    // may fill in the name index themselves (sortNames false) and sort on
+    // more threads.
+    static CsrGraph assemble(const std::shared_ptr<CsrStorage>& storage, const NodeId* from, const NodeId* to,
+                             const double* weight, size_t count, bool sortNames = true, unsigned threads = 1) {
+        return assembleEdges(storage, EdgeArraySource(from, to, weight), count, sortNames, threads);
+    }
+
+    // Same with the edges read through source.from(i), to(i) and weight(i)
+    template <class EdgeSource>
+    static CsrGraph assembleEdges(const std::shared_ptr<CsrStorage>& storage, const EdgeSource& source, size_t count,
+                                  bool sortNames = true, unsigned threads = 1) {
+        CsrStorage& s = *storage;
+        NodeId n = (NodeId)s.xs.size();
+
+        s.offsets.assign(n + 1, 0);
+        bool sorted = true;
+        for (size_t i = 0; i < count; i++) {
+            s.offsets[source.from(i) + 1]++;
+            if (i > 0 && source.from(i) < source.from(i - 1)) sorted = false;
+        }
+        for (NodeId u = 0; u < n; u++) {
+            s.offsets[u + 1] += s.offsets[u];
+        }
+
+        s.targets.resize(count);
+        s.weights.resize(count);
+        auto inputEdges = [&source](std::pair<NodeId, EdgeTail>* out, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                EdgeTail tail = {source.to(i), source.weight(i)};
+                out[i - begin] = std::make_pair(source.from(i), tail);
+            }
+        };
+        auto placeForward = [&s](const EdgeTail& tail, EdgeId slot) {
+            s.targets[slot] = tail.to;
+            s.weights[slot] = tail.weight;
+        };
+        // Input sorted by source (typical for DIMACS files) scatters sequentially
+        scatterByKey<EdgeTail>(s.offsets, count, !sorted, inputEdges, placeForward);
+
+        // Second counting sort by target for the incoming edges
+        s.inOffsets.assign(n + 1, 0);
+        for (size_t i = 0; i < count; i++) {
+            s.inOffsets[source.to(i) + 1]++;
+        }
+        for (NodeId u = 0; u < n; u++) {
+            s.inOffsets[u + 1] += s.inOffsets[u];
+        }
+
+        s.inSources.resize(count);
+        s.inEdges.resize(count);
+        const CsrStorage& forward = s;
+        auto forwardEdges = [&forward](std::pair<NodeId, EdgeHead>* out, size_t begin, size_t end) {
+            NodeId u = (NodeId)(std::upper_bound(forward.offsets.begin(), forward.offsets.end(), (EdgeId)begin) -
+                                forward.offsets.begin() - 1);
+            for (size_t e = begin; e < end; e++) {
+                while (forward.offsets[u + 1] <= e) u++;
+                EdgeHead head = {u, (EdgeId)e};
+                out[e - begin] = std::make_pair(forward.targets[e], head);
+            }
+        };
+        auto placeReverse = [&s](const EdgeHead& head, EdgeId slot) {
+            s.inSources[slot] = head.from;
+            s.inEdges[slot] = head.edge;
+        };
+        scatterByKey<EdgeHead>(s.inOffsets, count, true, forwardEdges, placeReverse);
+
+        if (sortNames) {
+            // Sort by name prefix first so most comparisons stay out of the pool
+            const char* pool = s.namePool.data();
+            const uint32_t* offsets = s.nameOffsets.data();
+            std::vector<std::pair<uint64_t, NodeId> > keyed(n);
+            for (NodeId u = 0; u < n; u++) {
+                keyed[u] = std::make_pair(namePrefixKey(pool + offsets[u], offsets[u + 1] - offsets[u]), u);
+            }
+            typedef std::pair<uint64_t, NodeId> Keyed;
+            parallelSort(keyed.begin(), keyed.end(), [pool, offsets](const Keyed& a, const Keyed& b) {
+                if (a.first != b.first) return a.first < b.first;
+                uint32_t lenA = offsets[a.second + 1] - offsets[a.second];
+                uint32_t lenB = offsets[b.second + 1] - offsets[b.second];
+                int cmp = std::memcmp(pool + offsets[a.second], pool + offsets[b.second], std::min(lenA, lenB));
+                return cmp < 0 || (cmp == 0 && lenA < lenB);
+            }, threads);
+            s.nameIndex.resize(n);
+            for (NodeId u = 0; u < n; u++) s.nameIndex[u] = keyed[u].second;
+        }
+
+        CsrGraph g;
+        g.adopt(storage);
+        return g;
+    }
+
+private:
+    static const uint32_t INLINE_NAME = 8;
+
+    struct NodeRecord {
+        union {
+            char inlineName[INLINE_NAME]; // names of up to INLINE_NAME bytes
+            const char* pooledName;       // longer ones, in the arena
+        };
+        uint32_t length;
+        uint32_t hash;
+        double x, y;
+
+        const char* name() const { return length <= INLINE_NAME ? inlineName : pooledName; }
+    };
+
+    struct EdgeRecord {
+        NodeId from, to;
+        double weight;
+    };
+
+    struct EdgeArraySource {
+        const NodeId* fromIds;
+        const NodeId* toIds;
+        const double* weights;
+        EdgeArraySource(const NodeId* f, const NodeId* t, const double* w) : fromIds(f), toIds(t), weights(w) {}
+        NodeId from(size_t i) const { return fromIds[i]; }
+        NodeId to(size_t i) const { return toIds[i]; }
+        double weight(size_t i) const { return weights[i]; }
+    };
+
+    struct EdgeListSource {
+        const ArenaList<EdgeRecord>& list;
+        explicit EdgeListSource(const ArenaList<EdgeRecord>& edges) : list(edges) {}
+        NodeId from(size_t i) const { return list[i].from; }
+        NodeId to(size_t i) const { return list[i].to; }
+        double weight(size_t i) const { return list[i].weight; }
+    };
+
+    // 32-bit FNV-1a
+    static uint32_t nameHash(const char* name, size_t length) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < length; i++) {
+            hash ^= (unsigned char)name[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    // Slot holding the node with this name, or the empty slot where it would go
+    size_t findSlot(const char* name, uint32_t length, uint32_t hash) const {
+        size_t mask = slots.size() - 1;
+        for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+            NodeId id = slots[slot];
+            if (id == INVALID_NODE) return slot;
+            const NodeRecord& node = nodes[id];
+            if (node.hash == hash && node.length == length && std::memcmp(node.name(), name, length) == 0) {
+                return slot;
+            }
+        }
+    }
+
+    // Double the table (kept at most half full) and reinsert every node
+    void growSlots() {
+        slots.assign(std::max<size_t>(64, slots.size() * 2), INVALID_NODE);
+        size_t mask = slots.size() - 1;
+        for (NodeId id = 0; id < nodes.size(); id++) {
+            size_t slot = nodes[id].hash & mask;
+            while (slots[slot] != INVALID_NODE) slot = (slot + 1) & mask;
+            slots[slot] = id;
+        }
+    }
+
+    struct EdgeTail {
+        NodeId to;
+        double weight;
+    };
+    struct EdgeHead {
+        NodeId from;
+        EdgeId edge;
+    };
+
+    static const NodeId SCATTER_BUCKET_NODES = 1024;
+    static const size_t SCATTER_BLOCK = 4096;
+
+    // Place count records into the slots of a counting sort whose bucket
+    // starts are offsets. produce(out, begin, end) writes records
+    // [begin, end) as (key, record) pairs. Records of equal key keep
+    // their order. With bucketed set and a key range too large for the
+    // cache, records are first partitioned by blocks of
+    // SCATTER_BUCKET_NODES keys; the final writes of each block then
+    // land in a small window instead of anywhere in the output.
+    template <class Record, class Produce, class Place>
+    static void scatterByKey(const std::vector<EdgeId>& offsets, size_t count, bool bucketed, Produce produce,
+                             Place place) {
+        NodeId n = (NodeId)(offsets.size() - 1);
+        std::vector<EdgeId> cursor(offsets.begin(), offsets.end() - 1);
+        std::vector<std::pair<NodeId, Record> > block(std::min(count, SCATTER_BLOCK));
+        if (!bucketed || n <= 64 * SCATTER_BUCKET_NODES) {
+            for (size_t begin = 0; begin < count; begin += SCATTER_BLOCK) {
+                size_t end = std::min(count, begin + SCATTER_BLOCK);
+                produce(block.data(), begin, end);
+                for (size_t i = 0; i < end - begin; i++) place(block[i].second, cursor[block[i].first]++);
+            }
+            return;
+        }
+
+        std::vector<size_t> bucketCursor((n - 1) / SCATTER_BUCKET_NODES + 1);
+        for (size_t b = 0; b < bucketCursor.size(); b++) bucketCursor[b] = offsets[b * SCATTER_BUCKET_NODES];
+        std::vector<std::pair<NodeId, Record> > staged(count);
+        for (size_t begin = 0; begin < count; begin += SCATTER_BLOCK) {
+            size_t end = std::min(count, begin + SCATTER_BLOCK);
+            produce(block.data(), begin, end);
+            for (size_t i = 0; i < end - begin; i++) {
+                staged[bucketCursor[block[i].first / SCATTER_BUCKET_NODES]++] = block[i];
+            }
+        }
+        for (size_t i = 0; i < count; i++) place(staged[i].second, cursor[staged[i].first]++);
+    }
+
+    std::unique_ptr<Arena> arena; // on the heap so the lists' pointer to it survives moves
+    ArenaList<NodeRecord> nodes;
+    ArenaList<EdgeRecord> edges;
+    std::vector<NodeId> slots; // open-addressing name table, INVALID_NODE if empty
+};
+
+const uint32_t CsrBuilder::INLINE_NAME;
+const NodeId CsrBuilder::SCATTER_BUCKET_NODES;
+const size_t CsrBuilder::SCATTER_BLOCK;
+
+#endif
@@ -0,0 +1,333 @@
+#ifndef DELTA_STEPPING_H
+#define DELTA_STEPPING_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "csr_graph.h"
+#include "search_context.h"
+#include "parallel.h"
+
+// Summary of one single-source run
+struct SsspReport {
+    unsigned threads;
+    double delta;
+    size_t buckets;     // non-empty buckets settled
+    size_t phases;      // light rounds plus heavy rounds
+    size_t relaxations; // requests that improved a distance
+    double seconds;
+};
+
+// Parallel single-source shortest paths by delta-stepping (Meyer and
+// Sanders). Tentative distances are kept in buckets of width delta. The
+// lowest non-empty bucket is settled in rounds over its light edges
+// (weight <= delta), which may refill it, then its heavy edges are
+// relaxed once. A run gives every node's distance from the source and a
+// parent on one shortest path, for isochrones, landmark tables and
+// reachability checks.
+//
+// Each worker owns a fixed share of the nodes and is the only one that
+// writes their distances, parents and buckets, so no atomics are needed.
+// A round has three steps separated by barriers: owners move the live
+// nodes of the current bucket into a frontier; all workers scan the
+// frontier's edges, claiming chunks from a shared counter so uneven
+// degrees balance out, and post improving requests to the target's
+// owner; owners apply the requests addressed to them.
+//
+// Buckets are kept in a ring: every tentative distance lies within the
+// heaviest edge weight of the current bucket, so maxWeight / delta + 2
+// buckets suffice however long the paths are. A delta below
+// maxWeight / (MAX_BUCKETS - 2) is raised to it, which keeps the ring
+// small and the bucket index of any distance well inside size_t.
+//
+// Weights must be non-negative. Infinite (removed) edges are never used.
+class DeltaStepping {
+public:
+    static const size_t MAX_BUCKETS = 1 << 16;
+
+    // threads == 0 uses one worker per hardware thread; delta == 0 picks
+    // twice the mean finite edge weight
+    explicit DeltaStepping(unsigned threads = 0, double delta = 0) : threads(threads), delta(delta) {}
+
+    // dist[v] is INFINITE_COST and parent[v] INVALID_NODE if v is
+    // unreachable; parent[source] is INVALID_NODE
+    template <class View>
+    SsspReport run(const View& g, NodeId source, std::vector<double>& dist, std::vector<NodeId>& parent) const {
+        chrono_point begin = std::chrono::steady_clock::now();
+        double mean, heaviest;
+        weightStats(g, mean, heaviest);
+        double width = delta > 0 ? delta : 2 * mean;
+        width = std::max(width, heaviest / (MAX_BUCKETS - 2));
+        size_t slots = (size_t)(heaviest / width) + 2;
+        Run<View> state(g, threads == 0 ? defaultThreadCount() : threads, width, slots);
+        dist.assign(g.numNodes(), INFINITE_COST);
+        parent.assign(g.numNodes(), INVALID_NODE);
+        state.dist = dist.data();
+        state.parent = parent.data();
+
+        SsspReport report;
+        report.threads = state.workers;
+        report.delta = state.width;
+        report.buckets = report.phases = report.relaxations = 0;
+        if (source < g.numNodes()) {
+            dist[source] = 0;
+            state.local[state.owner(source)].push(0, source);
+            state.execute(report);
+        }
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        return report;
+    }
+
+    // Twice the mean finite edge weight, or 1 for a graph without any
+    template <class View>
+    static double defaultDelta(const View& g) {
+        double mean, heaviest;
+        weightStats(g, mean, heaviest);
+        return 2 * mean;
+    }
+
+private:
+    // Mean (1 if there is no positive weight) and largest finite weight
+    template <class View>
+    static void weightStats(const View& g, double& mean, double& heaviest) {
+        double total = 0;
+        size_t count = 0;
+        heaviest = 0;
+        for (NodeId u = 0; u < g.numNodes(); u++) {
+            for (EdgeId e = g.edgeBegin(u); e < g.edgeEnd(u); e++) {
+                double weight = g.weight(e);
+                if (weight != INFINITE_COST) {
+                    total += weight;
+                    heaviest = std::max(heaviest, weight);
+                    count++;
+                }
+            }
+        }
+        mean = count > 0 && total > 0 ? total / count : 0.5;
+    }
+
+    typedef std::chrono::steady_clock::time_point chrono_point;
+
+    static const size_t NO_BUCKET = std::numeric_limits<size_t>::max();
+    static const size_t SCAN_GRAIN = 256;
+
+    struct Request {
+        NodeId target, from;
+        double distance;
+    };
+
+    // Buckets and phase lists of the nodes one worker owns. Bucket b lives
+    // in slot b % buckets.size(); the live ones span fewer buckets than that.
+    struct Worker {
+        std::vector<std::vector<NodeId> > buckets;
+        size_t lowest; // no non-empty bucket below it, NO_BUCKET if all are empty
+        std::vector<NodeId> frontier;
+        std::vector<NodeId> settled; // scanned in the current bucket, for its heavy round
+        std::vector<std::vector<Request> > outbox; // by owner of the target
+        size_t relaxations;
+
+        Worker() : lowest(NO_BUCKET), relaxations(0) {}
+
+        void push(size_t bucket, NodeId v) {
+            buckets[bucket % buckets.size()].push_back(v);
+            lowest = std::min(lowest, bucket);
+        }
+
+        size_t nextBucket() {
+            for (size_t scanned = 0; lowest != NO_BUCKET && scanned < buckets.size(); scanned++, lowest++) {
+                if (!buckets[lowest % buckets.size()].empty()) return lowest;
+            }
+            lowest = NO_BUCKET;
+            return NO_BUCKET;
+        }
+    };
+
+    template <class View>
+    struct Run {
+        const View& g;
+        unsigned workers;
+        double width;
+        double* dist;
+        NodeId* parent;
+        std::vector<Worker> local;
+        std::vector<double> scannedAt;  // distance each node was last scanned with
+        std::vector<char> inSettled;
+        std::vector<size_t> frontierStart; // offsets of the workers' frontiers in the combined one
+        std::atomic<size_t> nextChunk;
+        PhaseBarrier barrier;
+        // Shared round state, only changed by a barrier's completion
+        size_t bucket;
+        bool heavy, emptyRound, finished;
+        size_t bucketsDone, phasesDone;
+
+        Run(const View& graph, unsigned threads, double delta, size_t slots)
+            : g(graph), workers(threads), width(delta), dist(nullptr), parent(nullptr), local(threads),
+              scannedAt(graph.numNodes(), INFINITE_COST), inSettled(graph.numNodes(), 0), frontierStart(threads + 1),
+              nextChunk(0), barrier(threads), bucket(0), heavy(false), emptyRound(false), finished(false),
+              bucketsDone(0), phasesDone(0) {
+            for (unsigned w = 0; w < workers; w++) {
+                local[w].outbox.resize(workers);
+                local[w].buckets.resize(slots);
+            }
+        }
+
+        // Blocks of 64 consecutive ids per owner keep their state on shared cache lines
+        unsigned owner(NodeId v) const { return (unsigned)((v >> 6) % workers); }
+
+        size_t bucketOf(double d) const { return (size_t)(d / width); }
+
+        void execute(SsspReport& report) {
+            bucket = NO_BUCKET;
+            for (unsigned w = 0; w < workers; w++) bucket = std::min(bucket, local[w].nextBucket());
+            std::vector<std::thread> threads;
+            for (unsigned w = 1; w < workers; w++) threads.push_back(std::thread([this, w] { work(w); }));
+            work(0);
+            for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+            report.buckets = bucketsDone;
+            report.phases = phasesDone;
+            for (unsigned w = 0; w < workers; w++) report.relaxations += local[w].relaxations;
+        }
+
+        void work(unsigned w) {
+            Worker& mine = local[w];
+            while (true) {
+                collect(mine);
+                barrier.wait([this] {
+                    frontierStart[0] = 0;
+                    for (unsigned o = 0; o < workers; o++) {
+                        frontierStart[o + 1] = frontierStart[o] + local[o].frontier.size();
+                    }
+                    nextChunk.store(0);
+                    // A light round that found nothing leaves the bucket
+                    // empty: its heavy edges come next
+                    emptyRound = frontierStart[workers] == 0 && !heavy;
+                    if (emptyRound) heavy = true;
+                    else phasesDone++;
+                });
+                if (emptyRound) continue;
+
+                scan(w);
+                barrier.wait();
+                apply(w);
+                barrier.wait([this] {
+                    if (!heavy) return;
+                    heavy = false;
+                    bucketsDone++;
+                    bucket = NO_BUCKET;
+                    for (unsigned o = 0; o < workers; o++) bucket = std::min(bucket, local[o].nextBucket());
+                    finished = bucket == NO_BUCKET;
+                });
+                if (finished) return;
+            }
+        }
+
+        // Move the owner's live nodes of the current bucket into its
+        // frontier, or in the heavy round the nodes settled in it
+        void collect(Worker& mine) {
+            mine.frontier.clear();
+            if (heavy) {
+                mine.frontier.swap(mine.settled);
+                for (size_t i = 0; i < mine.frontier.size(); i++) inSettled[mine.frontier[i]] = 0;
+                return;
+            }
+            std::vector<NodeId>& entries = mine.buckets[bucket % mine.buckets.size()];
+            for (size_t i = 0; i < entries.size(); i++) {
+                NodeId v = entries[i];
+                // Skip entries left behind by a later improvement and repeats
+                if (bucketOf(dist[v]) != bucket || !(dist[v] < scannedAt[v])) continue;
+                scannedAt[v] = dist[v];
+                mine.frontier.push_back(v);
+                if (!inSettled[v]) {
+                    inSettled[v] = 1;
+                    mine.settled.push_back(v);
+                }
+            }
+            entries.clear();
+        }
+
+        // Relax the light (or heavy) edges of the combined frontier
+        void scan(unsigned w) {
+            std::vector<std::vector<Request> >& outbox = local[w].outbox;
+            size_t total = frontierStart[workers];
+            for (size_t begin = nextChunk.fetch_add(SCAN_GRAIN); begin < total;
+                 begin = nextChunk.fetch_add(SCAN_GRAIN)) {
+                size_t end = std::min(total, begin + SCAN_GRAIN);
+                unsigned o = (unsigned)(std::upper_bound(frontierStart.begin(), frontierStart.end(), begin) -
+                                        frontierStart.begin() - 1);
+                for (size_t i = begin; i < end; i++) {
+                    while (frontierStart[o + 1] <= i) o++;
+                    NodeId u = local[o].frontier[i - frontierStart[o]];
+                    double base = dist[u];
+                    for (EdgeId e = g.edgeBegin(u); e < g.edgeEnd(u); e++) {
+                        double weight = g.weight(e);
+                        if ((weight > width) != heavy) continue;
+                        NodeId v = g.target(e);
+                        double candidate = base + weight;
+                        // dist is only written while applying, so this read is stable
+                        if (candidate < dist[v]) {
+                            Request request = {v, u, candidate};
+                            outbox[owner(v)].push_back(request);
+                        }
+                    }
+                }
+            }
+        }
+
+        // Apply the requests addressed to the owner w
+        void apply(unsigned w) {
+            Worker& mine = local[w];
+            for (unsigned from = 0; from < workers; from++) {
+                std::vector<Request>& inbox = local[from].outbox[w];
+                for (size_t i = 0; i < inbox.size(); i++) {
+                    const Request& request = inbox[i];
+                    if (request.distance < dist[request.target]) {
+                        dist[request.target] = request.distance;
+                        parent[request.target] = request.from;
+                        mine.push(bucketOf(request.distance), request.target);
+                        mine.relaxations++;
+                    }
+                }
+                inbox.clear();
+            }
+        }
+    };
+
+    unsigned threads;
+    double delta;
+};
+
+const size_t DeltaStepping::MAX_BUCKETS;
+const size_t DeltaStepping::NO_BUCKET;
+const size_t DeltaStepping::SCAN_GRAIN;
+
+// Check dist and parent against the shortest-path optimality conditions:
+// dist[source] is 0, no edge u -> v has dist[u] + w < dist[v], and every
+// other reachable node's parent edge is tight. Returns the number of
+// nodes that break one; 0 means dist is exact. Linear time, so it can
+// check runs too large to repeat with Dijkstra.
+template <class View>
+size_t checkShortestPaths(const View& g, NodeId source, const std::vector<double>& dist,
+                          const std::vector<NodeId>& parent) {
+    size_t bad = dist[source] == 0 && parent[source] == INVALID_NODE ? 0 : 1;
+    std::vector<char> parentTight(g.numNodes(), 0);
+    for (NodeId u = 0; u < g.numNodes(); u++) {
+        bool broken = false;
+        for (EdgeId e = g.edgeBegin(u); e < g.edgeEnd(u); e++) {
+            NodeId v = g.target(e);
+            if (dist[u] + g.weight(e) < dist[v]) broken = true;
+            if (parent[v] == u && dist[u] + g.weight(e) == dist[v]) parentTight[v] = 1;
+        }
+        if (broken) bad++;
+    }
+    for (NodeId v = 0; v < g.numNodes(); v++) {
+        if (v != source && dist[v] != INFINITE_COST && !parentTight[v]) bad++;
+    }
+    return bad;
+}
+
+#endif
@@ -0,0 +1,343 @@
+#ifndef DISTANCE_TABLE_H
+#define DISTANCE_TABLE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "csr_graph.h"
+#include "search_context.h"
+#include "open_list.h"
+
+// Heuristic used by a one-to-many search. Both non-zero options are
+// consistent whenever the Euclidean heuristic is, so every settled target
+// has its exact distance.
+enum TableHeuristic {
+    TABLE_HEURISTIC_NONE,             // plain Dijkstra
+    TABLE_HEURISTIC_MIN_OVER_TARGETS, // distance to the nearest target, O(targets) per node
+    TABLE_HEURISTIC_BOUNDING_BOX      // distance to the targets' bounding box, O(1) per node
+};
+
+// How a many-to-many table is computed
+enum TableStrategy {
+    TABLE_AUTO,     // forward or backward, whichever needs fewer searches
+    TABLE_FORWARD,  // one search per source, stops when all targets are settled
+    TABLE_BACKWARD, // one search per target over the incoming edges
+    TABLE_BUCKETS   // bounded backward searches stored in per-node buckets, reused by every source
+};
+
+struct TableOptions {
+    TableStrategy strategy;
+    TableHeuristic heuristic;
+    bool keepParents;           // store the forward parent tree of every source
+    uint32_t bucketSettleLimit; // nodes settled by each backward search in TABLE_BUCKETS
+
+    TableOptions()
+        : strategy(TABLE_AUTO), heuristic(TABLE_HEURISTIC_NONE), keepParents(false), bucketSettleLimit(4096) {}
+};
+
+// Dense source x target cost matrix, INFINITE_COST where there is no path
+struct DistanceTable {
+    size_t rows, cols;
+    NodeId numNodes;
+    std::vector<double> costs;   // row-major, costs[r * cols + c]
+    std::vector<NodeId> parents; // rows * numNodes when parents were kept
+
+    DistanceTable() : rows(0), cols(0), numNodes(0) {}
+
+    double at(size_t r, size_t c) const { return costs[r * cols + c]; }
+    bool hasParents() const { return !parents.empty(); }
+
+    // Path from source r to target through the stored parent tree
+    std::vector<NodeId> path(size_t r, NodeId target) const {
+        std::vector<NodeId> result;
+        if (!hasParents() || target >= numNodes) return result;
+        const NodeId* tree = &parents[r * numNodes];
+        for (NodeId v = target; v != INVALID_NODE; v = tree[v]) result.push_back(v);
+        std::reverse(result.begin(), result.end());
+        return result;
+    }
+};
+
+// Distance-table engine. Keeps its SearchContext and scratch arrays between
+// calls, so repeated tables over the same graph allocate only the output.
+class DistanceTableEngine {
+public:
+    DistanceTableEngine() : markGeneration(0), settled(0), minX(0), maxX(0), minY(0), maxY(0) {}
+
+    // One search from source that stops once every target is settled.
+    // costs[c * stride] receives the distance to targets[c]; parentRow, if
+    // given, receives the parent of every settled node (numNodes entries).
+    template <class View>
+    void oneToMany(const View& g, NodeId source, const NodeId* targets, size_t count,
+                   TableHeuristic heuristic, double* costs, size_t stride, NodeId* parentRow) {
+        for (size_t c = 0; c < count; c++) costs[c * stride] = INFINITE_COST;
+        if (source >= g.numNodes()) {
+            if (parentRow) std::fill(parentRow, parentRow + g.numNodes(), INVALID_NODE);
+            return;
+        }
+
+        size_t remaining = markTargets(g.numNodes(), targets, count);
+        prepareHeuristic(g, targets, count, heuristic);
+
+        IndexedDaryHeap<4>& open = ctx.quaternaryHeap;
+        ctx.reset(g.numNodes());
+        open.reset(g.numNodes());
+        ctx.setG(source, 0, INVALID_NODE);
+        ctx.setState(source, SearchContext::OPEN);
+        open.push(source, estimate(g, source, targets, count, heuristic));
+
+        while (remaining > 0 && !open.empty()) {
+            NodeId current = open.pop();
+            ctx.setState(current, SearchContext::CLOSED);
+            settled++;
+            if (isMarked(current)) {
+                unmark(current);
+                remaining--;
+            }
+
+            double currentG = ctx.g(current);
+            for (EdgeId e = g.edgeBegin(current); e < g.edgeEnd(current); e++) {
+                NodeId neighbor = g.target(e);
+                double tentative = currentG + g.weight(e);
+                if (tentative < ctx.g(neighbor)) {
+                    ctx.setG(neighbor, tentative, current);
+                    ctx.setState(neighbor, SearchContext::OPEN);
+                    open.push(neighbor, tentative + estimate(g, neighbor, targets, count, heuristic));
+                }
+            }
+        }
+
+        for (size_t c = 0; c < count; c++) {
+            NodeId t = targets[c];
+            if (t < g.numNodes() && ctx.stateOf(t) == SearchContext::CLOSED) {
+                costs[c * stride] = ctx.g(t);
+            }
+        }
+        if (parentRow) {
+            for (NodeId v = 0; v < g.numNodes(); v++) {
+                parentRow[v] = ctx.stateOf(v) == SearchContext::CLOSED ? ctx.parentOf(v) : INVALID_NODE;
+            }
+        }
+    }
+
+    // Full sources x targets table
+    void manyToMany(const CsrGraph& g, const std::vector<NodeId>& sources, const std::vector<NodeId>& targets,
+                    const TableOptions& options, DistanceTable& table) {
+        table.rows = sources.size();
+        table.cols = targets.size();
+        table.numNodes = g.numNodes();
+        table.costs.assign(table.rows * table.cols, INFINITE_COST);
+        table.parents.clear();
+        settled = 0;
+        if (table.rows == 0 || table.cols == 0) return;
+
+        TableStrategy strategy = options.strategy;
+        if (options.keepParents) {
+            strategy = TABLE_FORWARD; // parent trees are forward trees
+        } else if (strategy == TABLE_AUTO) {
+            strategy = sources.size() <= targets.size() ? TABLE_FORWARD : TABLE_BACKWARD;
+        }
+
+        if (strategy == TABLE_FORWARD) {
+            if (options.keepParents) table.parents.resize(table.rows * (size_t)g.numNodes());
+            for (size_t r = 0; r < table.rows; r++) {
+                NodeId* parentRow = options.keepParents ? &table.parents[r * (size_t)g.numNodes()] : nullptr;
+                oneToMany(g, sources[r], targets.data(), targets.size(), options.heuristic,
+                          &table.costs[r * table.cols], 1, parentRow);
+            }
+        } else if (strategy == TABLE_BACKWARD) {
+            ReverseView reverse(g);
+            for (size_t c = 0; c < table.cols; c++) {
+                oneToMany(reverse, targets[c], sources.data(), sources.size(), options.heuristic,
+                          &table.costs[c], table.cols, nullptr);
+            }
+        } else {
+            bucketTable(g, sources, targets, options.bucketSettleLimit, table);
+        }
+    }
+
+    // Nodes settled by the searches of the last manyToMany, not counting
+    // the bounded backward searches of TABLE_BUCKETS
+    uint64_t settledCount() const { return settled; }
+
+private:
+    // Targets are marked with a generation stamp so clearing is O(1)
+    size_t markTargets(NodeId numNodes, const NodeId* targets, size_t count) {
+        if (mark.size() < numNodes) mark.resize(numNodes, 0);
+        markGeneration++;
+        if (markGeneration == 0) {
+            std::fill(mark.begin(), mark.end(), 0);
+            markGeneration = 1;
+        }
+        size_t unique = 0;
+        for (size_t c = 0; c < count; c++) {
+            NodeId t = targets[c];
+            if (t < numNodes && mark[t] != markGeneration) {
+                mark[t] = markGeneration;
+                unique++;
+            }
+        }
+        return unique;
+    }
+
+    bool isMarked(NodeId u) const { return mark[u] == markGeneration; }
+    void unmark(NodeId u) { mark[u] = 0; }
+
+    template <class View>
+    void prepareHeuristic(const View& g, const NodeId* targets, size_t count, TableHeuristic heuristic) {
+        if (heuristic != TABLE_HEURISTIC_BOUNDING_BOX) return;
+        bool first = true;
+        for (size_t c = 0; c < count; c++) {
+            NodeId t = targets[c];
+            if (t >= g.numNodes()) continue;
+            if (first) {
+                minX = maxX = g.x(t);
+                minY = maxY = g.y(t);
+                first = false;
+            }
+            minX = std::min(minX, g.x(t));
+            maxX = std::max(maxX, g.x(t));
+            minY = std::min(minY, g.y(t));
+            maxY = std::max(maxY, g.y(t));
+        }
+        if (first) minX = maxX = minY = maxY = 0;
+    }
+
+    template <class View>
+    double estimate(const View& g, NodeId u, const NodeId* targets, size_t count, TableHeuristic heuristic) const {
+        if (heuristic == TABLE_HEURISTIC_NONE) return 0;
+        double ux = g.x(u), uy = g.y(u);
+        if (heuristic == TABLE_HEURISTIC_BOUNDING_BOX) {
+            double dx = std::max(0.0, std::max(minX - ux, ux - maxX));
+            double dy = std::max(0.0, std::max(minY - uy, uy - maxY));
+            return std::sqrt(dx * dx + dy * dy);
+        }
+        double best = INFINITE_COST;
+        for (size_t c = 0; c < count; c++) {
+            NodeId t = targets[c];
+            if (t >= g.numNodes()) continue;
+            double dx = g.x(t) - ux, dy = g.y(t) - uy;
+            best = std::min(best, dx * dx + dy * dy);
+        }
+        return best == INFINITE_COST ? 0 : std::sqrt(best);
+    }
+
+    struct BucketEntry {
+        uint32_t column;
+        double cost; // distance from the bucket's node to the target of column
+    };
+
+    // Bucket-based many-to-many. Each target runs one bounded backward
+    // search and leaves (column, distance) in the bucket of every node it
+    // settles. Every node within the settled radius of a target is in its
+    // ball, so a forward search from a source that has settled all nodes up
+    // to cost d has seen some ball node on every path to that target no
+    // longer than d. It can stop once its key reaches the current best of
+    // every column, which it tracks as a running maximum once every
+    // column has a finite best.
+    void bucketTable(const CsrGraph& g, const std::vector<NodeId>& sources, const std::vector<NodeId>& targets,
+                     uint32_t settleLimit, DistanceTable& table) {
+        NodeId n = g.numNodes();
+        ReverseView reverse(g);
+        IndexedDaryHeap<4>& open = ctx.quaternaryHeap;
+
+        // Backward balls, collected as (node, entry) and bucketed by node
+        std::vector<std::pair<NodeId, BucketEntry> > found;
+        for (size_t c = 0; c < targets.size(); c++) {
+            NodeId t = targets[c];
+            if (t >= n) continue;
+            ctx.reset(n);
+            open.reset(n);
+            ctx.setG(t, 0, INVALID_NODE);
+            ctx.setState(t, SearchContext::OPEN);
+            open.push(t, 0);
+            uint32_t settled = 0;
+            while (!open.empty() && settled < settleLimit) {
+                NodeId current = open.pop();
+                ctx.setState(current, SearchContext::CLOSED);
+                settled++;
+                BucketEntry entry;
+                entry.column = (uint32_t)c;
+                entry.cost = ctx.g(current);
+                found.push_back(std::make_pair(current, entry));
+                relax(reverse, open, current);
+            }
+        }
+
+        std::vector<uint32_t> bucketOffsets(n + 1, 0);
+        for (size_t i = 0; i < found.size(); i++) bucketOffsets[found[i].first + 1]++;
+        for (NodeId u = 0; u < n; u++) bucketOffsets[u + 1] += bucketOffsets[u];
+        std::vector<BucketEntry> buckets(found.size());
+        std::vector<uint32_t> cursor(bucketOffsets.begin(), bucketOffsets.end() - 1);
+        for (size_t i = 0; i < found.size(); i++) buckets[cursor[found[i].first]++] = found[i].second;
+
+        // Forward searches from every source scan the buckets they settle
+        for (size_t r = 0; r < sources.size(); r++) {
+            NodeId s = sources[r];
+            if (s >= n) continue;
+            double* best = &table.costs[r * table.cols];
+            size_t unreached = 0; // columns without a finite best yet
+            for (size_t c = 0; c < table.cols; c++) {
+                if (targets[c] < n) unreached++;
+            }
+            double bound = unreached == 0 ? 0 : INFINITE_COST; // max of best[] once all are finite
+
+            ctx.reset(n);
+            open.reset(n);
+            ctx.setG(s, 0, INVALID_NODE);
+            ctx.setState(s, SearchContext::OPEN);
+            open.push(s, 0);
+            while (!open.empty()) {
+                double key = open.topKey();
+                if (key >= bound) break;
+                NodeId current = open.pop();
+                ctx.setState(current, SearchContext::CLOSED);
+                settled++;
+                bool rescan = false;
+                for (uint32_t i = bucketOffsets[current]; i < bucketOffsets[current + 1]; i++) {
+                    double candidate = key + buckets[i].cost;
+                    double& column = best[buckets[i].column];
+                    if (candidate < column) {
+                        // The maximum can only drop when the last infinite
+                        // column is reached or the loosest one improves
+                        if (column == INFINITE_COST) rescan = --unreached == 0 || rescan;
+                        else rescan = rescan || column == bound;
+                        column = candidate;
+                    }
+                }
+                if (rescan) {
+                    bound = 0;
+                    for (size_t c = 0; c < table.cols; c++) {
+                        if (targets[c] < n) bound = std::max(bound, best[c]);
+                    }
+                }
+                relax(g, open, current);
+            }
+        }
+    }
+
+    // Dijkstra relaxation of all edges out of current
+    template <class View>
+    void relax(const View& g, IndexedDaryHeap<4>& open, NodeId current) {
+        double currentG = ctx.g(current);
+        for (EdgeId e = g.edgeBegin(current); e < g.edgeEnd(current); e++) {
+            NodeId neighbor = g.target(e);
+            double tentative = currentG + g.weight(e);
+            if (tentative < ctx.g(neighbor)) {
+                ctx.setG(neighbor, tentative, current);
+                ctx.setState(neighbor, SearchContext::OPEN);
+                open.push(neighbor, tentative);
+            }
+        }
+    }
+
+    SearchContext ctx;
+    std::vector<uint32_t> mark;
+    uint32_t markGeneration;
+    uint64_t settled;
+    double minX, maxX, minY, maxY; // target bounding box
+};
+
+#endif
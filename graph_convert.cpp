@@ -0,0 +1,277 @@
+// Offline converter that writes binary graph files (.agr) for graph_astar
+//
+//   graph_convert <input.txt> <output.agr>     text graph, see below
+//   graph_convert --grid W H <output.agr>      synthetic 8-connected grid
+//   graph_convert --road N <output.agr>        synthetic road-like graph
+//   graph_convert --verify <file.agr>          check header and checksum
+//   graph_convert --dimacs <g.gr> [g.co] <output.agr>
+//   graph_convert --edges <list.txt> <output.agr>
+//   graph_convert --csv [nodes.csv] <edges.csv> <output.agr>
+//   graph_convert --layout <file.agr>          edge span and cache misses per node order
+//
+// Any conversion can be preceded by --reorder hilbert|bfs|rcm to renumber
+// the nodes for cache locality (graph_reorder.h) before writing.
+//
+// The bulk formats are described in graph_import.h; progress and the
+// import rate go to stderr.
+//
+// Text input has one item per line; '#' starts a comment:
+//   node <name> <x> <y>
+//   edge <from> <to> <weight>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <atomic>
+
+#include "csr_graph.h"
+#include "graph_file.h"
+#include "graph_generators.h"
+#include "graph_import.h"
+#include "graph_reorder.h"
+#include "perf_counters.h"
+#include "search_context.h"
+#include "astar_search.h"
+
+using namespace std;
+
+// Read the text format into g; returns false and sets error on bad input
+bool readTextGraph(const string& path, CsrGraph& g, string& error) {
+    ifstream in(path.c_str());
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    CsrBuilder builder;
+    string line;
+    size_t lineNumber = 0;
+    while (getline(in, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != string::npos) line.erase(comment);
+
+        istringstream fields(line);
+        string kind;
+        if (!(fields >> kind)) continue;
+
+        if (kind == "node") {
+            string name;
+            double x, y;
+            if (!(fields >> name >> x >> y)) {
+                error = path + ":" + to_string(lineNumber) + ": expected 'node <name> <x> <y>'";
+                return false;
+            }
+            builder.addNode(name, x, y);
+        } else if (kind == "edge") {
+            string from, to;
+            double weight;
+            if (!(fields >> from >> to >> weight)) {
+                error = path + ":" + to_string(lineNumber) + ": expected 'edge <from> <to> <weight>'";
+                return false;
+            }
+            NodeId fromId = builder.findNode(from);
+            NodeId toId = builder.findNode(to);
+            if (fromId == INVALID_NODE || toId == INVALID_NODE) {
+                error = path + ":" + to_string(lineNumber) + ": edge between unknown nodes";
+                return false;
+            }
+            builder.addEdge(fromId, toId, weight);
+        } else {
+            error = path + ":" + to_string(lineNumber) + ": unknown item '" + kind + "'";
+            return false;
+        }
+    }
+
+    g = builder.finalize();
+    return true;
+}
+
+// Run one of the bulk importers, printing progress every second
+template <class Import>
+bool runImport(Import import, CsrGraph& g, string& error) {
+    ImportProgress progress;
+    ImportOptions options;
+    options.progress = &progress;
+    GraphImporter importer(options);
+
+    atomic<bool> done(false);
+    bool reported = false;
+    thread reporter([&progress, &done, &reported] {
+        while (!done) {
+            for (int i = 0; i < 10 && !done; i++) this_thread::sleep_for(chrono::milliseconds(100));
+            if (!done) {
+                cerr << "\r" << progress.lines / 1000000 << "M lines, " << progress.edges / 1000000 << "M edges"
+                     << flush;
+                reported = true;
+            }
+        }
+    });
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    bool ok = import(importer, g, error);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    done = true;
+    reporter.join();
+
+    if (reported) cerr << endl;
+    if (ok) {
+        cerr << "Imported " << g.numNodes() << " nodes, " << g.numEdges() << " edges in " << seconds << " s ("
+             << (uint64_t)(g.numEdges() / max(seconds, 1e-9)) << " edges/s, "
+             << (uint64_t)(progress.bytes / max(seconds, 1e-9) / 1e6) << " MB/s)" << endl;
+    }
+    return ok;
+}
+
+// Print the edge span of g as given and in every node order, with the
+// time and cache misses of the same A* queries on each layout
+void reportLayout(const CsrGraph& g) {
+    vector<pair<NodeId, NodeId>> queries = makeQueries(g.numNodes(), 100, 7);
+    CacheMissCounter misses;
+    if (!misses.available()) cout << "(cache-miss counter unavailable)" << endl;
+    SearchContext ctx;
+    for (int order = -1; order <= ORDER_RCM; order++) {
+        CsrGraph layout = g;
+        vector<pair<NodeId, NodeId>> translated = queries;
+        if (order >= 0) {
+            vector<NodeId> oldToNew;
+            layout = reorderGraph(g, computeNodeOrder(g, (NodeOrder)order), &oldToNew);
+            for (size_t i = 0; i < queries.size(); i++) {
+                translated[i] = make_pair(oldToNew[queries[i].first], oldToNew[queries[i].second]);
+            }
+        }
+
+        LayoutStats stats = measureLayout(layout);
+        misses.start();
+        chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+        for (size_t i = 0; i < translated.size(); i++) {
+            astarSearch(layout, ctx, translated[i].first, translated[i].second);
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+        uint64_t missCount = misses.stop();
+
+        cout << (order < 0 ? "as given" : nodeOrderName((NodeOrder)order)) << ": span mean " << stats.meanSpan
+             << ", median " << stats.medianSpan << ", p90 " << stats.p90Span << ", near " << stats.nearFraction
+             << "; " << translated.size() << " queries in " << ms << " ms";
+        if (misses.available()) cout << ", " << missCount << " cache misses";
+        cout << endl;
+    }
+}
+
+bool parseNodeOrder(const string& name, NodeOrder& order) {
+    for (int o = ORDER_HILBERT; o <= ORDER_RCM; o++) {
+        if (name == nodeOrderName((NodeOrder)o)) {
+            order = (NodeOrder)o;
+            return true;
+        }
+    }
+    return false;
+}
+
+int usage() {
+    cerr << "Usage: graph_convert <input.txt> <output.agr>" << endl;
+    cerr << "       graph_convert --grid <width> <height> <output.agr>" << endl;
+    cerr << "       graph_convert --road <nodes> <output.agr>" << endl;
+    cerr << "       graph_convert --verify <file.agr>" << endl;
+    cerr << "       graph_convert --dimacs <g.gr> [g.co] <output.agr>" << endl;
+    cerr << "       graph_convert --edges <list.txt> <output.agr>" << endl;
+    cerr << "       graph_convert --csv [nodes.csv] <edges.csv> <output.agr>" << endl;
+    cerr << "       graph_convert --layout <file.agr>" << endl;
+    cerr << "       graph_convert --reorder hilbert|bfs|rcm <any conversion above>" << endl;
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    bool reorder = false;
+    NodeOrder order = ORDER_HILBERT;
+    if (argc >= 3 && string(argv[1]) == "--reorder") {
+        if (!parseNodeOrder(argv[2], order)) return usage();
+        reorder = true;
+        argc -= 2;
+        argv += 2;
+    }
+    if (argc < 3) return usage();
+    string mode = argv[1];
+    string error;
+
+    if (mode == "--layout") {
+        CsrGraph g;
+        if (!openGraphFile(argv[2], g, error)) {
+            cerr << "Error: " << error << endl;
+            return 1;
+        }
+        reportLayout(g);
+        return 0;
+    }
+
+    if (mode == "--verify") {
+        chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+        CsrGraph g;
+        if (!openGraphFile(argv[2], g, error, true)) {
+            cerr << "Error: " << error << endl;
+            return 1;
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+        cout << argv[2] << ": " << g.numNodes() << " nodes, " << g.numEdges() << " edges, checksum OK ("
+             << ms << " ms)" << endl;
+        return 0;
+    }
+
+    CsrGraph g;
+    string output;
+    if (mode == "--grid" && argc == 5) {
+        g = makeGridGraph((uint32_t)atoi(argv[2]), (uint32_t)atoi(argv[3]), 1);
+        output = argv[4];
+    } else if (mode == "--road" && argc == 4) {
+        g = makeRoadGraph((uint32_t)atoi(argv[2]), 3, 2);
+        output = argv[3];
+    } else if ((mode == "--dimacs" || mode == "--csv") && (argc == 4 || argc == 5)) {
+        string first = argv[2], second = argc == 5 ? argv[3] : "";
+        bool dimacs = mode == "--dimacs";
+        bool ok = runImport([&](GraphImporter& importer, CsrGraph& graph, string& message) {
+            if (dimacs) return importer.dimacs(first, second, graph, message);
+            if (second.empty()) return importer.csv("", first, graph, message);
+            return importer.csv(first, second, graph, message);
+        }, g, error);
+        if (!ok) {
+            cerr << "Error: " << error << endl;
+            return 1;
+        }
+        output = argv[argc - 1];
+    } else if (mode == "--edges" && argc == 4) {
+        string input = argv[2];
+        bool ok = runImport([&](GraphImporter& importer, CsrGraph& graph, string& message) {
+            return importer.edgeList(input, graph, message);
+        }, g, error);
+        if (!ok) {
+            cerr << "Error: " << error << endl;
+            return 1;
+        }
+        output = argv[3];
+    } else if (mode[0] != '-' && argc == 3) {
+        if (!readTextGraph(argv[1], g, error)) {
+            cerr << "Error: " << error << endl;
+            return 1;
+        }
+        output = argv[2];
+    } else {
+        return usage();
+    }
+
+    if (reorder) {
+        LayoutStats before = measureLayout(g);
+        g = reorderGraph(g, computeNodeOrder(g, order));
+        cout << "Reordered by " << nodeOrderName(order) << ": mean edge span " << before.meanSpan << " -> "
+             << measureLayout(g).meanSpan << endl;
+    }
+
+    if (!writeGraphFile(g, output, error)) {
+        cerr << "Error: " << error << endl;
+        return 1;
+    }
+    cout << "Wrote " << output << ": " << g.numNodes() << " nodes, " << g.numEdges() << " edges" << endl;
+    return 0;
+}
@@ -0,0 +1,293 @@
+#ifndef GRAPH_FILE_H
+#define GRAPH_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "csr_graph.h"
+
+// Binary graph file (.agr), version 1. Laid out so a CsrGraph can point
+// straight into a read-only memory mapping:
+//
+//   header       fixed-size GraphFileHeader, including a section table,
+//                a checksum of the header itself and one of the payload
+//   node table   x, y, name offsets
+//   CSR arrays   offsets, targets, weights, then the reverse CSR
+//   string pool  names back to back and the name-sorted index
+//
+// Every section starts on a 64-byte boundary. Integers and doubles are
+// stored in host byte order; byteOrder tells other hosts apart.
+// Opening checks only the header (O(1)); the payload checksum is
+// verified on request, e.g. by graph_convert --verify.
+
+enum GraphFileSection {
+    SECTION_X, SECTION_Y, SECTION_NAME_OFFSETS,
+    SECTION_OFFSETS, SECTION_TARGETS, SECTION_WEIGHTS,
+    SECTION_IN_OFFSETS, SECTION_IN_SOURCES, SECTION_IN_EDGES,
+    SECTION_NAME_POOL, SECTION_NAME_INDEX,
+    SECTION_COUNT
+};
+
+struct GraphFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t headerBytes;
+    uint32_t numNodes;
+    uint32_t numEdges;
+    uint32_t namePoolBytes;
+    uint64_t fileBytes;
+    uint64_t payloadChecksum;
+    uint64_t sectionOffset[SECTION_COUNT];
+    uint64_t sectionBytes[SECTION_COUNT];
+    uint64_t headerChecksum; // over all fields above
+};
+
+const char GRAPH_FILE_MAGIC[8] = {'A', 'S', 'T', 'A', 'R', 'G', 'R', '\0'};
+const uint32_t GRAPH_FILE_VERSION = 1;
+const uint32_t GRAPH_FILE_BYTE_ORDER = 0x01020304;
+const uint64_t GRAPH_FILE_ALIGNMENT = 64;
+
+// Incremental 64-bit FNV-1a
+inline uint64_t fnv1a(const void* data, size_t bytes, uint64_t hash = 1469598103934665603ULL) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < bytes; i++) {
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+inline uint64_t graphHeaderChecksum(const GraphFileHeader& header) {
+    return fnv1a(&header, offsetof(GraphFileHeader, headerChecksum));
+}
+
+// Write g as a graph file
+inline bool writeGraphFile(const CsrGraph& g, const std::string& path, std::string& error) {
+    std::ofstream out(path.c_str(), std::ios::binary);
+    if (!out) {
+        error = "cannot open " + path + " for writing";
+        return false;
+    }
+
+    const CsrArrays& a = g.arrays();
+    const void* data[SECTION_COUNT] = {
+        a.xs, a.ys, a.nameOffsets,
+        a.offsets, a.targets, a.weights,
+        a.inOffsets, a.inSources, a.inEdges,
+        a.namePool, a.nameIndex
+    };
+    uint64_t nodes = a.numNodes, edges = a.numEdges;
+    uint64_t bytes[SECTION_COUNT] = {
+        nodes * sizeof(double), nodes * sizeof(double), (nodes + 1) * sizeof(uint32_t),
+        (nodes + 1) * sizeof(EdgeId), edges * sizeof(NodeId), edges * sizeof(double),
+        (nodes + 1) * sizeof(EdgeId), edges * sizeof(NodeId), edges * sizeof(EdgeId),
+        g.namePoolSize(), nodes * sizeof(NodeId)
+    };
+
+    GraphFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, GRAPH_FILE_MAGIC, sizeof(header.magic));
+    header.version = GRAPH_FILE_VERSION;
+    header.byteOrder = GRAPH_FILE_BYTE_ORDER;
+    header.headerBytes = sizeof(GraphFileHeader);
+    header.numNodes = a.numNodes;
+    header.numEdges = a.numEdges;
+    header.namePoolBytes = g.namePoolSize();
+
+    // Placeholder header; rewritten once the checksum is known
+    out.write((const char*)&header, sizeof(header));
+    static const char padding[GRAPH_FILE_ALIGNMENT] = {0};
+    uint64_t position = sizeof(header);
+    uint64_t checksum = fnv1a(nullptr, 0);
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        uint64_t pad = (GRAPH_FILE_ALIGNMENT - position % GRAPH_FILE_ALIGNMENT) % GRAPH_FILE_ALIGNMENT;
+        out.write(padding, pad);
+        checksum = fnv1a(padding, pad, checksum);
+        position += pad;
+
+        header.sectionOffset[s] = position;
+        header.sectionBytes[s] = bytes[s];
+        out.write((const char*)data[s], bytes[s]);
+        checksum = fnv1a(data[s], bytes[s], checksum);
+        position += bytes[s];
+    }
+    header.fileBytes = position;
+    header.payloadChecksum = checksum;
+    header.headerChecksum = graphHeaderChecksum(header);
+
+    out.seekp(0);
+    out.write((const char*)&header, sizeof(header));
+    if (!out) {
+        error = "write to " + path + " failed";
+        return false;
+    }
+    return true;
+}
+
+// Read-only mapping of a whole file, unmapped when the last owner goes away
+class MappedFile {
+public:
+    MappedFile() : base(nullptr), length(0) {}
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path, std::string& error) {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            error = "cannot open " + path;
+            return false;
+        }
+        LARGE_INTEGER size;
+        GetFileSizeEx(file, &size);
+        length = (size_t)size.QuadPart;
+        HANDLE mapping = length ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+        CloseHandle(file);
+        if (mapping == nullptr) {
+            error = "cannot map " + path;
+            return false;
+        }
+        base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = "cannot open " + path;
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            ::close(fd);
+            error = "cannot map " + path;
+            return false;
+        }
+        length = (size_t)info.st_size;
+        base = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) base = nullptr;
+#endif
+        if (base == nullptr) {
+            error = "cannot map " + path;
+            return false;
+        }
+        return true;
+    }
+
+    const char* data() const { return (const char*)base; }
+    size_t size() const { return length; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    void close() {
+        if (base == nullptr) return;
+#ifdef _WIN32
+        UnmapViewOfFile(base);
+#else
+        munmap(base, length);
+#endif
+        base = nullptr;
+    }
+
+    void* base;
+    size_t length;
+};
+
+// Map a graph file and point g at it without parsing or copying. With
+// verify set the payload checksum is checked too, which reads the file.
+inline bool openGraphFile(const std::string& path, CsrGraph& g, std::string& error, bool verify = false) {
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+    if (!file->open(path, error)) return false;
+
+    GraphFileHeader header;
+    if (file->size() < sizeof(header)) {
+        error = path + " is not a graph file";
+        return false;
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, GRAPH_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        error = path + " is not a graph file";
+        return false;
+    }
+    if (header.version != GRAPH_FILE_VERSION || header.headerBytes != sizeof(header)) {
+        error = path + " has an unsupported version";
+        return false;
+    }
+    if (header.byteOrder != GRAPH_FILE_BYTE_ORDER) {
+        error = path + " was written on a machine with a different byte order";
+        return false;
+    }
+    if (header.headerChecksum != graphHeaderChecksum(header) || header.fileBytes != file->size()) {
+        error = path + " is corrupt or truncated";
+        return false;
+    }
+
+    uint64_t nodes = header.numNodes, edges = header.numEdges;
+    uint64_t expected[SECTION_COUNT] = {
+        nodes * sizeof(double), nodes * sizeof(double), (nodes + 1) * sizeof(uint32_t),
+        (nodes + 1) * sizeof(EdgeId), edges * sizeof(NodeId), edges * sizeof(double),
+        (nodes + 1) * sizeof(EdgeId), edges * sizeof(NodeId), edges * sizeof(EdgeId),
+        header.namePoolBytes, nodes * sizeof(NodeId)
+    };
+    const char* section[SECTION_COUNT];
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        if (header.sectionBytes[s] != expected[s] || header.sectionOffset[s] % GRAPH_FILE_ALIGNMENT != 0 ||
+            header.sectionOffset[s] + header.sectionBytes[s] > header.fileBytes) {
+            error = path + " has a corrupt section table";
+            return false;
+        }
+        section[s] = file->data() + header.sectionOffset[s];
+    }
+
+    if (verify) {
+        uint64_t begin = sizeof(header);
+        if (fnv1a(file->data() + begin, header.fileBytes - begin) != header.payloadChecksum) {
+            error = path + " failed its checksum";
+            return false;
+        }
+    }
+
+    CsrArrays a;
+    a.numNodes = header.numNodes;
+    a.numEdges = header.numEdges;
+    a.xs = (const double*)section[SECTION_X];
+    a.ys = (const double*)section[SECTION_Y];
+    a.nameOffsets = (const uint32_t*)section[SECTION_NAME_OFFSETS];
+    a.offsets = (const EdgeId*)section[SECTION_OFFSETS];
+    a.targets = (const NodeId*)section[SECTION_TARGETS];
+    a.weights = (const double*)section[SECTION_WEIGHTS];
+    a.inOffsets = (const EdgeId*)section[SECTION_IN_OFFSETS];
+    a.inSources = (const NodeId*)section[SECTION_IN_SOURCES];
+    a.inEdges = (const EdgeId*)section[SECTION_IN_EDGES];
+    a.namePool = section[SECTION_NAME_POOL];
+    a.nameIndex = (const NodeId*)section[SECTION_NAME_INDEX];
+
+    // Cheap consistency check on the two arrays everything else hangs off
+    if (a.offsets[a.numNodes] != a.numEdges || a.nameOffsets[a.numNodes] != header.namePoolBytes) {
+        error = path + " is corrupt";
+        return false;
+    }
+
+    g = CsrGraph(a, file);
+    return true;
+}
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef GRAPH_GENERATORS_H
+#define GRAPH_GENERATORS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "csr_graph.h"
+#include "grid_map.h"
+
+// Reproducible synthetic graphs for benchmarking. Every generator takes a
+// seed and produces the same graph for the same arguments. Edge weights
+// are never below the Euclidean distance between their endpoints, so the
+// Euclidean heuristic stays admissible.
+
+// 8-connected grid; weights are step length times a random factor in [1, 1.5)
+inline CsrGraph makeGridGraph(uint32_t width, uint32_t height, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> factor(1.0, 1.5);
+    CsrBuilder builder;
+
+    for (uint32_t r = 0; r < height; r++) {
+        for (uint32_t c = 0; c < width; c++) {
+            builder.addNode("g" + std::to_string(r) + "_" + std::to_string(c), c, r);
+        }
+    }
+
+    const int dr[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+    const int dc[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+    for (uint32_t r = 0; r < height; r++) {
+        for (uint32_t c = 0; c < width; c++) {
+            for (int k = 0; k < 8; k++) {
+                int nr = (int)r + dr[k];
+                int nc = (int)c + dc[k];
+                if (nr < 0 || nc < 0 || nr >= (int)height || nc >= (int)width) continue;
+                double step = (dr[k] != 0 && dc[k] != 0) ? std::sqrt(2.0) : 1.0;
+                builder.addEdge(r * width + c, (NodeId)nr * width + (NodeId)nc, step * factor(rng));
+            }
+        }
+    }
+    return builder.finalize();
+}
+
+// Road-like random geometric graph: n points in a square of side sqrt(n),
+// each linked both ways to about its k nearest neighbours (bucket-grid search)
+inline CsrGraph makeRoadGraph(uint32_t n, uint32_t k, uint32_t seed) {
+    std::mt19937 rng(seed);
+    double side = std::sqrt((double)n);
+    std::uniform_real_distribution<double> coord(0.0, side);
+    std::uniform_real_distribution<double> factor(1.0, 1.3);
+    CsrBuilder builder;
+
+    std::vector<double> xs(n), ys(n);
+    for (uint32_t i = 0; i < n; i++) {
+        xs[i] = coord(rng);
+        ys[i] = coord(rng);
+        builder.addNode("r" + std::to_string(i), xs[i], ys[i]);
+    }
+
+    // Unit-sized buckets hold about one point each
+    uint32_t cells = std::max<uint32_t>(1, (uint32_t)side);
+    std::vector<std::vector<NodeId> > bucket((size_t)cells * cells);
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t cx = std::min(cells - 1, (uint32_t)xs[i]);
+        uint32_t cy = std::min(cells - 1, (uint32_t)ys[i]);
+        bucket[(size_t)cy * cells + cx].push_back(i);
+    }
+
+    std::vector<std::pair<double, NodeId> > candidates;
+    for (uint32_t i = 0; i < n; i++) {
+        int cx = std::min<int>(cells - 1, (int)xs[i]);
+        int cy = std::min<int>(cells - 1, (int)ys[i]);
+        // Grow the search ring until it holds enough candidates
+        for (int radius = 1; ; radius++) {
+            candidates.clear();
+            for (int y = cy - radius; y <= cy + radius; y++) {
+                for (int x = cx - radius; x <= cx + radius; x++) {
+                    if (x < 0 || y < 0 || x >= (int)cells || y >= (int)cells) continue;
+                    const std::vector<NodeId>& b = bucket[(size_t)y * cells + x];
+                    for (size_t j = 0; j < b.size(); j++) {
+                        if (b[j] == i) continue;
+                        double dx = xs[b[j]] - xs[i], dy = ys[b[j]] - ys[i];
+                        candidates.push_back(std::make_pair(dx * dx + dy * dy, b[j]));
+                    }
+                }
+            }
+            if (candidates.size() >= k || radius >= (int)cells) break;
+        }
+        size_t take = std::min<size_t>(k, candidates.size());
+        std::partial_sort(candidates.begin(), candidates.begin() + take, candidates.end());
+        for (size_t j = 0; j < take; j++) {
+            double w = std::sqrt(candidates[j].first) * factor(rng);
+            builder.addEdge(i, candidates[j].second, w);
+            builder.addEdge(candidates[j].second, i, w);
+        }
+    }
+    return builder.finalize();
+}
+
+// Grid map with random rectangular obstacles covering about density of
+// the cells, like a warehouse floor or game level
+inline GridMap makeObstacleGridMap(uint32_t width, uint32_t height, double density, uint32_t seed) {
+    std::mt19937 rng(seed);
+    GridMap map(width, height);
+    uint64_t target = (uint64_t)(density * width * height), blocked = 0;
+    std::uniform_int_distribution<uint32_t> size(1, std::max<uint32_t>(1, std::min(width, height) / 16));
+    while (blocked < target) {
+        uint32_t w = size(rng), h = size(rng);
+        uint32_t x0 = rng() % width, y0 = rng() % height;
+        for (uint32_t y = y0; y < std::min(height, y0 + h); y++) {
+            for (uint32_t x = x0; x < std::min(width, x0 + w); x++) {
+                if (map.passable(x, y)) {
+                    map.setPassable(x, y, false);
+                    blocked++;
+                }
+            }
+        }
+    }
+    return map;
+}
+
+// The free cells of a grid map as a graph with the grid search move
+// rules: straight steps cost 1, diagonal ones sqrt(2) and may not cut a
+// corner. cellOf, if given, receives the map cell of every node.
+inline CsrGraph makeGridMapGraph(const GridMap& map, std::vector<NodeId>* cellOf = nullptr) {
+    CsrBuilder builder;
+    std::vector<NodeId> nodeOf(map.cellCount(), INVALID_NODE);
+    if (cellOf) cellOf->clear();
+    for (uint32_t y = 0; y < map.height(); y++) {
+        for (uint32_t x = 0; x < map.width(); x++) {
+            if (!map.passable(x, y)) continue;
+            nodeOf[map.cellId(x, y)] = builder.addNode("g" + std::to_string(y) + "_" + std::to_string(x), x, y);
+            if (cellOf) cellOf->push_back(map.cellId(x, y));
+        }
+    }
+
+    const int dx[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+    const int dy[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+    for (uint32_t y = 0; y < map.height(); y++) {
+        for (uint32_t x = 0; x < map.width(); x++) {
+            NodeId u = nodeOf[map.cellId(x, y)];
+            if (u == INVALID_NODE) continue;
+            for (int k = 0; k < 8; k++) {
+                int nx = (int)x + dx[k], ny = (int)y + dy[k];
+                if (!map.passable(nx, ny)) continue;
+                bool diagonal = dx[k] != 0 && dy[k] != 0;
+                if (diagonal && (!map.passable(nx, y) || !map.passable(x, ny))) continue;
+                builder.addEdge(u, nodeOf[map.cellId(nx, ny)], diagonal ? std::sqrt(2.0) : 1.0);
+            }
+        }
+    }
+    return builder.finalize();
+}
+
+// Scale-free graph (Barabasi-Albert): every new node links both ways to
+// m earlier nodes picked with probability proportional to their degree.
+// Nodes are scattered in a square of side sqrt(n) and weights are the
+// Euclidean length times a random factor in [1, 1.3).
+inline CsrGraph makeScaleFreeGraph(uint32_t n, uint32_t m, uint32_t seed) {
+    std::mt19937 rng(seed);
+    double side = std::sqrt((double)n);
+    std::uniform_real_distribution<double> coord(0.0, side);
+    std::uniform_real_distribution<double> factor(1.0, 1.3);
+    CsrBuilder builder;
+
+    std::vector<double> xs(n), ys(n);
+    for (uint32_t i = 0; i < n; i++) {
+        xs[i] = coord(rng);
+        ys[i] = coord(rng);
+        builder.addNode("s" + std::to_string(i), xs[i], ys[i]);
+    }
+
+    // Every edge endpoint once, so a uniform pick is degree-proportional
+    std::vector<NodeId> endpoints;
+    endpoints.reserve((size_t)n * m * 2);
+    std::vector<NodeId> picked;
+    for (uint32_t i = 1; i < n; i++) {
+        picked.clear();
+        if (i <= m) {
+            for (uint32_t j = 0; j < i; j++) picked.push_back(j);
+        } else {
+            while (picked.size() < m) {
+                NodeId v = endpoints[rng() % endpoints.size()];
+                if (std::find(picked.begin(), picked.end(), v) == picked.end()) picked.push_back(v);
+            }
+        }
+        for (size_t j = 0; j < picked.size(); j++) {
+            NodeId v = picked[j];
+            double dx = xs[v] - xs[i], dy = ys[v] - ys[i];
+            double w = std::sqrt(dx * dx + dy * dy) * factor(rng);
+            builder.addEdge(i, v, w);
+            builder.addEdge(v, i, w);
+            endpoints.push_back(i);
+            endpoints.push_back(v);
+        }
+    }
+    return builder.finalize();
+}
+
+// Fixed set of random (start, goal) pairs
+inline std::vector<std::pair<NodeId, NodeId> > makeQueries(NodeId numNodes, size_t count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<NodeId> pick(0, numNodes - 1);
+    std::vector<std::pair<NodeId, NodeId> > queries(count);
+    for (size_t i = 0; i < count; i++) {
+        queries[i].first = pick(rng);
+        queries[i].second = pick(rng);
+    }
+    return queries;
+}
+
+#endif
@@ -0,0 +1,689 @@
+#ifndef GRAPH_IMPORT_H
+#define GRAPH_IMPORT_H
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "csr_graph.h"
+#include "graph_file.h"
+#include "parallel.h"
+
+// Counters a caller can poll from another thread while an import runs.
+// Importers never print anything themselves.
+struct ImportProgress {
+    std::atomic<uint64_t> bytes, lines, nodes, edges;
+    ImportProgress() : bytes(0), lines(0), nodes(0), edges(0) {}
+};
+
+struct ImportOptions {
+    unsigned threads;         // parser threads, 0 = all cores
+    size_t chunkBytes;        // inputs are split at line breaks into pieces of about this size
+    ImportProgress* progress; // optional
+    ImportOptions() : threads(0), chunkBytes(4 << 20), progress(nullptr) {}
+};
+
+// Bulk loaders that build a CsrGraph straight from large text inputs:
+//   DIMACS shortest-path files   .gr ("p sp n m", "a u v w") and .co ("v id x y")
+//   edge lists                   "from to [weight]" per line, '#' or '%' comments
+//   CSV                          nodes "id,x,y" and edges "from,to[,weight]",
+//                                optional header line of column names, optional quotes
+// Inputs are memory-mapped and cut into chunks parsed in parallel. Names
+// are interned in parallel by hash shard, and the CSR is built in one
+// counting-sort pass (CsrBuilder::assemble). DIMACS node ids become the
+// names "1".."n" and keep their order.
+class GraphImporter {
+public:
+    explicit GraphImporter(const ImportOptions& importOptions = ImportOptions()) : options(importOptions) {
+        if (options.threads == 0) options.threads = defaultThreadCount();
+        if (options.chunkBytes == 0) options.chunkBytes = 4 << 20;
+    }
+
+    // coPath may be empty, in which case all coordinates are 0
+    bool dimacs(const std::string& grPath, const std::string& coPath, CsrGraph& g, std::string& error) {
+        MappedFile gr;
+        if (!gr.open(grPath, error)) return false;
+        std::vector<Chunk> chunks = split(gr, ' ');
+        parallelFor(chunks.size(), options.threads, [this, &chunks](size_t c, unsigned) {
+            parseChunk(chunks[c], &GraphImporter::dimacsArc);
+        }, 1);
+        if (!firstError(chunks, grPath, error)) return false;
+
+        uint64_t n = 0;
+        size_t problemLines = 0;
+        NodeId maxId = 0;
+        for (size_t c = 0; c < chunks.size(); c++) {
+            if (chunks[c].declaredNodes != NO_DECLARATION) {
+                n = chunks[c].declaredNodes;
+                problemLines++;
+            }
+            maxId = std::max(maxId, chunks[c].maxId);
+        }
+        if (problemLines != 1) {
+            error = grPath + ": expected exactly one 'p sp <nodes> <arcs>' line";
+            return false;
+        }
+        if (n >= INVALID_NODE || (n > 0 && maxId >= n) || (n == 0 && totalEdges(chunks) > 0)) {
+            error = grPath + ": arc endpoint outside 1.." + std::to_string(n);
+            return false;
+        }
+
+        std::shared_ptr<CsrStorage> storage = std::make_shared<CsrStorage>();
+        storage->xs.assign(n, 0.0);
+        storage->ys.assign(n, 0.0);
+        if (!coPath.empty() && !dimacsCoordinates(coPath, *storage, error)) return false;
+        numericNames(*storage, (NodeId)n);
+
+        std::vector<NodeId> from, to;
+        std::vector<double> weight;
+        gatherEdges(chunks, from, to, weight);
+        if (options.progress) options.progress->nodes += n;
+        g = CsrBuilder::assemble(storage, from.data(), to.data(), weight.data(), from.size(), false, options.threads);
+        return true;
+    }
+
+    bool edgeList(const std::string& path, CsrGraph& g, std::string& error) {
+        MappedFile file;
+        if (!file.open(path, error)) return false;
+        std::vector<Chunk> chunks = split(file, ' ');
+        parallelFor(chunks.size(), options.threads, [this, &chunks](size_t c, unsigned) {
+            parseChunk(chunks[c], &GraphImporter::namedEdge);
+        }, 1);
+        if (!firstError(chunks, path, error)) return false;
+        return buildNamed(chunks, 0, g, error);
+    }
+
+    // nodesPath may be empty; nodes then come from the edge file only
+    bool csv(const std::string& nodesPath, const std::string& edgesPath, CsrGraph& g, std::string& error) {
+        MappedFile nodesFile, edgesFile;
+        std::vector<Chunk> chunks;
+        size_t nodeChunks = 0;
+        if (!nodesPath.empty()) {
+            if (!nodesFile.open(nodesPath, error)) return false;
+            chunks = split(nodesFile, ',');
+            nodeChunks = chunks.size();
+        }
+        if (!edgesFile.open(edgesPath, error)) return false;
+        std::vector<Chunk> edgeChunks = split(edgesFile, ',');
+        chunks.insert(chunks.end(), edgeChunks.begin(), edgeChunks.end());
+
+        parallelFor(chunks.size(), options.threads, [this, &chunks, nodeChunks](size_t c, unsigned) {
+            parseChunk(chunks[c], c < nodeChunks ? &GraphImporter::csvNode : &GraphImporter::namedEdge);
+        }, 1);
+        std::vector<Chunk> nodePart(chunks.begin(), chunks.begin() + nodeChunks);
+        if (!firstError(nodePart, nodesPath, error)) return false;
+        std::vector<Chunk> edgePart(chunks.begin() + nodeChunks, chunks.end());
+        if (!firstError(edgePart, edgesPath, error)) return false;
+        return buildNamed(chunks, nodeChunks, g, error);
+    }
+
+private:
+    static const uint32_t SHARDS = 64;
+    static const uint64_t NO_DECLARATION = ~0ULL;
+
+    // Name as a slice of the mapped input. Names of up to 8 bytes
+    // compare by hash, length and prefix alone, without touching the input.
+    struct NameRef {
+        const char* data;
+        uint32_t length;
+        uint32_t hash;
+        uint64_t prefix;
+    };
+
+    // A name and the record slot it was read for, listed by shard
+    struct ShardEntry {
+        NameRef name;
+        uint32_t ref;
+    };
+
+    // One piece of an input file and everything parsed from it
+    struct Chunk {
+        const char* begin;
+        const char* end;
+        char separator;     // ',' for CSV, otherwise blanks
+        uint64_t lines;
+        std::vector<NodeId> from, to; // DIMACS ids
+        std::vector<double> weight;
+        std::vector<double> xs, ys;   // one per node record
+        std::vector<uint8_t> shardOf; // per name read: edge records from, to; node records id
+        std::vector<NodeId> ids;      // interned id of each name read
+        std::vector<ShardEntry> byShard[SHARDS];
+        uint64_t declaredNodes;
+        NodeId maxId;
+        bool headerChecked;
+        uint64_t errorLine;
+        std::string errorText;
+    };
+
+    typedef bool (GraphImporter::*LineParser)(Chunk&, const char*, const char*);
+
+    // Cut the mapped file into chunks that end on line breaks
+    std::vector<Chunk> split(const MappedFile& file, char separator) const {
+        std::vector<Chunk> chunks;
+        const char* data = file.data();
+        const char* end = data + file.size();
+        for (const char* p = data; p < end;) {
+            const char* stop = p + std::min<size_t>(options.chunkBytes, end - p);
+            if (stop < end) {
+                const char* lineEnd = (const char*)std::memchr(stop, '\n', end - stop);
+                stop = lineEnd ? lineEnd + 1 : end;
+            }
+            Chunk chunk;
+            chunk.begin = p;
+            chunk.end = stop;
+            chunk.separator = separator;
+            chunk.lines = 0;
+            chunk.declaredNodes = NO_DECLARATION;
+            chunk.maxId = 0;
+            chunk.headerChecked = p != data; // only the first chunk can hold a header
+            chunk.errorLine = 0;
+            chunks.push_back(chunk);
+            p = stop;
+        }
+        return chunks;
+    }
+
+    void parseChunk(Chunk& chunk, LineParser parser) {
+        // Room for records of about 16 bytes; longer lines just grow less often
+        size_t expected = (chunk.end - chunk.begin) / 16;
+        if (parser == &GraphImporter::dimacsArc) {
+            chunk.from.reserve(expected);
+            chunk.to.reserve(expected);
+            chunk.weight.reserve(expected);
+        }
+        for (const char* p = chunk.begin; p < chunk.end;) {
+            const char* lineEnd = (const char*)std::memchr(p, '\n', chunk.end - p);
+            if (!lineEnd) lineEnd = chunk.end;
+            chunk.lines++;
+            if (!(this->*parser)(chunk, p, lineEnd)) {
+                chunk.errorLine = chunk.lines;
+                break;
+            }
+            p = lineEnd + 1;
+        }
+        if (options.progress) {
+            options.progress->bytes += chunk.end - chunk.begin;
+            options.progress->lines += chunk.lines;
+            options.progress->edges += chunk.weight.size();
+        }
+    }
+
+    // Report the first failing line over all chunks of one file
+    static bool firstError(const std::vector<Chunk>& chunks, const std::string& path, std::string& error) {
+        uint64_t line = 0;
+        for (size_t c = 0; c < chunks.size(); c++) {
+            if (chunks[c].errorLine != 0) {
+                error = path + ":" + std::to_string(line + chunks[c].errorLine) + ": " + chunks[c].errorText;
+                return false;
+            }
+            line += chunks[c].lines;
+        }
+        return true;
+    }
+
+    static size_t totalEdges(const std::vector<Chunk>& chunks) {
+        size_t total = 0;
+        for (size_t c = 0; c < chunks.size(); c++) total += chunks[c].weight.size();
+        return total;
+    }
+
+    // --- Field scanning -------------------------------------------------
+
+    static bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    static void skipBlanks(const char*& p, const char* end) {
+        while (p < end && isBlank(*p)) p++;
+    }
+
+    static bool atLineEnd(const char* p, const char* end) {
+        while (p < end && isBlank(*p)) p++;
+        return p == end;
+    }
+
+    static bool parseUnsigned(const char*& p, const char* end, uint64_t& value) {
+        skipBlanks(p, end);
+        const char* start = p;
+        value = 0;
+        while (p < end && *p >= '0' && *p <= '9') value = value * 10 + (uint64_t)(*p++ - '0');
+        return p != start && p - start <= 19;
+    }
+
+    // Decimal number with optional sign, fraction and exponent. Values
+    // with at most 15 significant digits and a small exponent are exact
+    // (one multiply or divide by an exact power of ten); anything else
+    // goes through strtod.
+    static bool parseNumber(const char*& p, const char* end, double& value) {
+        static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        skipBlanks(p, end);
+        const char* start = p;
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+        uint64_t mantissa = 0;
+        int digits = 0, scale = 0;
+        bool any = false;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (mantissa != 0 || *p != '0') digits++;
+            mantissa = mantissa * 10 + (uint64_t)(*p++ - '0');
+            any = true;
+        }
+        if (p < end && *p == '.') {
+            p++;
+            while (p < end && *p >= '0' && *p <= '9') {
+                if (mantissa != 0 || *p != '0') digits++;
+                mantissa = mantissa * 10 + (uint64_t)(*p++ - '0');
+                scale--;
+                any = true;
+            }
+        }
+        if (!any) return false;
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            const char* e = p + 1;
+            bool expNegative = false;
+            if (e < end && (*e == '-' || *e == '+')) expNegative = *e++ == '-';
+            int exponent = 0;
+            const char* expStart = e;
+            while (e < end && *e >= '0' && *e <= '9' && exponent < 10000) exponent = exponent * 10 + (*e++ - '0');
+            if (e == expStart) return false;
+            scale += expNegative ? -exponent : exponent;
+            p = e;
+        }
+
+        if (digits <= 15 && scale >= -22 && scale <= 22) {
+            value = (double)mantissa;
+            value = scale < 0 ? value / powers[-scale] : value * powers[scale];
+        } else {
+            char buffer[128];
+            size_t length = std::min<size_t>(p - start, sizeof(buffer) - 1);
+            std::memcpy(buffer, start, length);
+            buffer[length] = '\0';
+            value = std::strtod(buffer, nullptr);
+            negative = false;
+        }
+        if (negative) value = -value;
+        return true;
+    }
+
+    // Next field: up to a blank (separator ' ') or up to separator,
+    // trimmed and without surrounding double quotes
+    static bool parseField(const char*& p, const char* end, char separator, const char*& data, uint32_t& length) {
+        skipBlanks(p, end);
+        const char* start = p;
+        if (separator == ' ') {
+            while (p < end && !isBlank(*p)) p++;
+        } else {
+            while (p < end && *p != separator) p++;
+        }
+        const char* stop = p;
+        while (stop > start && isBlank(stop[-1])) stop--;
+        if (stop - start >= 2 && *start == '"' && stop[-1] == '"') {
+            start++;
+            stop--;
+        }
+        data = start;
+        length = (uint32_t)(stop - start);
+        return length > 0;
+    }
+
+    // Step over the separator after a CSV field
+    static bool nextField(const char*& p, const char* end, char separator) {
+        skipBlanks(p, end);
+        if (separator == ' ') return true;
+        if (p < end && *p == separator) {
+            p++;
+            return true;
+        }
+        return false;
+    }
+
+    void addRef(Chunk& chunk, const char* data, uint32_t length) {
+        uint64_t hash = fnv1a(data, length);
+        ShardEntry entry;
+        entry.name.data = data;
+        entry.name.length = length;
+        entry.name.hash = (uint32_t)hash;
+        entry.name.prefix = namePrefixKey(data, length);
+        entry.ref = (uint32_t)chunk.shardOf.size();
+        uint8_t shard = (uint8_t)(hash >> 58);
+        chunk.byShard[shard].push_back(entry);
+        chunk.shardOf.push_back(shard);
+    }
+
+    // Names accepted for each CSV column, '|'-separated and lower case
+    static const char* const* edgeColumns() {
+        static const char* const columns[] = {"from|source|src|u|start|tail", "to|target|dst|v|goal|end|head",
+                                              "weight|cost|w|length|distance|time"};
+        return columns;
+    }
+
+    static const char* const* nodeColumns() {
+        static const char* const columns[] = {"id|name|node", "x|lon|lng|longitude", "y|lat|latitude"};
+        return columns;
+    }
+
+    // True if the line names the columns instead of holding a record: at
+    // least required and at most count fields, each a name accepted for
+    // its column, compared ignoring case. Only this is taken as a header,
+    // so a record or a malformed first line is never skipped.
+    static bool headerLine(const char* p, const char* end, const char* const* columns, size_t required,
+                           size_t count) {
+        for (size_t c = 0; c < count; c++) {
+            if (c > 0 && !nextField(p, end, ',')) return c >= required && atLineEnd(p, end);
+            const char* name;
+            uint32_t length;
+            if (!parseField(p, end, ',', name, length) || !columnNamed(name, length, columns[c])) return false;
+        }
+        return atLineEnd(p, end);
+    }
+
+    static bool columnNamed(const char* name, uint32_t length, const char* names) {
+        for (const char* option = names; *option;) {
+            const char* stop = option;
+            while (*stop && *stop != '|') stop++;
+            if ((size_t)(stop - option) == length) {
+                uint32_t i = 0;
+                while (i < length && (char)std::tolower((unsigned char)name[i]) == option[i]) i++;
+                if (i == length) return true;
+            }
+            option = *stop ? stop + 1 : stop;
+        }
+        return false;
+    }
+
+    static bool fail(Chunk& chunk, const char* message) {
+        chunk.errorText = message;
+        return false;
+    }
+
+    // --- Line formats ---------------------------------------------------
+
+    bool dimacsArc(Chunk& chunk, const char* p, const char* end) {
+        skipBlanks(p, end);
+        if (p == end || *p == 'c') return true;
+        if (*p == 'p') {
+            p++;
+            const char* kind;
+            uint32_t kindLength;
+            uint64_t n, m;
+            if (!parseField(p, end, ' ', kind, kindLength) || !parseUnsigned(p, end, n) || !parseUnsigned(p, end, m)) {
+                return fail(chunk, "expected 'p sp <nodes> <arcs>'");
+            }
+            chunk.declaredNodes = n;
+            return true;
+        }
+        if (*p != 'a') return fail(chunk, "expected a 'c', 'p' or 'a' line");
+        p++;
+        uint64_t u, v;
+        double w;
+        if (!parseUnsigned(p, end, u) || !parseUnsigned(p, end, v) || !parseNumber(p, end, w) || !atLineEnd(p, end)) {
+            return fail(chunk, "expected 'a <from> <to> <weight>'");
+        }
+        if (u == 0 || v == 0 || u > INVALID_NODE || v > INVALID_NODE) return fail(chunk, "node ids start at 1");
+        if (w < 0) return fail(chunk, "negative weight");
+        chunk.from.push_back((NodeId)(u - 1));
+        chunk.to.push_back((NodeId)(v - 1));
+        chunk.weight.push_back(w);
+        chunk.maxId = std::max(chunk.maxId, (NodeId)std::max(u - 1, v - 1));
+        return true;
+    }
+
+    bool dimacsCoordinate(Chunk& chunk, const char* p, const char* end) {
+        skipBlanks(p, end);
+        if (p == end || *p == 'c' || *p == 'p') return true;
+        if (*p != 'v') return fail(chunk, "expected a 'c', 'p' or 'v' line");
+        p++;
+        uint64_t id;
+        double x, y;
+        if (!parseUnsigned(p, end, id) || !parseNumber(p, end, x) || !parseNumber(p, end, y) || !atLineEnd(p, end)) {
+            return fail(chunk, "expected 'v <id> <x> <y>'");
+        }
+        if (id == 0 || id > INVALID_NODE) return fail(chunk, "node ids start at 1");
+        chunk.from.push_back((NodeId)(id - 1));
+        chunk.xs.push_back(x);
+        chunk.ys.push_back(y);
+        return true;
+    }
+
+    // "from to [weight]" (blank separated) or "from,to[,weight]" (CSV)
+    bool namedEdge(Chunk& chunk, const char* p, const char* end) {
+        skipBlanks(p, end);
+        if (p == end || *p == '#' || *p == '%') return true;
+        const char* line = p;
+        const char *fromName, *toName;
+        uint32_t fromLength, toLength;
+        double w = 1.0;
+        bool ok = parseField(p, end, chunk.separator, fromName, fromLength) && nextField(p, end, chunk.separator) &&
+                  parseField(p, end, chunk.separator, toName, toLength);
+        if (ok && !atLineEnd(p, end)) {
+            ok = nextField(p, end, chunk.separator) && parseNumber(p, end, w) && atLineEnd(p, end);
+        }
+        if (!chunk.headerChecked) {
+            chunk.headerChecked = true;
+            // A CSV file may start with a header line
+            if (chunk.separator == ',' && headerLine(line, end, edgeColumns(), 2, 3)) return true;
+        }
+        if (!ok) {
+            return fail(chunk, chunk.separator == ',' ? "expected 'from,to[,weight]'" : "expected 'from to [weight]'");
+        }
+        if (w < 0) return fail(chunk, "negative weight");
+        addRef(chunk, fromName, fromLength);
+        addRef(chunk, toName, toLength);
+        chunk.weight.push_back(w);
+        return true;
+    }
+
+    // "id,x,y"
+    bool csvNode(Chunk& chunk, const char* p, const char* end) {
+        skipBlanks(p, end);
+        if (p == end || *p == '#') return true;
+        if (!chunk.headerChecked) {
+            chunk.headerChecked = true;
+            if (headerLine(p, end, nodeColumns(), 3, 3)) return true;
+        }
+        const char* name;
+        uint32_t length;
+        double x, y;
+        bool ok = parseField(p, end, ',', name, length) && nextField(p, end, ',') && parseNumber(p, end, x) &&
+                  nextField(p, end, ',') && parseNumber(p, end, y) && atLineEnd(p, end);
+        if (!ok) return fail(chunk, "expected 'id,x,y'");
+        addRef(chunk, name, length);
+        chunk.xs.push_back(x);
+        chunk.ys.push_back(y);
+        return true;
+    }
+
+    // --- Building -------------------------------------------------------
+
+    bool dimacsCoordinates(const std::string& coPath, CsrStorage& storage, std::string& error) {
+        MappedFile co;
+        if (!co.open(coPath, error)) return false;
+        std::vector<Chunk> chunks = split(co, ' ');
+        parallelFor(chunks.size(), options.threads, [this, &chunks](size_t c, unsigned) {
+            parseChunk(chunks[c], &GraphImporter::dimacsCoordinate);
+        }, 1);
+        if (!firstError(chunks, coPath, error)) return false;
+
+        for (size_t c = 0; c < chunks.size(); c++) {
+            const Chunk& chunk = chunks[c];
+            for (size_t i = 0; i < chunk.from.size(); i++) {
+                if (chunk.from[i] >= storage.xs.size()) {
+                    error = coPath + ": node " + std::to_string(chunk.from[i] + 1) + " is not in the graph";
+                    return false;
+                }
+                storage.xs[chunk.from[i]] = chunk.xs[i];
+                storage.ys[chunk.from[i]] = chunk.ys[i];
+            }
+        }
+        return true;
+    }
+
+    // Names "1".."n" and their lexicographic order, generated directly
+    // (preorder of the decimal digit trie) instead of sorted
+    void numericNames(CsrStorage& storage, NodeId n) const {
+        storage.nameOffsets.resize((size_t)n + 1);
+        storage.nameOffsets[0] = 0;
+        for (NodeId u = 0; u < n; u++) {
+            uint32_t digits = 1;
+            for (uint64_t v = (uint64_t)u + 1; v >= 10; v /= 10) digits++;
+            storage.nameOffsets[u + 1] = storage.nameOffsets[u] + digits;
+        }
+        storage.namePool.resize(storage.nameOffsets[n]);
+        char* pool = storage.namePool.data();
+        const uint32_t* offsets = storage.nameOffsets.data();
+        parallelFor(n, options.threads, [pool, offsets](size_t u, unsigned) {
+            char* end = pool + offsets[u + 1];
+            for (uint64_t v = u + 1; end > pool + offsets[u]; v /= 10) *--end = (char)('0' + v % 10);
+        }, 65536);
+
+        storage.nameIndex.resize(n);
+        uint64_t value = 1;
+        for (NodeId i = 0; i < n; i++) {
+            storage.nameIndex[i] = (NodeId)(value - 1);
+            if (value * 10 <= n) {
+                value *= 10;
+            } else {
+                while (value % 10 == 9 || value + 1 > n) value /= 10;
+                value++;
+            }
+        }
+    }
+
+    // Concatenate the per-chunk DIMACS edge arrays
+    void gatherEdges(const std::vector<Chunk>& chunks, std::vector<NodeId>& from, std::vector<NodeId>& to,
+                     std::vector<double>& weight) const {
+        std::vector<size_t> start(chunks.size() + 1, 0);
+        for (size_t c = 0; c < chunks.size(); c++) start[c + 1] = start[c] + chunks[c].from.size();
+        from.resize(start.back());
+        to.resize(start.back());
+        weight.resize(start.back());
+        parallelFor(chunks.size(), options.threads, [&](size_t c, unsigned) {
+            std::copy(chunks[c].from.begin(), chunks[c].from.end(), from.begin() + start[c]);
+            std::copy(chunks[c].to.begin(), chunks[c].to.end(), to.begin() + start[c]);
+            std::copy(chunks[c].weight.begin(), chunks[c].weight.end(), weight.begin() + start[c]);
+        });
+    }
+
+    // Intern the names of all chunks (node chunks first) and build the
+    // graph. Each shard owns the names whose hash falls into it, so the
+    // shards are interned in parallel without locks; ids are then made
+    // global by offsetting each shard's ids.
+    bool buildNamed(std::vector<Chunk>& chunks, size_t nodeChunks, CsrGraph& g, std::string& error) {
+        std::vector<std::vector<NameRef> > unique(SHARDS);
+        for (size_t c = 0; c < chunks.size(); c++) chunks[c].ids.resize(chunks[c].shardOf.size());
+
+        parallelFor(SHARDS, options.threads, [&chunks, &unique](size_t s, unsigned) {
+            std::vector<uint32_t> table(1024, INVALID_NODE);
+            std::vector<NameRef>& names = unique[s];
+            for (size_t c = 0; c < chunks.size(); c++) {
+                Chunk& chunk = chunks[c];
+                const std::vector<ShardEntry>& list = chunk.byShard[s];
+                for (size_t i = 0; i < list.size(); i++) {
+                    const NameRef& ref = list[i].name;
+                    if (names.size() * 2 >= table.size()) rehash(table, names);
+                    size_t mask = table.size() - 1;
+                    size_t slot = (size_t)ref.hash & mask;
+                    while (table[slot] != INVALID_NODE && !sameName(names[table[slot]], ref)) {
+                        slot = (slot + 1) & mask;
+                    }
+                    if (table[slot] == INVALID_NODE) {
+                        table[slot] = (uint32_t)names.size();
+                        names.push_back(ref);
+                    }
+                    chunk.ids[list[i].ref] = table[slot];
+                }
+                std::vector<ShardEntry>().swap(chunk.byShard[s]);
+            }
+        });
+
+        std::vector<uint64_t> shardBase(SHARDS + 1, 0), byteBase(SHARDS + 1, 0);
+        for (uint32_t s = 0; s < SHARDS; s++) {
+            shardBase[s + 1] = shardBase[s] + unique[s].size();
+            uint64_t bytes = 0;
+            for (size_t i = 0; i < unique[s].size(); i++) bytes += unique[s][i].length;
+            byteBase[s + 1] = byteBase[s] + bytes;
+        }
+        if (shardBase[SHARDS] >= INVALID_NODE || byteBase[SHARDS] > 0xFFFFFFFFu) {
+            error = "too many nodes or names for one graph";
+            return false;
+        }
+        NodeId n = (NodeId)shardBase[SHARDS];
+
+        parallelFor(chunks.size(), options.threads, [&chunks, &shardBase](size_t c, unsigned) {
+            Chunk& chunk = chunks[c];
+            for (size_t i = 0; i < chunk.ids.size(); i++) chunk.ids[i] += (NodeId)shardBase[chunk.shardOf[i]];
+        });
+
+        // Name pool in id order
+        std::shared_ptr<CsrStorage> storage = std::make_shared<CsrStorage>();
+        CsrStorage& st = *storage;
+        st.namePool.resize(byteBase[SHARDS]);
+        st.nameOffsets.resize((size_t)n + 1);
+        st.nameOffsets[n] = (uint32_t)byteBase[SHARDS];
+        parallelFor(SHARDS, options.threads, [&](size_t s, unsigned) {
+            uint32_t offset = (uint32_t)byteBase[s];
+            for (size_t i = 0; i < unique[s].size(); i++) {
+                st.nameOffsets[shardBase[s] + i] = offset;
+                std::memcpy(&st.namePool[offset], unique[s][i].data, unique[s][i].length);
+                offset += unique[s][i].length;
+            }
+        });
+
+        st.xs.assign(n, 0.0);
+        st.ys.assign(n, 0.0);
+        for (size_t c = 0; c < nodeChunks; c++) {
+            for (size_t i = 0; i < chunks[c].ids.size(); i++) {
+                st.xs[chunks[c].ids[i]] = chunks[c].xs[i];
+                st.ys[chunks[c].ids[i]] = chunks[c].ys[i];
+            }
+        }
+
+        std::vector<size_t> start(chunks.size() + 1, 0);
+        for (size_t c = 0; c < chunks.size(); c++) {
+            start[c + 1] = start[c] + (c < nodeChunks ? 0 : chunks[c].weight.size());
+        }
+        std::vector<NodeId> from(start.back()), to(start.back());
+        std::vector<double> weight(start.back());
+        parallelFor(chunks.size() - nodeChunks, options.threads, [&](size_t k, unsigned) {
+            size_t c = nodeChunks + k;
+            const Chunk& chunk = chunks[c];
+            for (size_t e = 0; e < chunk.weight.size(); e++) {
+                from[start[c] + e] = chunk.ids[2 * e];
+                to[start[c] + e] = chunk.ids[2 * e + 1];
+                weight[start[c] + e] = chunk.weight[e];
+            }
+        });
+
+        if (options.progress) options.progress->nodes += n;
+        g = CsrBuilder::assemble(storage, from.data(), to.data(), weight.data(), from.size(), true, options.threads);
+        return true;
+    }
+
+    static bool sameName(const NameRef& a, const NameRef& b) {
+        return a.hash == b.hash && a.length == b.length && a.prefix == b.prefix &&
+               (a.length <= 8 || std::memcmp(a.data + 8, b.data + 8, a.length - 8) == 0);
+    }
+
+    static void rehash(std::vector<uint32_t>& table, const std::vector<NameRef>& names) {
+        table.assign(table.size() * 2, INVALID_NODE);
+        size_t mask = table.size() - 1;
+        for (uint32_t id = 0; id < names.size(); id++) {
+            size_t slot = (size_t)names[id].hash & mask;
+            while (table[slot] != INVALID_NODE) slot = (slot + 1) & mask;
+            table[slot] = id;
+        }
+    }
+
+    ImportOptions options;
+};
+
+const uint32_t GraphImporter::SHARDS;
+const uint64_t GraphImporter::NO_DECLARATION;
+
+#endif
@@ -0,0 +1,278 @@
+// Load generator for the query server (graph_astar --serve)
+//
+//   graph_loadgen <socket> [--requests N] [--connections C] [--window W]
+//                 [--op cost|path|reach] [--budget B] [--binary] [--seed S]
+//
+// Every connection keeps up to W requests in flight between random node
+// pairs (node ids taken from an info request) and times each one from
+// send to answer. Prints the sustained throughput and the latency
+// percentiles over all connections.
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "query_server.h"
+
+using namespace std;
+
+#ifdef __linux__
+
+struct LoadOptions {
+    string socketPath;
+    size_t requests = 100000;
+    unsigned connections = 1;
+    size_t window = 64;
+    string op = "cost";
+    double budget = 5;
+    bool binary = false;
+    unsigned seed = 1;
+};
+
+// Results of one connection
+struct ConnectionResult {
+    vector<double> latencyMicros;
+    size_t errors = 0, noPath = 0;
+    string failure;
+};
+
+int connectTo(const string& path, string& error) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        error = "socket path too long";
+        return -1;
+    }
+    memcpy(address.sun_path, path.c_str(), path.size());
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        error = "cannot connect to " + path + ": " + strerror(errno);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool sendAll(int fd, const string& bytes) {
+    size_t sent = 0;
+    while (sent < bytes.size()) {
+        ssize_t n = send(fd, bytes.data() + sent, bytes.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+// Node count of the served graph, through a text info request
+bool fetchNodeCount(const string& path, uint32_t& nodes, string& error) {
+    int fd = connectTo(path, error);
+    if (fd < 0) return false;
+    string reply;
+    char buffer[256];
+    bool ok = sendAll(fd, "0 info\n");
+    while (ok && reply.find('\n') == string::npos) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) break;
+        reply.append(buffer, (size_t)n);
+    }
+    close(fd);
+    istringstream fields(reply);
+    string id, status;
+    if (!(fields >> id >> status >> nodes) || status != "ok") {
+        error = "unexpected info reply: " + reply;
+        return false;
+    }
+    return true;
+}
+
+void runConnection(const LoadOptions& options, uint32_t nodes, size_t count, unsigned index,
+                   ConnectionResult& result) {
+    int fd = connectTo(options.socketPath, result.failure);
+    if (fd < 0) return;
+
+    mt19937 rng(options.seed + index);
+    uniform_int_distribution<uint32_t> pick(0, nodes - 1);
+    QueryOp op = options.op == "path" ? QUERY_PATH : options.op == "reach" ? QUERY_REACH : QUERY_COST;
+    vector<chrono::steady_clock::time_point> sentAt(count);
+    result.latencyMicros.reserve(count);
+
+    size_t sent = 0, received = 0;
+    string out, in;
+    size_t inStart = 0;
+    char buffer[64 << 10];
+    while (received < count) {
+        // Top the window up, in one write
+        out.clear();
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        while (sent < count && sent - received < options.window) {
+            uint32_t a = pick(rng), b = pick(rng);
+            if (options.binary) {
+                QueryFrame frame;
+                memset(&frame, 0, sizeof(frame));
+                frame.magic = QUERY_FRAME_MAGIC;
+                frame.op = op;
+                frame.id = (uint32_t)sent;
+                frame.a = a;
+                frame.b = b;
+                frame.arg = options.budget;
+                out.append((const char*)&frame, sizeof(frame));
+            } else if (op == QUERY_REACH) {
+                out += to_string(sent) + " reach #" + to_string(a) + " " + to_string(options.budget) + "\n";
+            } else {
+                out += to_string(sent) + " " + options.op + " #" + to_string(a) + " #" + to_string(b) + "\n";
+            }
+            sentAt[sent++] = now;
+        }
+        if (!out.empty() && !sendAll(fd, out)) {
+            result.failure = "connection lost while sending";
+            break;
+        }
+
+        ssize_t got = recv(fd, buffer, sizeof(buffer), 0);
+        if (got <= 0) {
+            result.failure = "connection closed by the server";
+            break;
+        }
+        in.append(buffer, (size_t)got);
+        now = chrono::steady_clock::now();
+
+        // Answers arrive in any order; match them to requests by id
+        while (inStart < in.size()) {
+            size_t id;
+            if (options.binary) {
+                if (in.size() - inStart < sizeof(ResponseFrame)) break;
+                ResponseFrame reply;
+                memcpy(&reply, in.data() + inStart, sizeof(reply));
+                size_t payload = 0;
+                if (reply.status == QUERY_OK && op == QUERY_PATH) payload = reply.count * sizeof(NodeId);
+                if (reply.status == QUERY_OK && op == QUERY_REACH) payload = reply.count * (sizeof(NodeId) + 8);
+                if (in.size() - inStart < sizeof(reply) + payload) break;
+                inStart += sizeof(reply) + payload;
+                id = reply.id;
+                if (reply.status == QUERY_ERROR) result.errors++;
+                if (reply.status == QUERY_NO_PATH) result.noPath++;
+            } else {
+                size_t end = in.find('\n', inStart);
+                if (end == string::npos) break;
+                const char* line = in.c_str() + inStart;
+                char* rest = nullptr;
+                id = strtoul(line, &rest, 10);
+                if (strncmp(rest, " error", 6) == 0) result.errors++;
+                if (strncmp(rest, " none", 5) == 0) result.noPath++;
+                inStart = end + 1;
+            }
+            if (id < count) {
+                result.latencyMicros.push_back(chrono::duration<double, micro>(now - sentAt[id]).count());
+            }
+            received++;
+        }
+        if (inStart > (1 << 20)) {
+            in.erase(0, inStart);
+            inStart = 0;
+        }
+    }
+    close(fd);
+}
+
+double percentile(const vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    return sorted[min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        cerr << "Usage: graph_loadgen <socket> [--requests N] [--connections C] [--window W]" << endl
+             << "                     [--op cost|path|reach] [--budget B] [--binary] [--seed S]" << endl;
+        return 1;
+    }
+    LoadOptions options;
+    options.socketPath = argv[1];
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        string value = i + 1 < argc ? argv[i + 1] : "";
+        if (arg == "--binary") {
+            options.binary = true;
+            continue;
+        }
+        i++;
+        if (arg == "--requests") options.requests = strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--connections") options.connections = (unsigned)atoi(value.c_str());
+        else if (arg == "--window") options.window = strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--op") options.op = value;
+        else if (arg == "--budget") options.budget = atof(value.c_str());
+        else if (arg == "--seed") options.seed = (unsigned)atoi(value.c_str());
+        else {
+            cerr << "Unknown option " << arg << endl;
+            return 1;
+        }
+    }
+    if (options.op != "cost" && options.op != "path" && options.op != "reach") {
+        cerr << "Unknown operation " << options.op << endl;
+        return 1;
+    }
+    options.connections = max(1u, options.connections);
+    options.window = max<size_t>(1, options.window);
+
+    string error;
+    uint32_t nodes = 0;
+    if (!fetchNodeCount(options.socketPath, nodes, error) || nodes == 0) {
+        cerr << "Error: " << (error.empty() ? "the graph is empty" : error) << endl;
+        return 1;
+    }
+
+    vector<ConnectionResult> results(options.connections);
+    vector<thread> threads;
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    for (unsigned c = 0; c < options.connections; c++) {
+        size_t count = options.requests / options.connections + (c < options.requests % options.connections);
+        threads.push_back(thread(runConnection, cref(options), nodes, count, c, ref(results[c])));
+    }
+    for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    vector<double> latencies;
+    size_t errors = 0, noPath = 0;
+    for (size_t c = 0; c < results.size(); c++) {
+        if (!results[c].failure.empty()) cerr << "Connection " << c << ": " << results[c].failure << endl;
+        latencies.insert(latencies.end(), results[c].latencyMicros.begin(), results[c].latencyMicros.end());
+        errors += results[c].errors;
+        noPath += results[c].noPath;
+    }
+    sort(latencies.begin(), latencies.end());
+
+    cout << latencies.size() << " " << options.op << " requests (" << (options.binary ? "binary" : "text")
+         << "), " << options.connections << " connections x " << options.window << " in flight, " << nodes
+         << " nodes" << endl;
+    cout << fixed << setprecision(0) << "  " << latencies.size() / seconds << " requests/s" << endl;
+    cout << setprecision(1) << "  latency p50 " << percentile(latencies, 0.5) << " us, p90 "
+         << percentile(latencies, 0.9) << " us, p99 " << percentile(latencies, 0.99) << " us, p99.9 "
+         << percentile(latencies, 0.999) << " us, max " << (latencies.empty() ? 0 : latencies.back()) << " us"
+         << endl;
+    cout << "  " << noPath << " without a path, " << errors << " errors" << endl;
+    return latencies.size() == options.requests ? 0 : 1;
+}
+
+#else
+
+int main() {
+    cerr << "graph_loadgen needs Linux (Unix sockets)" << endl;
+    return 1;
+}
+
+#endif
@@ -0,0 +1,203 @@
+#ifndef GRAPH_REORDER_H
+#define GRAPH_REORDER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+#include "parallel.h"
+
+// Node numberings that place nodes which are searched together next to
+// each other in memory, so relaxing an edge is less likely to miss the
+// cache on the target's g-score, coordinates and edge range.
+enum NodeOrder {
+    ORDER_HILBERT, // along a Hilbert curve over the coordinates
+    ORDER_BFS,     // breadth-first over the undirected graph
+    ORDER_RCM      // reverse Cuthill-McKee: BFS by increasing degree, reversed
+};
+
+inline const char* nodeOrderName(NodeOrder order) {
+    switch (order) {
+        case ORDER_HILBERT: return "hilbert";
+        case ORDER_BFS: return "bfs";
+        case ORDER_RCM: return "rcm";
+    }
+    return "?";
+}
+
+// Position of (x, y) along the Hilbert curve filling a 2^16 x 2^16 grid
+inline uint64_t hilbertIndex(uint32_t x, uint32_t y) {
+    const uint32_t side = 1u << 16;
+    uint64_t d = 0;
+    for (uint32_t s = side / 2; s > 0; s /= 2) {
+        uint32_t rx = (x & s) ? 1 : 0;
+        uint32_t ry = (y & s) ? 1 : 0;
+        d += (uint64_t)s * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant so the curve continues in the same orientation
+        if (ry == 0) {
+            if (rx == 1) {
+                x = side - 1 - x;
+                y = side - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+// Old node ids in their new order: newToOld[newId] = oldId
+inline std::vector<NodeId> computeNodeOrder(const CsrGraph& g, NodeOrder order, unsigned threads = 0) {
+    NodeId n = g.numNodes();
+    std::vector<NodeId> newToOld;
+    newToOld.reserve(n);
+    if (n == 0) return newToOld;
+
+    if (order == ORDER_HILBERT) {
+        double minX = g.x(0), maxX = g.x(0), minY = g.y(0), maxY = g.y(0);
+        for (NodeId u = 1; u < n; u++) {
+            minX = std::min(minX, g.x(u));
+            maxX = std::max(maxX, g.x(u));
+            minY = std::min(minY, g.y(u));
+            maxY = std::max(maxY, g.y(u));
+        }
+        double scaleX = maxX > minX ? 65535 / (maxX - minX) : 0;
+        double scaleY = maxY > minY ? 65535 / (maxY - minY) : 0;
+        std::vector<std::pair<uint64_t, NodeId> > keyed(n);
+        parallelFor(n, threads, [&](size_t u, unsigned) {
+            uint32_t cellX = (uint32_t)((g.x((NodeId)u) - minX) * scaleX);
+            uint32_t cellY = (uint32_t)((g.y((NodeId)u) - minY) * scaleY);
+            keyed[u] = std::make_pair(hilbertIndex(cellX, cellY), (NodeId)u);
+        }, 4096);
+        parallelSort(keyed.begin(), keyed.end(), std::less<std::pair<uint64_t, NodeId> >(), threads);
+        for (NodeId i = 0; i < n; i++) newToOld.push_back(keyed[i].second);
+        return newToOld;
+    }
+
+    // Both BFS orders walk edges in either direction, so one-way streets
+    // do not cut a component apart
+    std::vector<uint32_t> degree(n);
+    for (NodeId u = 0; u < n; u++) {
+        degree[u] = (g.edgeEnd(u) - g.edgeBegin(u)) + (g.inEnd(u) - g.inBegin(u));
+    }
+
+    // RCM starts each component at a node of least degree, BFS at its lowest id
+    std::vector<NodeId> seeds(n);
+    for (NodeId u = 0; u < n; u++) seeds[u] = u;
+    if (order == ORDER_RCM) {
+        std::stable_sort(seeds.begin(), seeds.end(), [&degree](NodeId a, NodeId b) { return degree[a] < degree[b]; });
+    }
+
+    std::vector<bool> visited(n, false);
+    std::vector<NodeId> neighbors;
+    for (NodeId i = 0; i < n; i++) {
+        NodeId seed = seeds[i];
+        if (visited[seed]) continue;
+        visited[seed] = true;
+        size_t head = newToOld.size();
+        newToOld.push_back(seed);
+        while (head < newToOld.size()) {
+            NodeId u = newToOld[head++];
+            neighbors.clear();
+            for (EdgeId e = g.edgeBegin(u); e < g.edgeEnd(u); e++) {
+                if (!visited[g.target(e)]) {
+                    visited[g.target(e)] = true;
+                    neighbors.push_back(g.target(e));
+                }
+            }
+            for (EdgeId e = g.inBegin(u); e < g.inEnd(u); e++) {
+                if (!visited[g.source(e)]) {
+                    visited[g.source(e)] = true;
+                    neighbors.push_back(g.source(e));
+                }
+            }
+            if (order == ORDER_RCM) {
+                std::stable_sort(neighbors.begin(), neighbors.end(),
+                                 [&degree](NodeId a, NodeId b) { return degree[a] < degree[b]; });
+            }
+            newToOld.insert(newToOld.end(), neighbors.begin(), neighbors.end());
+        }
+    }
+    if (order == ORDER_RCM) std::reverse(newToOld.begin(), newToOld.end());
+    return newToOld;
+}
+
+// Copy of g with node newId taking the place of node newToOld[newId].
+// Coordinates, names and edges move with their nodes; each node keeps its
+// edges in their old order. If oldToNew is given it receives the inverse
+// mapping, e.g. to translate stored node ids.
+inline CsrGraph reorderGraph(const CsrGraph& g, const std::vector<NodeId>& newToOld,
+                             std::vector<NodeId>* oldToNew = nullptr, unsigned threads = 0) {
+    NodeId n = g.numNodes();
+    std::vector<NodeId> inverse(n);
+    for (NodeId u = 0; u < n; u++) inverse[newToOld[u]] = u;
+
+    std::shared_ptr<CsrStorage> storage = std::make_shared<CsrStorage>();
+    CsrStorage& s = *storage;
+    s.xs.resize(n);
+    s.ys.resize(n);
+    s.nameOffsets.assign(1, 0);
+    s.nameOffsets.reserve(n + 1);
+    s.namePool.reserve(g.namePoolSize());
+    std::vector<NodeId> from, to;
+    std::vector<double> weight;
+    from.reserve(g.numEdges());
+    to.reserve(g.numEdges());
+    weight.reserve(g.numEdges());
+    for (NodeId u = 0; u < n; u++) {
+        NodeId old = newToOld[u];
+        s.xs[u] = g.x(old);
+        s.ys[u] = g.y(old);
+        s.namePool.insert(s.namePool.end(), g.nameData(old), g.nameData(old) + g.nameLength(old));
+        s.nameOffsets.push_back((uint32_t)s.namePool.size());
+        for (EdgeId e = g.edgeBegin(old); e < g.edgeEnd(old); e++) {
+            from.push_back(u);
+            to.push_back(inverse[g.target(e)]);
+            weight.push_back(g.weight(e));
+        }
+    }
+
+    CsrGraph reordered = CsrBuilder::assemble(storage, from.data(), to.data(), weight.data(), from.size(), true,
+                                              threads == 0 ? defaultThreadCount() : threads);
+    if (oldToNew) oldToNew->swap(inverse);
+    return reordered;
+}
+
+// How far edges reach in the node numbering: span is |source - target|.
+// nearFraction counts edges with span <= 8, whose target's 8-byte
+// per-node entries sit on the same or the next cache line as the source's.
+struct LayoutStats {
+    double meanSpan;
+    uint32_t medianSpan, p90Span;
+    double nearFraction;
+};
+
+inline LayoutStats measureLayout(const CsrGraph& g) {
+    LayoutStats stats = {0, 0, 0, 0};
+    if (g.numEdges() == 0) return stats;
+    std::vector<uint32_t> spans;
+    spans.reserve(g.numEdges());
+    double total = 0;
+    size_t near = 0;
+    for (NodeId u = 0; u < g.numNodes(); u++) {
+        for (EdgeId e = g.edgeBegin(u); e < g.edgeEnd(u); e++) {
+            uint32_t span = g.target(e) > u ? g.target(e) - u : u - g.target(e);
+            spans.push_back(span);
+            total += span;
+            if (span <= 8) near++;
+        }
+    }
+    stats.meanSpan = total / spans.size();
+    stats.nearFraction = (double)near / spans.size();
+    std::nth_element(spans.begin(), spans.begin() + spans.size() / 2, spans.end());
+    stats.medianSpan = spans[spans.size() / 2];
+    std::nth_element(spans.begin(), spans.begin() + spans.size() * 9 / 10, spans.end());
+    stats.p90Span = spans[spans.size() * 9 / 10];
+    return stats;
+}
+
+#endif
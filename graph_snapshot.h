@@ -0,0 +1,192 @@
+#ifndef GRAPH_SNAPSHOT_H
+#define GRAPH_SNAPSHOT_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+
+// Versioned graph for query threads that run while the graph changes.
+//
+// Every published version is an immutable CsrGraph. Readers pin the
+// current version without locks: a pin stores the global epoch in the
+// reader's slot and loads the version pointer, and unpinning clears the
+// slot. Writers are serialized among themselves; they build the next
+// version off to the side, swap it in with one atomic exchange and
+// retire the old one. A retired version is freed once no slot holds an
+// epoch from before its retirement, i.e. once every reader that could
+// still see it has unpinned (epoch-based reclamation).
+//
+// Each thread that queries needs its own Reader, which claims one of
+// MAX_READERS slots for its lifetime. Pins are not nested.
+class SnapshotGraph {
+    static const uint64_t IDLE = 0;
+
+    // Padded so readers on different cores do not share a cache line
+    struct Slot {
+        std::atomic<uint64_t> epoch; // epoch seen at pin time, IDLE if unpinned
+        std::atomic<bool> claimed;
+        char padding[64 - sizeof(std::atomic<uint64_t>) - sizeof(std::atomic<bool>)];
+    };
+
+public:
+    static const unsigned MAX_READERS = 128;
+
+    // One published version
+    struct Version {
+        CsrGraph graph;
+        uint64_t number;
+    };
+
+    explicit SnapshotGraph(const CsrGraph& initial = CsrGraph()) : epoch(1), published(0) {
+        for (unsigned i = 0; i < MAX_READERS; i++) {
+            slots[i].epoch.store(IDLE);
+            slots[i].claimed.store(false);
+        }
+        Version* first = new Version();
+        first->graph = immutable(initial);
+        first->number = ++published;
+        current.store(first);
+    }
+
+    ~SnapshotGraph() {
+        // Readers must be gone by now
+        delete current.load();
+        for (size_t i = 0; i < retired.size(); i++) delete retired[i].first;
+    }
+
+    class Pin;
+
+    // Per-thread handle owning one reader slot
+    class Reader {
+    public:
+        explicit Reader(SnapshotGraph& graphs) : owner(graphs), slot(graphs.claimSlot()) {}
+        ~Reader() { owner.releaseSlot(slot); }
+
+    private:
+        friend class Pin;
+        Reader(const Reader&);
+        Reader& operator=(const Reader&);
+
+        SnapshotGraph& owner;
+        unsigned slot;
+    };
+
+    // A pinned version; its graph stays valid and unchanged until the pin ends
+    class Pin {
+    public:
+        explicit Pin(Reader& reader) : slot(reader.owner.slots[reader.slot]) {
+            // Announce the epoch before loading the version, so a writer
+            // that misses the announcement has already swapped the pointer
+            slot.epoch.store(reader.owner.epoch.load());
+            version = reader.owner.current.load();
+        }
+        ~Pin() { slot.epoch.store(IDLE); }
+
+        const CsrGraph& graph() const { return version->graph; }
+        uint64_t versionNumber() const { return version->number; }
+
+    private:
+        Pin(const Pin&);
+        Pin& operator=(const Pin&);
+
+        Slot& slot;
+        const Version* version;
+    };
+
+    // Make next the current version. Readers pinned earlier keep theirs.
+    // A graph whose weights can change in place gets its own copy of
+    // them, so later setWeight calls on next cannot reach readers.
+    uint64_t publish(const CsrGraph& next) {
+        std::lock_guard<std::mutex> lock(writer);
+        return publishLocked(immutable(next));
+    }
+
+    // Publish a copy of the current version with a batch of weight
+    // changes (edge id, new weight) applied; other arrays are shared
+    uint64_t updateWeights(const std::vector<std::pair<EdgeId, double> >& changes) {
+        std::lock_guard<std::mutex> lock(writer);
+        const CsrGraph& base = current.load()->graph;
+        std::vector<double> weights(base.weightData(), base.weightData() + base.numEdges());
+        for (size_t i = 0; i < changes.size(); i++) {
+            if (changes[i].first < weights.size()) weights[changes[i].first] = changes[i].second;
+        }
+        return publishLocked(base.withWeights(weights));
+    }
+
+    // Current version for a single-threaded caller that does not need a
+    // pin (e.g. to build the next version from); copies share the arrays
+    CsrGraph latest() const { return current.load()->graph; }
+    uint64_t latestVersion() const { return current.load()->number; }
+
+    // Free the retired versions no reader can hold any more; publish()
+    // does this too. Returns the number still waiting.
+    size_t reclaim() {
+        std::lock_guard<std::mutex> lock(writer);
+        return reclaimLocked();
+    }
+
+private:
+    static CsrGraph immutable(const CsrGraph& g) {
+        if (!g.weightsMutable()) return g;
+        return g.withWeights(std::vector<double>(g.weightData(), g.weightData() + g.numEdges()));
+    }
+
+    uint64_t publishLocked(const CsrGraph& next) {
+        Version* version = new Version();
+        version->graph = next;
+        version->number = ++published;
+        Version* old = current.exchange(version);
+        // Readers that pin from now on announce a later epoch and see the new version
+        retired.push_back(std::make_pair(old, epoch.fetch_add(1)));
+        reclaimLocked();
+        return version->number;
+    }
+
+    size_t reclaimLocked() {
+        uint64_t oldest = UINT64_MAX;
+        for (unsigned i = 0; i < MAX_READERS; i++) {
+            uint64_t e = slots[i].epoch.load();
+            if (e != IDLE) oldest = std::min(oldest, e);
+        }
+        size_t kept = 0;
+        for (size_t i = 0; i < retired.size(); i++) {
+            if (retired[i].second < oldest) delete retired[i].first;
+            else retired[kept++] = retired[i];
+        }
+        retired.resize(kept);
+        return kept;
+    }
+
+    unsigned claimSlot() {
+        for (;;) {
+            for (unsigned i = 0; i < MAX_READERS; i++) {
+                bool expected = false;
+                if (!slots[i].claimed.load() && slots[i].claimed.compare_exchange_strong(expected, true)) return i;
+            }
+            std::this_thread::yield(); // every slot taken, wait for a Reader to go away
+        }
+    }
+
+    void releaseSlot(unsigned i) {
+        slots[i].epoch.store(IDLE);
+        slots[i].claimed.store(false);
+    }
+
+    Slot slots[MAX_READERS];
+    std::atomic<Version*> current;
+    std::atomic<uint64_t> epoch;
+    std::mutex writer; // serializes publishers and reclaim
+    uint64_t published;
+    std::vector<std::pair<Version*, uint64_t> > retired; // version, epoch before its retirement
+};
+
+const unsigned SnapshotGraph::MAX_READERS;
+const uint64_t SnapshotGraph::IDLE;
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef GRID_MAP_H
+#define GRID_MAP_H
+
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "csr_graph.h"
+
+// Uniform-cost 8-connected grid stored as a bit-packed occupancy map:
+// one bit per cell, set when the cell is passable. Neighbours are
+// generated on the fly, so a cell costs a bit here instead of a named
+// node and eight edges in a CsrGraph.
+//
+// Rows are kept twice, as rows and transposed as columns, so both
+// horizontal and vertical scans read 64 cells per word. Every line is
+// padded with a blocked word on each side and there is a blocked line
+// above and below the map, so scans never need bounds checks.
+// Cells are numbered y * width + x, which makes them usable as node ids
+// in a SearchContext.
+class GridMap {
+public:
+    GridMap() : w(0), h(0), rowStride(0), columnStride(0) {}
+
+    // width x height map with every cell passable
+    GridMap(uint32_t width, uint32_t height) { resize(width, height, true); }
+
+    // Read a map in the Moving AI benchmark format:
+    //   type octile / height H / width W / map, then H lines of W cells.
+    // '.', 'G' and 'S' are passable; '@', 'O', 'T' and 'W' are not.
+    bool load(const std::string& path, std::string& error) {
+        std::ifstream in(path.c_str());
+        if (!in) {
+            error = "cannot open " + path;
+            return false;
+        }
+
+        std::string line, key;
+        uint32_t width = 0, height = 0;
+        bool sawMap = false;
+        while (!sawMap && std::getline(in, line)) {
+            std::istringstream fields(line);
+            if (!(fields >> key)) continue;
+            if (key == "type") continue;
+            if (key == "height") fields >> height;
+            else if (key == "width") fields >> width;
+            else if (key == "map") sawMap = true;
+            else {
+                error = path + ": unexpected header line '" + line + "'";
+                return false;
+            }
+        }
+        if (!sawMap || width == 0 || height == 0 || (uint64_t)width * height >= INVALID_NODE) {
+            error = path + ": missing or invalid map header";
+            return false;
+        }
+
+        resize(width, height, false);
+        for (uint32_t y = 0; y < height; y++) {
+            if (!std::getline(in, line) || line.size() < width) {
+                error = path + ": map row " + std::to_string(y) + " is missing or short";
+                return false;
+            }
+            for (uint32_t x = 0; x < width; x++) {
+                char c = line[x];
+                if (c == '.' || c == 'G' || c == 'S') setPassable(x, y, true);
+            }
+        }
+        return true;
+    }
+
+    uint32_t width() const { return w; }
+    uint32_t height() const { return h; }
+    NodeId cellCount() const { return w * h; }
+    bool empty() const { return w == 0; }
+
+    NodeId cellId(uint32_t x, uint32_t y) const { return y * w + x; }
+    uint32_t cellX(NodeId cell) const { return cell % w; }
+    uint32_t cellY(NodeId cell) const { return cell / w; }
+
+    // Cells outside the map are blocked
+    bool passable(int x, int y) const {
+        if (x < 0 || y < 0 || x >= (int)w || y >= (int)h) return false;
+        uint64_t bit = (uint64_t)x + 64;
+        return (rows[(size_t)(y + 1) * rowStride + bit / 64] >> (bit % 64)) & 1;
+    }
+
+    void setPassable(uint32_t x, uint32_t y, bool free) {
+        setBit(rows, rowStride, y, x, free);
+        setBit(columns, columnStride, x, y, free);
+    }
+
+    // 64 cells of row y starting at column x: bit i is cell (x + i, y).
+    // x may lie up to 64 cells outside the map on either side.
+    uint64_t rowBits(int x, int y) const {
+        return window(rows.data() + (size_t)(y + 1) * rowStride, x);
+    }
+
+    // 64 cells of column x starting at row y: bit i is cell (x, y + i)
+    uint64_t columnBits(int x, int y) const {
+        return window(columns.data() + (size_t)(x + 1) * columnStride, y);
+    }
+
+    size_t memoryBytes() const {
+        return (rows.capacity() + columns.capacity()) * sizeof(uint64_t);
+    }
+
+private:
+    void resize(uint32_t width, uint32_t height, bool free) {
+        w = width;
+        h = height;
+        rowStride = (width + 63) / 64 + 2;
+        columnStride = (height + 63) / 64 + 2;
+        rows.assign((size_t)(height + 2) * rowStride, 0);
+        columns.assign((size_t)(width + 2) * columnStride, 0);
+        if (free) {
+            for (uint32_t y = 0; y < height; y++) {
+                for (uint32_t x = 0; x < width; x++) setPassable(x, y, true);
+            }
+        }
+    }
+
+    static void setBit(std::vector<uint64_t>& lines, size_t stride, uint32_t line, uint32_t index, bool value) {
+        uint64_t bit = (uint64_t)index + 64;
+        uint64_t& word = lines[(size_t)(line + 1) * stride + bit / 64];
+        uint64_t mask = 1ULL << (bit % 64);
+        word = value ? (word | mask) : (word & ~mask);
+    }
+
+    static uint64_t window(const uint64_t* line, int index) {
+        uint64_t bit = (uint64_t)(index + 64);
+        uint64_t word = bit / 64, shift = bit % 64;
+        if (shift == 0) return line[word];
+        return (line[word] >> shift) | (line[word + 1] << (64 - shift));
+    }
+
+    uint32_t w, h;
+    size_t rowStride, columnStride; // words per padded row / column
+    std::vector<uint64_t> rows, columns;
+};
+
+#endif
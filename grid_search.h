@@ -0,0 +1,352 @@
+#ifndef GRID_SEARCH_H
+#define GRID_SEARCH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "grid_map.h"
+#include "search_context.h"
+
+// Searches on a GridMap. Moves go to the 8 neighbours, straight moves
+// cost 1 and diagonal ones sqrt(2); a diagonal move may not cut a corner,
+// i.e. both orthogonal cells next to it must be passable (the Moving AI
+// benchmark rules). Every mode returns the same optimal cost:
+//   GRID_ASTAR     plain A*, one cell per expansion
+//   GRID_JPS       Jump Point Search; straight jumps scan 64 cells per
+//                  step with bit operations on the occupancy words
+//   GRID_JPS_PLUS  JPS with jump distances looked up in a JumpTable
+enum GridSearchMode {
+    GRID_ASTAR,
+    GRID_JPS,
+    GRID_JPS_PLUS
+};
+
+const double GRID_DIAGONAL_COST = 1.4142135623730951;
+
+// Exact cost between cells on a free grid, the A* heuristic for all modes
+inline double octileDistance(int dx, int dy) {
+    dx = std::abs(dx);
+    dy = std::abs(dy);
+    return std::max(dx, dy) + (GRID_DIAGONAL_COST - 1) * std::min(dx, dy);
+}
+
+// Directions, clockwise from north. Even ones are straight.
+const int GRID_DX[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+const int GRID_DY[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+
+inline int gridDirection(int dx, int dy) {
+    static const int table[3][3] = {{7, 6, 5}, {0, -1, 4}, {1, 2, 3}}; // [dx + 1][dy + 1]
+    return table[dx + 1][dy + 1];
+}
+
+// Diagonal step from (x, y) that does not cut a corner
+inline bool canMove(const GridMap& map, int x, int y, int dx, int dy) {
+    if (!map.passable(x + dx, y + dy)) return false;
+    return dx == 0 || dy == 0 || (map.passable(x + dx, y) && map.passable(x, y + dy));
+}
+
+// A straight move into (x, y) in direction (dx, dy) makes (x, y) a jump
+// point when a cell beside it is free but the cell behind that one is
+// blocked: the side cell can then only be reached optimally through (x, y)
+inline bool hasForcedNeighbour(const GridMap& map, int x, int y, int dx, int dy) {
+    if (dy == 0) {
+        return (map.passable(x, y - 1) && !map.passable(x - dx, y - 1)) ||
+               (map.passable(x, y + 1) && !map.passable(x - dx, y + 1));
+    }
+    return (map.passable(x - 1, y) && !map.passable(x - 1, y - dy)) ||
+           (map.passable(x + 1, y) && !map.passable(x + 1, y - dy));
+}
+
+// JPS+ preprocessing: for every cell and direction the distance to the
+// next jump point (positive) or to the last free cell before a wall
+// (zero or negative, as -steps).
+class JumpTable {
+public:
+    bool empty() const { return distance.empty(); }
+    bool matches(const GridMap& map) const { return !empty() && w == map.width() && h == map.height(); }
+
+    int32_t jump(NodeId cell, int direction) const { return distance[(size_t)cell * 8 + direction]; }
+
+    void build(const GridMap& map) {
+        w = map.width();
+        h = map.height();
+        distance.assign((size_t)w * h * 8, 0);
+
+        // Straight directions: sweep each line against the direction of travel
+        for (int dir = 0; dir < 8; dir += 2) {
+            int dx = GRID_DX[dir], dy = GRID_DY[dir];
+            for (uint32_t i = 0; i < h; i++) {
+                for (uint32_t j = 0; j < w; j++) {
+                    // Visit cells so the next one along dir is done first
+                    int x = dx > 0 ? (int)(w - 1 - j) : (int)j;
+                    int y = dy > 0 ? (int)(h - 1 - i) : (int)i;
+                    set(x, y, dir, straightStep(map, x, y, dx, dy));
+                }
+            }
+        }
+
+        // Diagonals depend on the straight distances of the next cell
+        for (int dir = 1; dir < 8; dir += 2) {
+            int dx = GRID_DX[dir], dy = GRID_DY[dir];
+            for (uint32_t i = 0; i < h; i++) {
+                for (uint32_t j = 0; j < w; j++) {
+                    int x = dx > 0 ? (int)(w - 1 - j) : (int)j;
+                    int y = dy > 0 ? (int)(h - 1 - i) : (int)i;
+                    int32_t d = 0;
+                    if (canMove(map, x, y, dx, dy)) {
+                        NodeId next = map.cellId(x + dx, y + dy);
+                        if (jump(next, gridDirection(dx, 0)) > 0 || jump(next, gridDirection(0, dy)) > 0) {
+                            d = 1;
+                        } else {
+                            int32_t further = jump(next, dir);
+                            d = further > 0 ? further + 1 : further - 1;
+                        }
+                    }
+                    set(x, y, dir, d);
+                }
+            }
+        }
+    }
+
+    size_t memoryBytes() const { return distance.capacity() * sizeof(int32_t); }
+
+private:
+    int32_t straightStep(const GridMap& map, int x, int y, int dx, int dy) const {
+        if (!map.passable(x + dx, y + dy)) return 0;
+        if (hasForcedNeighbour(map, x + dx, y + dy, dx, dy)) return 1;
+        int32_t further = jump(map.cellId(x + dx, y + dy), gridDirection(dx, dy));
+        return further > 0 ? further + 1 : further - 1;
+    }
+
+    void set(int x, int y, int dir, int32_t d) { distance[((size_t)y * w + x) * 8 + dir] = d; }
+
+    uint32_t w = 0, h = 0;
+    std::vector<int32_t> distance;
+};
+
+// Reusable grid search. Keeps its SearchContext (cells as node ids)
+// and open list between queries like the graph engines.
+class GridSearch {
+public:
+    // Cost of the shortest path from start to goal, or INFINITE_COST.
+    // GRID_JPS_PLUS needs a table built for map.
+    double search(const GridMap& map, NodeId start, NodeId goal, GridSearchMode mode = GRID_JPS,
+                  const JumpTable* table = nullptr) {
+        SearchContext& ctx = context;
+        IndexedDaryHeap<4>& open = ctx.quaternaryHeap;
+        ctx.reset(map.cellCount());
+        open.reset(map.cellCount());
+        if (start >= map.cellCount() || goal >= map.cellCount() ||
+            !map.passable(map.cellX(start), map.cellY(start)) || !map.passable(map.cellX(goal), map.cellY(goal))) {
+            return INFINITE_COST;
+        }
+        if (mode == GRID_JPS_PLUS && (table == nullptr || !table->matches(map))) mode = GRID_JPS;
+
+        goalX = (int)map.cellX(goal);
+        goalY = (int)map.cellY(goal);
+        ctx.setG(start, 0, INVALID_NODE);
+        ctx.setState(start, SearchContext::OPEN);
+        open.push(start, heuristic(map, start));
+
+        while (!open.empty()) {
+            NodeId current = open.pop();
+            if (ctx.stateOf(current) != SearchContext::OPEN) continue;
+            ctx.setState(current, SearchContext::CLOSED);
+            ctx.countExpansion();
+            if (current == goal) return ctx.g(goal);
+
+            int x = (int)map.cellX(current), y = (int)map.cellY(current);
+            NodeId from = ctx.parentOf(current);
+            int directions = mode == GRID_ASTAR || from == INVALID_NODE ? 0xFF : prunedDirections(map, x, y, from);
+            for (int dir = 0; dir < 8; dir++) {
+                if (!(directions & (1 << dir))) continue;
+                int dx = GRID_DX[dir], dy = GRID_DY[dir];
+                int nx, ny;
+                if (mode == GRID_ASTAR) {
+                    if (!canMove(map, x, y, dx, dy)) continue;
+                    nx = x + dx;
+                    ny = y + dy;
+                } else if (mode == GRID_JPS) {
+                    if (!jump(map, x, y, dx, dy, nx, ny)) continue;
+                } else {
+                    if (!tableJump(*table, current, x, y, dir, nx, ny)) continue;
+                }
+
+                NodeId next = map.cellId(nx, ny);
+                double tentative = ctx.g(current) + octileDistance(nx - x, ny - y);
+                if (tentative < ctx.g(next)) {
+                    ctx.setG(next, tentative, current);
+                    ctx.setState(next, SearchContext::OPEN);
+                    open.push(next, tentative + heuristic(map, next));
+                }
+            }
+        }
+        return INFINITE_COST;
+    }
+
+    // Jump points (or cells, for GRID_ASTAR) from start to goal of the last
+    // successful search. Consecutive entries lie on a straight or diagonal line.
+    const std::vector<NodeId>& buildPath(NodeId goal) { return context.buildPath(goal); }
+
+    // Every cell along the last path, jump segments filled in
+    const std::vector<NodeId>& buildCellPath(const GridMap& map, NodeId goal) {
+        const std::vector<NodeId>& points = context.buildPath(goal);
+        cells.clear();
+        for (size_t i = 0; i < points.size(); i++) {
+            int x = (int)map.cellX(points[i]), y = (int)map.cellY(points[i]);
+            if (i > 0) {
+                int px = (int)map.cellX(points[i - 1]), py = (int)map.cellY(points[i - 1]);
+                int dx = (x > px) - (x < px), dy = (y > py) - (y < py);
+                for (px += dx, py += dy; px != x || py != y; px += dx, py += dy) cells.push_back(map.cellId(px, py));
+            }
+            cells.push_back(points[i]);
+        }
+        return cells;
+    }
+
+    uint64_t expandedCount() const { return context.expandedCount(); }
+    uint64_t allocationCount() const { return context.allocationCount(); }
+
+private:
+    double heuristic(const GridMap& map, NodeId cell) const {
+        return octileDistance((int)map.cellX(cell) - goalX, (int)map.cellY(cell) - goalY);
+    }
+
+    // Directions worth following from (x, y) when it was reached from
+    // parent: the natural ones plus those opened up by forced neighbours.
+    // Without corner cutting, only straight moves have forced neighbours.
+    static int prunedDirections(const GridMap& map, int x, int y, NodeId parent) {
+        int px = (int)map.cellX(parent), py = (int)map.cellY(parent);
+        int dx = (x > px) - (x < px), dy = (y > py) - (y < py);
+        if (dx != 0 && dy != 0) {
+            return (1 << gridDirection(dx, dy)) | (1 << gridDirection(dx, 0)) | (1 << gridDirection(0, dy));
+        }
+        int directions = 1 << gridDirection(dx, dy);
+        for (int side = -1; side <= 1; side += 2) {
+            // side cell perpendicular to the move and the one behind it
+            int sx = dx == 0 ? side : 0, sy = dy == 0 ? side : 0;
+            if (map.passable(x + sx, y + sy) && !map.passable(x + sx - dx, y + sy - dy)) {
+                directions |= 1 << gridDirection(sx, sy);
+                directions |= 1 << gridDirection(dx + sx, dy + sy);
+            }
+        }
+        return directions;
+    }
+
+    // Jump from (x, y) in (dx, dy); the jump point goes to (nx, ny)
+    bool jump(const GridMap& map, int x, int y, int dx, int dy, int& nx, int& ny) const {
+        if (dx == 0 || dy == 0) return straightJump(map, x, y, dx, dy, nx, ny);
+        for (;;) {
+            if (!canMove(map, x, y, dx, dy)) return false;
+            x += dx;
+            y += dy;
+            int sx, sy;
+            if ((x == goalX && y == goalY) || straightJump(map, x, y, dx, 0, sx, sy) ||
+                straightJump(map, x, y, 0, dy, sx, sy)) {
+                nx = x;
+                ny = y;
+                return true;
+            }
+        }
+    }
+
+    bool straightJump(const GridMap& map, int x, int y, int dx, int dy, int& nx, int& ny) const {
+        if (dy == 0) {
+            int at;
+            if (!scanLine(map, true, x, y, dx, goalY == y ? goalX : -1, at)) return false;
+            nx = at;
+            ny = y;
+        } else {
+            int at;
+            if (!scanLine(map, false, y, x, dy, goalX == x ? goalY : -1, at)) return false;
+            nx = x;
+            ny = at;
+        }
+        return true;
+    }
+
+    // Scan along a row (horizontal) or column from position pos of line,
+    // exclusive, in step +1 or -1. Reads 64 cells per iteration: the next
+    // stop is the first cell that is blocked or has a forced neighbour,
+    // found with a bit scan. target is the goal's position on this line
+    // or -1. Returns the jump point position, if any.
+    static bool scanLine(const GridMap& map, bool horizontal, int pos, int line, int step, int target, int& at) {
+        for (;;) {
+            // bit i of each window is cell pos + step * (i + 1)
+            int first = step > 0 ? pos + 1 : pos - 64;
+            uint64_t cells = bits(map, horizontal, first, line);
+            uint64_t before = bits(map, horizontal, first, line - 1), after = bits(map, horizontal, first, line + 1);
+            uint64_t beforeBehind = bits(map, horizontal, first - step, line - 1);
+            uint64_t afterBehind = bits(map, horizontal, first - step, line + 1);
+            uint64_t forced = (before & ~beforeBehind) | (after & ~afterBehind);
+            uint64_t stops = forced | ~cells;
+
+            int index = 64;
+            if (stops != 0) index = step > 0 ? __builtin_ctzll(stops) : __builtin_clzll(stops);
+            int stop = pos + step * (index + 1);
+
+            // The goal is passable, so it is reached if it comes no later than the stop
+            int toTarget = (target - pos) * step;
+            if (target >= 0 && toTarget > 0 && toTarget <= std::min(index + 1, 64)) {
+                at = target;
+                return true;
+            }
+            if (index < 64) {
+                if (!forcedAt(cells, forced, step, index)) return false; // wall
+                at = stop;
+                return true;
+            }
+            pos += step * 64;
+        }
+    }
+
+    // Whether the stop found at index is a passable forced cell (else a wall)
+    static bool forcedAt(uint64_t cells, uint64_t forced, int step, int index) {
+        int bit = step > 0 ? index : 63 - index;
+        return ((cells & forced) >> bit) & 1;
+    }
+
+    static uint64_t bits(const GridMap& map, bool horizontal, int pos, int line) {
+        return horizontal ? map.rowBits(pos, line) : map.columnBits(line, pos);
+    }
+
+    // JPS+ jump: table distance, cut short where the goal lies on the way
+    bool tableJump(const JumpTable& table, NodeId cell, int x, int y, int dir, int& nx, int& ny) const {
+        int dx = GRID_DX[dir], dy = GRID_DY[dir];
+        int32_t d = table.jump(cell, dir);
+        int reach = d > 0 ? d : -d;
+        int toGoalX = goalX - x, toGoalY = goalY - y;
+        if (dx == 0 || dy == 0) {
+            // Goal straight ahead within reach
+            int along = dx != 0 ? toGoalX * dx : toGoalY * dy;
+            int across = dx != 0 ? toGoalY : toGoalX;
+            if (across == 0 && along > 0 && along <= reach) {
+                nx = goalX;
+                ny = goalY;
+                return true;
+            }
+        } else if (toGoalX * dx > 0 && toGoalY * dy > 0) {
+            // Goal in this quadrant: stop where a straight move can reach
+            // its row or column
+            int k = std::min(std::abs(toGoalX), std::abs(toGoalY));
+            if (k <= reach) {
+                nx = x + k * dx;
+                ny = y + k * dy;
+                return true;
+            }
+        }
+        if (d <= 0) return false;
+        nx = x + d * dx;
+        ny = y + d * dy;
+        return true;
+    }
+
+    SearchContext context;
+    std::vector<NodeId> cells;
+    int goalX = 0, goalY = 0;
+};
+
+#endif
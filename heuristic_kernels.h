@@ -0,0 +1,165 @@
+#ifndef HEURISTIC_KERNELS_H
+#define HEURISTIC_KERNELS_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "csr_graph.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HEURISTIC_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+// Distance metrics for coordinate heuristics, chosen at compile time as
+// the Metric parameter of CoordinateHeuristic (astar_search.h). Each has
+// a scalar form and AVX2/AVX-512 forms over 4/8 lanes of dx and dy.
+// Only Euclidean distance is a lower bound on graphs whose edge weights
+// are at least the straight-line length; Manhattan fits 4-connected and
+// octile 8-connected grids with unit (and sqrt 2 diagonal) steps.
+//
+// Some intrinsics are used in their masked form with every lane on: the
+// plain forms pass an undefined vector that trips -Wmaybe-uninitialized
+// in GCC 12's headers.
+struct EuclideanMetric {
+    static double distance(double dx, double dy) { return std::sqrt(dx * dx + dy * dy); }
+#ifdef HEURISTIC_X86_KERNELS
+    __attribute__((target("avx2"))) static __m256d distance(__m256d dx, __m256d dy) {
+        return _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)));
+    }
+    __attribute__((target("avx512f"))) static __m512d distance(__m512d dx, __m512d dy) {
+        return _mm512_maskz_sqrt_pd(0xFF, _mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)));
+    }
+#endif
+};
+
+struct ManhattanMetric {
+    static double distance(double dx, double dy) { return std::fabs(dx) + std::fabs(dy); }
+#ifdef HEURISTIC_X86_KERNELS
+    __attribute__((target("avx2"))) static __m256d distance(__m256d dx, __m256d dy) {
+        __m256d sign = _mm256_set1_pd(-0.0);
+        return _mm256_add_pd(_mm256_andnot_pd(sign, dx), _mm256_andnot_pd(sign, dy));
+    }
+    __attribute__((target("avx512f"))) static __m512d distance(__m512d dx, __m512d dy) {
+        return _mm512_add_pd(_mm512_abs_pd(dx), _mm512_abs_pd(dy));
+    }
+#endif
+};
+
+// max + (sqrt 2 - 1) * min: straight steps plus diagonal ones
+struct OctileMetric {
+    static double distance(double dx, double dy) {
+        dx = std::fabs(dx);
+        dy = std::fabs(dy);
+        return dx > dy ? dx + DIAGONAL_EXTRA * dy : dy + DIAGONAL_EXTRA * dx;
+    }
+#ifdef HEURISTIC_X86_KERNELS
+    __attribute__((target("avx2"))) static __m256d distance(__m256d dx, __m256d dy) {
+        __m256d sign = _mm256_set1_pd(-0.0);
+        dx = _mm256_andnot_pd(sign, dx);
+        dy = _mm256_andnot_pd(sign, dy);
+        return _mm256_add_pd(_mm256_max_pd(dx, dy),
+                             _mm256_mul_pd(_mm256_set1_pd(DIAGONAL_EXTRA), _mm256_min_pd(dx, dy)));
+    }
+    __attribute__((target("avx512f"))) static __m512d distance(__m512d dx, __m512d dy) {
+        dx = _mm512_abs_pd(dx);
+        dy = _mm512_abs_pd(dy);
+        return _mm512_add_pd(_mm512_maskz_max_pd(0xFF, dx, dy),
+                             _mm512_mul_pd(_mm512_set1_pd(DIAGONAL_EXTRA), _mm512_maskz_min_pd(0xFF, dx, dy)));
+    }
+#endif
+    static constexpr double DIAGONAL_EXTRA = 0.41421356237309504880;
+};
+
+constexpr double OctileMetric::DIAGONAL_EXTRA;
+
+// out[i] = distance from node ids[i] to (goalX, goalY), coordinates taken
+// from the structure-of-arrays xs/ys of a CsrGraph
+typedef void (*DistanceKernel)(const double* xs, const double* ys, const NodeId* ids, size_t count,
+                               double goalX, double goalY, double* out);
+
+enum SimdLevel {
+    SIMD_SCALAR,
+    SIMD_AVX2,
+    SIMD_AVX512
+};
+
+template <class Metric>
+void distancesScalar(const double* xs, const double* ys, const NodeId* ids, size_t count,
+                     double goalX, double goalY, double* out) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = Metric::distance(xs[ids[i]] - goalX, ys[ids[i]] - goalY);
+    }
+}
+
+#ifdef HEURISTIC_X86_KERNELS
+// The gathers take signed 32-bit indices, so these assume node ids below 2^31
+
+template <class Metric>
+__attribute__((target("avx2"))) void distancesAvx2(const double* xs, const double* ys, const NodeId* ids,
+                                                   size_t count, double goalX, double goalY, double* out) {
+    __m256d gx = _mm256_set1_pd(goalX), gy = _mm256_set1_pd(goalY);
+    __m256d zero = _mm256_setzero_pd(), all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i index = _mm_loadu_si128((const __m128i*)(ids + i));
+        __m256d dx = _mm256_sub_pd(_mm256_mask_i32gather_pd(zero, xs, index, all, 8), gx);
+        __m256d dy = _mm256_sub_pd(_mm256_mask_i32gather_pd(zero, ys, index, all, 8), gy);
+        _mm256_storeu_pd(out + i, Metric::distance(dx, dy));
+    }
+    distancesScalar<Metric>(xs, ys, ids + i, count - i, goalX, goalY, out + i);
+}
+
+template <class Metric>
+__attribute__((target("avx512f"))) void distancesAvx512(const double* xs, const double* ys, const NodeId* ids,
+                                                        size_t count, double goalX, double goalY, double* out) {
+    __m512d gx = _mm512_set1_pd(goalX), gy = _mm512_set1_pd(goalY), zero = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i index = _mm256_loadu_si256((const __m256i*)(ids + i));
+        __m512d dx = _mm512_sub_pd(_mm512_mask_i32gather_pd(zero, 0xFF, index, xs, 8), gx);
+        __m512d dy = _mm512_sub_pd(_mm512_mask_i32gather_pd(zero, 0xFF, index, ys, 8), gy);
+        _mm512_storeu_pd(out + i, Metric::distance(dx, dy));
+    }
+    distancesScalar<Metric>(xs, ys, ids + i, count - i, goalX, goalY, out + i);
+}
+#endif
+
+// Widest kernel set this CPU runs
+inline SimdLevel detectSimdLevel() {
+#ifdef HEURISTIC_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+#endif
+    return SIMD_SCALAR;
+}
+
+// Kernel for Metric at level, or the widest one below it that was compiled
+template <class Metric>
+DistanceKernel distanceKernel(SimdLevel level) {
+#ifdef HEURISTIC_X86_KERNELS
+    if (level >= SIMD_AVX512) return &distancesAvx512<Metric>;
+    if (level >= SIMD_AVX2) return &distancesAvx2<Metric>;
+#else
+    (void)level;
+#endif
+    return &distancesScalar<Metric>;
+}
+
+// Smallest batch worth a call to the kernel of level: one full vector.
+// Most expansions improve only two or three neighbors, which are cheaper
+// to estimate inline than through the kernel's indirect call.
+inline size_t kernelMinBatch(SimdLevel level) {
+    if (level >= SIMD_AVX512) return 8;
+    if (level >= SIMD_AVX2) return 4;
+    return SIZE_MAX;
+}
+
+// Level coordinate heuristics use unless given one. Scalar, because the
+// vector kernels are not faster on the road graph in make bench; pass
+// detectSimdLevel() to try them.
+inline SimdLevel defaultSimdLevel() { return SIMD_SCALAR; }
+
+#endif
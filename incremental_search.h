@@ -0,0 +1,158 @@
+#ifndef INCREMENTAL_SEARCH_H
+#define INCREMENTAL_SEARCH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "csr_graph.h"
+#include "search_context.h"
+#include "open_list.h"
+#include "astar_search.h"
+
+// Lifelong Planning A* (Koenig & Likhachev) for one fixed (start, goal)
+// pair on a graph whose edge weights change in place (CsrGraph::setWeight;
+// an infinite weight removes an edge). search() plans from scratch; after
+// weights change, update() with the ids of the changed edges repairs the
+// search tree and only re-expands the nodes whose distance is affected.
+//
+// Every node keeps g (distance at its last expansion) and rhs (one-step
+// lookahead from its predecessors' g). Nodes where they differ are
+// queued by [min(g, rhs) + h, min(g, rhs)]. Like the other engines the
+// Euclidean heuristic must stay a lower bound, so weights may not drop
+// below the straight-line length of their edge.
+class LpaStar {
+public:
+    LpaStar() : start(INVALID_NODE), goal(INVALID_NODE), expansions(0) {}
+
+    // Plan from scratch; returns the path cost or INFINITE_COST
+    double search(const CsrGraph& graph, NodeId startNode, NodeId goalNode) {
+        g = graph;
+        start = startNode;
+        goal = goalNode;
+        gScore.assign(g.numNodes(), INFINITE_COST);
+        rhs.assign(g.numNodes(), INFINITE_COST);
+        open.reset(g.numNodes());
+        expansions = 0;
+
+        rhs[start] = 0;
+        open.push(start, keyOf(start));
+        return computeShortestPath();
+    }
+
+    // Repair after the weights of edges changed in the graph given to
+    // search(); changed lists their ids. Returns the new path cost.
+    double update(const EdgeId* changed, size_t count) {
+        expansions = 0;
+        for (size_t i = 0; i < count; i++) {
+            updateNode(g.target(changed[i]));
+        }
+        return computeShortestPath();
+    }
+
+    double update(const std::vector<EdgeId>& changed) {
+        return update(changed.empty() ? nullptr : &changed[0], changed.size());
+    }
+
+    bool planned() const { return start != INVALID_NODE; }
+    NodeId startNode() const { return start; }
+    NodeId goalNode() const { return goal; }
+    double cost() const { return gScore[goal]; }
+
+    // Nodes from start to goal along the current plan, empty if there is none
+    const std::vector<NodeId>& buildPath() {
+        pathBuffer.clear();
+        if (!planned() || gScore[goal] == INFINITE_COST) return pathBuffer;
+        for (NodeId v = goal; ; ) {
+            pathBuffer.push_back(v);
+            if (v == start) break;
+            // Predecessor that gives v its distance
+            NodeId best = INVALID_NODE;
+            double bestCost = INFINITE_COST;
+            for (EdgeId e = g.inBegin(v); e < g.inEnd(v); e++) {
+                double c = gScore[g.source(e)] + g.inWeight(e);
+                if (c < bestCost) {
+                    bestCost = c;
+                    best = g.source(e);
+                }
+            }
+            if (best == INVALID_NODE) {
+                pathBuffer.clear();
+                return pathBuffer;
+            }
+            v = best;
+        }
+        std::reverse(pathBuffer.begin(), pathBuffer.end());
+        return pathBuffer;
+    }
+
+    // Nodes expanded by the last search() or update()
+    uint64_t expandedCount() const { return expansions; }
+
+private:
+    struct Key {
+        double primary, secondary;
+        bool operator<(const Key& other) const {
+            return primary < other.primary || (primary == other.primary && secondary < other.secondary);
+        }
+    };
+
+    Key keyOf(NodeId u) const {
+        double best = std::min(gScore[u], rhs[u]);
+        Key key = {best + euclideanHeuristic(g, u, goal), best};
+        return key;
+    }
+
+    // Recompute rhs(u) from its predecessors and requeue u if inconsistent
+    void updateNode(NodeId u) {
+        if (u != start) {
+            double best = INFINITE_COST;
+            for (EdgeId e = g.inBegin(u); e < g.inEnd(u); e++) {
+                best = std::min(best, gScore[g.source(e)] + g.inWeight(e));
+            }
+            rhs[u] = best;
+        }
+        requeue(u);
+    }
+
+    void requeue(NodeId u) {
+        open.erase(u);
+        if (gScore[u] != rhs[u]) open.push(u, keyOf(u));
+    }
+
+    double computeShortestPath() {
+        while (!open.empty() && (open.topKey() < keyOf(goal) || rhs[goal] != gScore[goal])) {
+            NodeId u = open.pop();
+            expansions++;
+            if (gScore[u] > rhs[u]) {
+                // Overconsistent: settle u, successors may get cheaper
+                gScore[u] = rhs[u];
+                for (EdgeId e = g.edgeBegin(u); e < g.edgeEnd(u); e++) {
+                    NodeId v = g.target(e);
+                    if (v != start && gScore[u] + g.weight(e) < rhs[v]) {
+                        rhs[v] = gScore[u] + g.weight(e);
+                        requeue(v);
+                    }
+                }
+            } else {
+                // Underconsistent: u got more expensive, so did anything
+                // that took its distance from u
+                gScore[u] = INFINITE_COST;
+                updateNode(u);
+                for (EdgeId e = g.edgeBegin(u); e < g.edgeEnd(u); e++) {
+                    updateNode(g.target(e));
+                }
+            }
+        }
+        return gScore[goal];
+    }
+
+    CsrGraph g; // shares the arrays, so in-place weight changes are seen
+    NodeId start, goal;
+    std::vector<double> gScore, rhs;
+    IndexedDaryHeap<4, Key> open;
+    std::vector<NodeId> pathBuffer;
+    uint64_t expansions;
+};
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef ISOCHRONE_H
+#define ISOCHRONE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "csr_graph.h"
+#include "search_context.h"
+#include "open_list.h"
+#include "parallel.h"
+
+// Nodes reachable within a cost budget, as parallel arrays sorted by id
+struct Isochrone {
+    double budget;
+    std::vector<NodeId> nodes;    // ascending node ids
+    std::vector<double> costs;    // cost of reaching nodes[i]
+    std::vector<EdgeId> boundary; // ascending forward edges out of the set on which the budget runs out
+
+    Isochrone() : budget(0) {}
+
+    size_t size() const { return nodes.size(); }
+
+    // Cost of reaching v, INFINITE_COST if it is not within the budget
+    double costOf(NodeId v) const {
+        std::vector<NodeId>::const_iterator it = std::lower_bound(nodes.begin(), nodes.end(), v);
+        return it != nodes.end() && *it == v ? costs[it - nodes.begin()] : INFINITE_COST;
+    }
+
+    bool contains(NodeId v) const { return std::binary_search(nodes.begin(), nodes.end(), v); }
+};
+
+// Budget-bounded Dijkstra. Keys beyond the budget never enter the open
+// list, so a search touches only the nodes inside the isochrone and the
+// heads of its boundary edges, whatever the size of the graph. Keeps its
+// SearchContext between calls; refilling the same Isochrone reuses its
+// arrays too.
+class IsochroneEngine {
+public:
+    // Everything source reaches at cost <= budget. With boundary, also
+    // the edges u -> v out of a reached u with cost(u) + w > budget, where
+    // an isochrone's outline crosses the network; v may still be reached
+    // another way.
+    template <class View>
+    void reachable(const View& g, NodeId source, double budget, Isochrone& out, bool boundary = false) {
+        NodeId sources[1] = {source};
+        search(g, sources, 1, budget, out, boundary, nullptr);
+    }
+
+    // One search from all sources at once: every node within budget of
+    // any of them, at the cost from the nearest one. nearest[i] is the
+    // index in sources of the nearest source of out.nodes[i] (the lowest
+    // index on ties), e.g. the depot that serves it.
+    template <class View>
+    void reachableFromNearest(const View& g, const std::vector<NodeId>& sources, double budget, Isochrone& out,
+                              std::vector<uint32_t>& nearest, bool boundary = false) {
+        search(g, sources.data(), sources.size(), budget, out, boundary, &nearest);
+    }
+
+    const SearchContext& context() const { return ctx; }
+
+private:
+    template <class View>
+    void search(const View& g, const NodeId* sources, size_t count, double budget, Isochrone& out, bool boundary,
+                std::vector<uint32_t>* nearest) {
+        out.budget = budget;
+        out.nodes.clear();
+        out.costs.clear();
+        out.boundary.clear();
+        if (nearest) nearest->clear();
+
+        IndexedDaryHeap<4>& open = ctx.quaternaryHeap;
+        ctx.reset(g.numNodes());
+        open.reset(g.numNodes());
+        if (nearest && origin.size() < g.numNodes()) origin.resize(g.numNodes());
+        for (size_t i = 0; i < count; i++) {
+            NodeId s = sources[i];
+            if (s >= g.numNodes() || !(budget >= 0) || ctx.g(s) == 0) continue;
+            ctx.setG(s, 0, INVALID_NODE);
+            open.push(s, 0);
+            if (nearest) origin[s] = (uint32_t)i;
+        }
+
+        while (!open.empty()) {
+            NodeId current = open.pop();
+            ctx.setState(current, SearchContext::CLOSED);
+            out.nodes.push_back(current);
+            double currentG = ctx.g(current);
+            for (EdgeId e = g.edgeBegin(current); e < g.edgeEnd(current); e++) {
+                double tentative = currentG + g.weight(e);
+                if (tentative > budget) {
+                    if (boundary && g.weight(e) != INFINITE_COST) out.boundary.push_back(e);
+                    continue;
+                }
+                NodeId neighbor = g.target(e);
+                // Equal costs go to the lower source index while still open
+                if (tentative < ctx.g(neighbor) ||
+                    (nearest && tentative == ctx.g(neighbor) && origin[current] < origin[neighbor] &&
+                     ctx.stateOf(neighbor) != SearchContext::CLOSED)) {
+                    ctx.setG(neighbor, tentative, current);
+                    open.push(neighbor, tentative);
+                    if (nearest) origin[neighbor] = origin[current];
+                }
+            }
+        }
+
+        std::sort(out.nodes.begin(), out.nodes.end());
+        std::sort(out.boundary.begin(), out.boundary.end());
+        out.costs.resize(out.nodes.size());
+        for (size_t i = 0; i < out.nodes.size(); i++) out.costs[i] = ctx.g(out.nodes[i]);
+        if (nearest) {
+            nearest->resize(out.nodes.size());
+            for (size_t i = 0; i < out.nodes.size(); i++) (*nearest)[i] = origin[out.nodes[i]];
+        }
+    }
+
+    SearchContext ctx;
+    std::vector<uint32_t> origin; // source index each reached node was reached from
+};
+
+// A batch of possibly overlapping isochrones, out[i] from sources[i]
+// within budget, on up to threads workers (0 = all cores) with one engine
+// each. Pass the same engines again to keep their buffers between batches.
+template <class View>
+void reachableBatch(const View& g, const std::vector<NodeId>& sources, double budget, std::vector<Isochrone>& out,
+                    std::vector<IsochroneEngine>& engines, unsigned threads = 0, bool boundary = false) {
+    if (threads == 0) threads = defaultThreadCount();
+    if (engines.size() < threads) engines.resize(threads);
+    out.resize(sources.size());
+    parallelFor(sources.size(), threads, [&](size_t i, unsigned w) {
+        engines[w].reachable(g, sources[i], budget, out[i], boundary);
+    });
+}
+
+// The same with a budget per source, budgets[i] for sources[i]. Returns
+// false, and leaves out empty, if the two differ in size.
+template <class View>
+bool reachableBatch(const View& g, const std::vector<NodeId>& sources, const std::vector<double>& budgets,
+                    std::vector<Isochrone>& out, std::vector<IsochroneEngine>& engines, unsigned threads = 0,
+                    bool boundary = false) {
+    if (budgets.size() != sources.size()) {
+        out.clear();
+        return false;
+    }
+    if (threads == 0) threads = defaultThreadCount();
+    if (engines.size() < threads) engines.resize(threads);
+    out.resize(sources.size());
+    parallelFor(sources.size(), threads, [&](size_t i, unsigned w) {
+        engines[w].reachable(g, sources[i], budgets[i], out[i], boundary);
+    });
+    return true;
+}
+
+#endif
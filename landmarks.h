@@ -0,0 +1,420 @@
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LANDMARKS_SSE2 1
+#endif
+
+#include "csr_graph.h"
+#include "search_context.h"
+#include "open_list.h"
+#include "parallel.h"
+
+// How the landmarks are picked
+enum LandmarkSelection {
+    LANDMARKS_FARTHEST, // each new landmark is the node farthest from the ones chosen so far
+    LANDMARKS_AVOID     // Goldberg-Harrelson "avoid": grow into the worst-covered subtree
+};
+
+// Full single-source Dijkstra; dist[v] is INFINITE_COST if v is unreachable
+template <class View>
+void dijkstraDistances(const View& g, SearchContext& ctx, NodeId source, std::vector<double>& dist) {
+    IndexedDaryHeap<4>& open = ctx.quaternaryHeap;
+    ctx.reset(g.numNodes());
+    open.reset(g.numNodes());
+    ctx.setG(source, 0, INVALID_NODE);
+    open.push(source, 0);
+    while (!open.empty()) {
+        NodeId current = open.pop();
+        double currentG = ctx.g(current);
+        for (EdgeId e = g.edgeBegin(current); e < g.edgeEnd(current); e++) {
+            NodeId neighbor = g.target(e);
+            double tentative = currentG + g.weight(e);
+            if (tentative < ctx.g(neighbor)) {
+                ctx.setG(neighbor, tentative, current);
+                open.push(neighbor, tentative);
+            }
+        }
+    }
+    dist.resize(g.numNodes());
+    for (NodeId v = 0; v < g.numNodes(); v++) dist[v] = ctx.g(v);
+}
+
+// ALT (A*, landmarks, triangle inequality) lower-bound table.
+// Every node has one row of 2 * stride 16-bit lanes: lane k holds
+// d(L_k, v) and lane stride + k holds the complement of d(v, L_k), each
+// quantized (rounded down) with its own scale. With that layout both
+// triangle bounds
+//   d(v, t) >= d(L, t) - d(L, v)      d(v, t) >= d(v, L) - d(t, L)
+// become the same saturating subtraction row(t) - row(v) in every lane,
+// so the max over landmarks is a handful of SSE2 instructions. One unit
+// of slack per lane keeps the quantized bound admissible.
+class LandmarkTable {
+public:
+    static const uint32_t MAX_LANDMARKS = 64;
+
+    LandmarkTable() : nodes(0), stride(0), fingerprint(0) {}
+
+    bool empty() const { return landmarkIds.empty(); }
+    uint32_t count() const { return (uint32_t)landmarkIds.size(); }
+    NodeId numNodes() const { return nodes; }
+    const std::vector<NodeId>& landmarks() const { return landmarkIds; }
+    size_t memoryBytes() const { return rows.size() * sizeof(uint16_t) + scales.size() * sizeof(float); }
+
+    // True if the table was built for exactly this graph
+    bool matches(const CsrGraph& g) const {
+        return !empty() && nodes == g.numNodes() && fingerprint == graphFingerprint(g);
+    }
+
+    // Lower bound on d(v, t)
+    double bound(NodeId v, NodeId t) const {
+        const uint16_t* goalRow = &rows[(size_t)t * 2 * stride];
+        const uint16_t* nodeRow = &rows[(size_t)v * 2 * stride];
+#ifdef LANDMARKS_SSE2
+        return boundSse2(goalRow, nodeRow);
+#else
+        return boundScalar(goalRow, nodeRow);
+#endif
+    }
+
+    // Portable version of bound(), also used to check the SIMD kernel
+    double boundScalar(NodeId v, NodeId t) const {
+        return boundScalar(&rows[(size_t)t * 2 * stride], &rows[(size_t)v * 2 * stride]);
+    }
+
+    // Pick k landmarks and precompute both distance directions, running
+    // the 2k Dijkstra searches on up to threads workers (0 = all cores)
+    void build(const CsrGraph& g, uint32_t k, LandmarkSelection selection, unsigned threads = 0, uint32_t seed = 1) {
+        nodes = g.numNodes();
+        landmarkIds.clear();
+        rows.clear();
+        scales.clear();
+        stride = 0;
+        fingerprint = graphFingerprint(g);
+        if (nodes == 0) return;
+
+        k = std::min(std::min(k, MAX_LANDMARKS), (uint32_t)nodes);
+        if (selection == LANDMARKS_AVOID) selectAvoid(g, k, seed);
+        else selectFarthest(g, k, seed);
+
+        stride = (count() + LANES - 1) / LANES * LANES;
+        rows.assign((size_t)nodes * 2 * stride, INFINITE_LANE);
+        scales.assign(2 * stride, 0.0f);
+
+        if (threads == 0) threads = defaultThreadCount();
+        std::vector<SearchContext> contexts(threads);
+        std::vector<std::vector<double> > dist(threads);
+        parallelFor(2 * count(), threads, [this, &g, &contexts, &dist](size_t task, unsigned w) {
+            uint32_t landmark = (uint32_t)task / 2;
+            bool toLandmark = (task % 2) == 1;
+            if (toLandmark) dijkstraDistances(ReverseView(g), contexts[w], landmarkIds[landmark], dist[w]);
+            else dijkstraDistances(g, contexts[w], landmarkIds[landmark], dist[w]);
+            storeLane(toLandmark ? stride + landmark : landmark, dist[w], toLandmark);
+        });
+    }
+
+    // Binary file: header, landmark ids, lane scales, rows
+    bool save(const std::string& path, std::string& error) const {
+        std::ofstream out(path.c_str(), std::ios::binary);
+        if (!out) {
+            error = "cannot open " + path + " for writing";
+            return false;
+        }
+        uint32_t header[4] = {FILE_MAGIC, FILE_VERSION, nodes, stride};
+        uint32_t k = count();
+        out.write((const char*)header, sizeof(header));
+        out.write((const char*)&fingerprint, sizeof(fingerprint));
+        out.write((const char*)&k, sizeof(k));
+        out.write((const char*)landmarkIds.data(), k * sizeof(NodeId));
+        out.write((const char*)scales.data(), scales.size() * sizeof(float));
+        out.write((const char*)rows.data(), rows.size() * sizeof(uint16_t));
+        if (!out) {
+            error = "write to " + path + " failed";
+            return false;
+        }
+        return true;
+    }
+
+    // Load a table saved by save(); fails if it was built for another graph
+    bool load(const std::string& path, const CsrGraph& g, std::string& error) {
+        std::ifstream in(path.c_str(), std::ios::binary);
+        if (!in) {
+            error = "cannot open " + path;
+            return false;
+        }
+        uint32_t header[4];
+        uint64_t fileFingerprint = 0;
+        uint32_t k = 0;
+        in.read((char*)header, sizeof(header));
+        in.read((char*)&fileFingerprint, sizeof(fileFingerprint));
+        in.read((char*)&k, sizeof(k));
+        if (!in || header[0] != FILE_MAGIC || header[1] != FILE_VERSION) {
+            error = path + " is not a landmark table";
+            return false;
+        }
+        if (header[2] != g.numNodes() || fileFingerprint != graphFingerprint(g)) {
+            error = path + " was built for a different graph version";
+            return false;
+        }
+        if (k > MAX_LANDMARKS || header[3] < k || header[3] % LANES != 0) {
+            error = path + " has a corrupt header";
+            return false;
+        }
+
+        nodes = header[2];
+        stride = header[3];
+        fingerprint = fileFingerprint;
+        landmarkIds.resize(k);
+        scales.resize(2 * stride);
+        rows.resize((size_t)nodes * 2 * stride);
+        in.read((char*)landmarkIds.data(), k * sizeof(NodeId));
+        in.read((char*)scales.data(), scales.size() * sizeof(float));
+        in.read((char*)rows.data(), rows.size() * sizeof(uint16_t));
+        if (!in) {
+            error = path + " is truncated";
+            landmarkIds.clear();
+            rows.clear();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static const uint32_t LANES = 8;              // 16-bit lanes per SSE2 register
+    static const uint16_t INFINITE_LANE = 0xFFFF; // unreachable
+    static const uint16_t MAX_LANE = 0xFFFE;      // largest finite quantized distance
+    static const uint32_t FILE_MAGIC = 0x314C5441; // "ATL1" little-endian
+    static const uint32_t FILE_VERSION = 1;
+
+    // Quantize one lane (one landmark, one direction) of every row
+    void storeLane(uint32_t lane, const std::vector<double>& dist, bool complement) {
+        double maxDist = 0;
+        for (NodeId v = 0; v < nodes; v++) {
+            if (dist[v] != INFINITE_COST) maxDist = std::max(maxDist, dist[v]);
+        }
+        double scale = maxDist > 0 ? maxDist / MAX_LANE : 1.0;
+        // Store the scale rounded up so decoding never overestimates
+        float storedScale = (float)scale;
+        if ((double)storedScale < scale) storedScale = std::nextafter(storedScale, 2 * storedScale + 1);
+        scales[lane] = storedScale;
+
+        for (NodeId v = 0; v < nodes; v++) {
+            uint16_t q = INFINITE_LANE;
+            if (dist[v] != INFINITE_COST) {
+                double units = std::floor(dist[v] / storedScale);
+                q = (uint16_t)std::min<double>(units, MAX_LANE);
+                if (complement) q = MAX_LANE - q;
+            }
+            rows[(size_t)v * 2 * stride + lane] = q;
+        }
+    }
+
+    double boundScalar(const uint16_t* goalRow, const uint16_t* nodeRow) const {
+        float best = 0;
+        for (uint32_t lane = 0; lane < 2 * stride; lane++) {
+            uint16_t a = goalRow[lane], b = nodeRow[lane];
+            if (a == INFINITE_LANE || b == INFINITE_LANE || a <= b + 1) continue;
+            best = std::max(best, (float)(a - b - 1) * scales[lane]);
+        }
+        return best;
+    }
+
+#ifdef LANDMARKS_SSE2
+    double boundSse2(const uint16_t* goalRow, const uint16_t* nodeRow) const {
+        const __m128i inf = _mm_set1_epi16((short)INFINITE_LANE);
+        const __m128i one = _mm_set1_epi16(1);
+        const __m128i zero = _mm_setzero_si128();
+        __m128 best = _mm_setzero_ps();
+        for (uint32_t lane = 0; lane < 2 * stride; lane += LANES) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(goalRow + lane));
+            __m128i b = _mm_loadu_si128((const __m128i*)(nodeRow + lane));
+            __m128i diff = _mm_subs_epu16(_mm_subs_epu16(a, b), one);
+            __m128i invalid = _mm_or_si128(_mm_cmpeq_epi16(a, inf), _mm_cmpeq_epi16(b, inf));
+            diff = _mm_andnot_si128(invalid, diff);
+
+            // Widen to 32-bit, convert to float and apply the per-lane scale
+            __m128 low = _mm_cvtepi32_ps(_mm_unpacklo_epi16(diff, zero));
+            __m128 high = _mm_cvtepi32_ps(_mm_unpackhi_epi16(diff, zero));
+            best = _mm_max_ps(best, _mm_mul_ps(low, _mm_loadu_ps(&scales[lane])));
+            best = _mm_max_ps(best, _mm_mul_ps(high, _mm_loadu_ps(&scales[lane + 4])));
+        }
+        best = _mm_max_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(1, 0, 3, 2)));
+        best = _mm_max_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(best);
+    }
+#endif
+
+    // Farthest selection: start from the node farthest from a random root,
+    // then keep adding the node whose nearest landmark is farthest away
+    void selectFarthest(const CsrGraph& g, uint32_t k, uint32_t seed) {
+        SearchContext ctx;
+        std::vector<double> dist, nearest(nodes, INFINITE_COST);
+        std::mt19937 rng(seed);
+        NodeId root = std::uniform_int_distribution<NodeId>(0, nodes - 1)(rng);
+        dijkstraDistances(g, ctx, root, dist);
+        NodeId next = farthestNode(dist, root);
+
+        std::vector<char> chosen(nodes, 0);
+        while (count() < k) {
+            landmarkIds.push_back(next);
+            chosen[next] = 1;
+            dijkstraDistances(g, ctx, next, dist);
+            for (NodeId v = 0; v < nodes; v++) nearest[v] = std::min(nearest[v], dist[v]);
+
+            // Nodes no landmark reaches are skipped so small components don't eat landmarks
+            next = INVALID_NODE;
+            for (NodeId v = 0; v < nodes; v++) {
+                if (chosen[v] || nearest[v] == INFINITE_COST) continue;
+                if (next == INVALID_NODE || nearest[v] > nearest[next]) next = v;
+            }
+            if (next == INVALID_NODE) break;
+        }
+    }
+
+    NodeId farthestNode(const std::vector<double>& dist, NodeId fallback) const {
+        NodeId best = fallback;
+        for (NodeId v = 0; v < nodes; v++) {
+            if (dist[v] != INFINITE_COST && (dist[best] == INFINITE_COST || dist[v] > dist[best])) best = v;
+        }
+        return best;
+    }
+
+    // Avoid selection: build a shortest-path tree from a random root, weigh
+    // every node by how much the current landmarks underestimate its
+    // distance from the root, and walk down into the heaviest subtree that
+    // contains no landmark yet. The leaf reached becomes the new landmark.
+    void selectAvoid(const CsrGraph& g, uint32_t k, uint32_t seed) {
+        SearchContext ctx;
+        std::mt19937 rng(seed);
+        std::vector<double> rootDist, landmarkDist;
+        std::vector<std::vector<float> > fromLandmark, toLandmark; // exact distances of chosen landmarks
+        std::vector<char> isLandmark(nodes, 0);
+        std::vector<NodeId> order, parent(nodes), childOffsets(nodes + 1), children;
+        std::vector<double> size(nodes);
+        std::vector<char> covered(nodes);
+
+        for (uint32_t attempt = 0; count() < k && attempt < 4 * k; attempt++) {
+            NodeId root = std::uniform_int_distribution<NodeId>(0, nodes - 1)(rng);
+            shortestPathTree(g, ctx, root, rootDist, order, parent);
+
+            // Children lists of the tree in settle order
+            std::fill(childOffsets.begin(), childOffsets.end(), 0);
+            for (size_t i = 1; i < order.size(); i++) childOffsets[parent[order[i]] + 1]++;
+            for (NodeId v = 0; v < nodes; v++) childOffsets[v + 1] += childOffsets[v];
+            children.resize(order.size());
+            std::vector<NodeId> cursor(childOffsets.begin(), childOffsets.end() - 1);
+            for (size_t i = 1; i < order.size(); i++) children[cursor[parent[order[i]]]++] = order[i];
+
+            // Subtree sizes bottom-up; subtrees holding a landmark are covered
+            for (size_t i = order.size(); i-- > 0;) {
+                NodeId v = order[i];
+                double lower = 0;
+                for (size_t l = 0; l < fromLandmark.size(); l++) {
+                    double a = fromLandmark[l][v] - fromLandmark[l][root];
+                    double b = toLandmark[l][root] - toLandmark[l][v];
+                    if (std::isfinite(a)) lower = std::max(lower, a);
+                    if (std::isfinite(b)) lower = std::max(lower, b);
+                }
+                size[v] = std::max(0.0, rootDist[v] - lower);
+                covered[v] = isLandmark[v];
+                for (NodeId c = childOffsets[v]; c < childOffsets[v + 1]; c++) {
+                    NodeId child = children[c];
+                    covered[v] |= covered[child];
+                    size[v] += size[child];
+                }
+                if (covered[v]) size[v] = 0;
+            }
+            // Start from the heaviest uncovered subtree and follow heavy children to a leaf
+            NodeId leaf = root;
+            for (size_t i = 0; i < order.size(); i++) {
+                if (size[order[i]] > size[leaf]) leaf = order[i];
+            }
+            if (size[leaf] <= 0) continue;
+
+            while (childOffsets[leaf] < childOffsets[leaf + 1]) {
+                NodeId heaviest = INVALID_NODE;
+                for (NodeId c = childOffsets[leaf]; c < childOffsets[leaf + 1]; c++) {
+                    NodeId child = children[c];
+                    if (heaviest == INVALID_NODE || size[child] > size[heaviest]) heaviest = child;
+                }
+                if (size[heaviest] <= 0) break;
+                leaf = heaviest;
+            }
+
+            landmarkIds.push_back(leaf);
+            isLandmark[leaf] = 1;
+            dijkstraDistances(g, ctx, leaf, landmarkDist);
+            fromLandmark.push_back(std::vector<float>(landmarkDist.begin(), landmarkDist.end()));
+            dijkstraDistances(ReverseView(g), ctx, leaf, landmarkDist);
+            toLandmark.push_back(std::vector<float>(landmarkDist.begin(), landmarkDist.end()));
+        }
+
+        // Top up with farthest selection if the trees ran out of uncovered subtrees
+        if (count() < k) {
+            std::vector<NodeId> picked = landmarkIds;
+            landmarkIds.clear();
+            selectFarthest(g, k, seed);
+            for (size_t i = 0; i < landmarkIds.size() && picked.size() < k; i++) {
+                if (std::find(picked.begin(), picked.end(), landmarkIds[i]) == picked.end()) {
+                    picked.push_back(landmarkIds[i]);
+                }
+            }
+            landmarkIds = picked;
+        }
+    }
+
+    // Dijkstra recording the settle order and tree parents
+    void shortestPathTree(const CsrGraph& g, SearchContext& ctx, NodeId root, std::vector<double>& dist,
+                          std::vector<NodeId>& order, std::vector<NodeId>& parent) {
+        IndexedDaryHeap<4>& open = ctx.quaternaryHeap;
+        ctx.reset(nodes);
+        open.reset(nodes);
+        order.clear();
+        ctx.setG(root, 0, INVALID_NODE);
+        open.push(root, 0);
+        while (!open.empty()) {
+            NodeId current = open.pop();
+            order.push_back(current);
+            double currentG = ctx.g(current);
+            for (EdgeId e = g.edgeBegin(current); e < g.edgeEnd(current); e++) {
+                NodeId neighbor = g.target(e);
+                double tentative = currentG + g.weight(e);
+                if (tentative < ctx.g(neighbor)) {
+                    ctx.setG(neighbor, tentative, current);
+                    open.push(neighbor, tentative);
+                }
+            }
+        }
+        dist.resize(nodes);
+        for (NodeId v = 0; v < nodes; v++) {
+            dist[v] = ctx.g(v);
+            parent[v] = ctx.parentOf(v);
+        }
+    }
+
+    NodeId nodes;
+    uint32_t stride; // landmarks per direction, padded to a multiple of LANES
+    uint64_t fingerprint;
+    std::vector<NodeId> landmarkIds;
+    std::vector<float> scales;  // 2 * stride, one per lane
+    std::vector<uint16_t> rows; // nodes * 2 * stride
+};
+
+const uint32_t LandmarkTable::MAX_LANDMARKS;
+const uint32_t LandmarkTable::LANES;
+const uint16_t LandmarkTable::INFINITE_LANE;
+const uint16_t LandmarkTable::MAX_LANE;
+const uint32_t LandmarkTable::FILE_MAGIC;
+const uint32_t LandmarkTable::FILE_VERSION;
+
+#endif
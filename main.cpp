@@ -7,268 +7,745 @@
 #include <climits>
 #include <algorithm>
 #include <iomanip>
+#include <memory>
+#include <chrono>
+#include <fstream>
+#include <sstream>
 
-using namespace std;
+#include "csr_graph.h"
+#include "search_context.h"
+#include "astar_search.h"
+#include "batch_query.h"
+#include "distance_table.h"
+#include "bidirectional_astar.h"
+#include "landmarks.h"
+#include "contraction_hierarchy.h"
+#include "graph_file.h"
+#include "grid_search.h"
+#include "incremental_search.h"
+#include "graph_snapshot.h"
+#include "path_cache.h"
+#include "graph_reorder.h"
+#include "arena.h"
+#include "delta_stepping.h"
+#include "isochrone.h"
+#include "query_server.h"
+#include "result_writer.h"
 
-// Structure to represent a node in the graph
-struct Node {
-    string name;
-    double x, y; // Coordinates for heuristic calculation
-    
-    Node() : name(""), x(0), y(0) {}
-    Node(string n, double xPos = 0, double yPos = 0) : name(n), x(xPos), y(yPos) {}
-};
-
-// Structure to represent an edge
-struct Edge {
-    string destination;
-    double weight;
-    
-    Edge(string dest, double w) : destination(dest), weight(w) {}
-};
+using namespace std;
 
 // Graph class
+// Nodes and edges are collected by a mutable builder and frozen into a
+// compressed-sparse-row graph the first time a query needs them.
 class Graph {
 private:
-    map<string, Node> nodes;
-    map<string, vector<Edge>> adjacencyList;
+    CsrBuilder builder;
+    CsrGraph csr;
+    bool dirty = false;
+    bool builderStale = false; // csr came from a file and the builder is empty
+    bool ownsWeights = false; // csr's weight array is not shared with a graph passed to assign
+    SearchContext searchContext; // scratch space reused by every query
+    unique_ptr<BatchQueryEngine> batchEngine; // created on the first batch
+    DistanceTableEngine tableEngine;
+    IsochroneEngine isochroneEngine;
+    vector<IsochroneEngine> isochroneWorkers; // one per thread of reachableWithin batches
+    BidirectionalAStar bidirectional;
+    LandmarkTable landmarks; // ALT table, dropped whenever the graph changes
+    ContractionHierarchy hierarchy; // likewise
+    ChQuery hierarchyQuery;
+    SearchStats* statsSink = nullptr; // collects search counters when set
+    
+    // Routes planned with aStarIncremental, repaired after weight changes
+    struct IncrementalRoute {
+        LpaStar planner;
+        size_t appliedChanges = 0; // prefix of edgeChanges already repaired
+    };
+    map<pair<NodeId, NodeId>, unique_ptr<IncrementalRoute>> routes;
+    vector<EdgeId> edgeChanges; // edges whose weight changed, oldest first
+    static const size_t MAX_ROUTE_LAG = 4096; // changes a route may fall behind, see trimEdgeChanges
+    SnapshotGraph published; // versions for query threads, see publishSnapshot
+    unique_ptr<PathCache> pathCache; // optional, see enablePathCache
+    uint64_t graphVersion = 0; // bumped whenever cached paths may be stale
+    vector<NodeId> cachedPath; // path returned by findPathIds on a cache hit
+    vector<double> cachedCosts; // its costs, see pathCosts
+    SpatialIndex spatial; // node coordinates, built on the first spatial query
+    bool spatialStale = true;
+    OutputBuffer out{cout}; // results and messages, written in blocks
 
 public:
     // Add a node to the graph
     void addNode(const string& name, double x = 0, double y = 0) {
-        nodes[name] = Node(name, x, y);
-        if (adjacencyList.find(name) == adjacencyList.end()) {
-            adjacencyList[name] = vector<Edge>();
-        }
+        syncBuilder();
+        builder.addNode(name, x, y);
+        dirty = true;
     }
     
     // Add an edge between two nodes
     void addEdge(const string& from, const string& to, double weight) {
+        syncBuilder();
+        NodeId fromId = builder.findNode(from);
+        NodeId toId = builder.findNode(to);
+
         // Check if both nodes exist
-        if (nodes.find(from) == nodes.end() || nodes.find(to) == nodes.end()) {
-            cout << "Error: One or both nodes don't exist!" << endl;
+        if (fromId == INVALID_NODE || toId == INVALID_NODE) {
+            out << "Error: One or both nodes don't exist!\n";
             return;
         }
         
-        adjacencyList[from].push_back(Edge(to, weight));
-        cout << "Edge added: " << from << " -> " << to << " (weight: " << weight << ")" << endl;
+        builder.addEdge(fromId, toId, weight);
+        dirty = true;
+        out << "Edge added: " << from << " -> " << to << " (weight: " << weight << ")\n";
+    }
+
+    // Freeze pending builder changes into the CSR graph
+    void finalize() {
+        if (dirty) {
+            csr = builder.finalize();
+            ownsWeights = true;
+            dirty = false;
+            landmarks = LandmarkTable();
+            hierarchy = ContractionHierarchy();
+            clearIncrementalRoutes();
+            graphVersion++;
+            spatialStale = true;
+        }
+    }
+
+    // Read-only view used by the search engines
+    const CsrGraph& frozen() {
+        finalize();
+        return csr;
+    }
+    
+    // Map a binary graph file (see graph_file.h) and query it in place;
+    // nothing is parsed or copied until the graph is edited
+    bool loadGraphFile(const string& path) {
+        string error;
+        CsrGraph loaded;
+        if (!openGraphFile(path, loaded, error)) {
+            out << "Error: " << error << '\n';
+            return false;
+        }
+        assign(loaded);
+        return true;
+    }
+    
+    // Replace the graph with an already frozen one, e.g. from a generator
+    void assign(const CsrGraph& graph) {
+        csr = graph;
+        ownsWeights = false;
+        dirty = false;
+        builderStale = true;
+        builder = CsrBuilder();
+        landmarks = LandmarkTable();
+        hierarchy = ContractionHierarchy();
+        clearIncrementalRoutes();
+        graphVersion++;
+        spatialStale = true;
+    }
+    
+    // Renumber the nodes for cache locality (see graph_reorder.h). Names
+    // and results are unchanged; ids, and everything derived from them,
+    // are rebuilt.
+    void reorderNodes(NodeOrder order) {
+        const CsrGraph& g = frozen();
+        assign(reorderGraph(g, computeNodeOrder(g, order)));
+    }
+    
+    // Change the weight of every from -> to edge in place, without
+    // refreezing the graph. A graph given to assign is never changed. Routes planned with aStarIncremental are
+    // repaired on their next query instead of being planned again.
+    bool updateEdge(const string& from, const string& to, double weight) {
+        const CsrGraph& g = frozen();
+        NodeId fromId = g.findNode(from);
+        NodeId toId = g.findNode(to);
+        if (fromId == INVALID_NODE || toId == INVALID_NODE || g.findEdge(fromId, toId) == g.numEdges()) {
+            out << "Error: No edge from " << from << " to " << to << "!\n";
+            return false;
+        }
+        
+        if (!ownsWeights) {
+            // The weights belong to the graph given to assign (or to a
+            // read-only mapped file): copy them once before the first edit,
+            // so the caller's graph and its copies keep their weights.
+            // Planned routes hold the old array and are planned again.
+            csr = csr.withPrivateWeights();
+            ownsWeights = true;
+            clearIncrementalRoutes();
+        }
+        bool cheaper = false;
+        for (EdgeId e = csr.edgeBegin(fromId); e < csr.edgeEnd(fromId); e++) {
+            if (csr.target(e) == toId) {
+                cheaper = cheaper || weight < csr.weight(e);
+                csr.setWeight(e, weight);
+                edgeChanges.push_back(e);
+            }
+        }
+        trimEdgeChanges();
+        
+        // A dearer edge only spoils the cached paths over it; a cheaper
+        // one may shorten any path
+        if (cheaper) {
+            graphVersion++;
+        } else if (pathCache) {
+            pathCache->invalidateEdge(fromId, toId);
+        }
+        
+        // The builder is refilled from csr before the next edit, and
+        // preprocessing built for the old weights no longer holds
+        builderStale = true;
+        builder = CsrBuilder();
+        landmarks = LandmarkTable();
+        hierarchy = ContractionHierarchy();
+        return true;
+    }
+    
+    // Remove every from -> to edge. The edge stays in the frozen graph
+    // with infinite weight, which no search can use, until the next edit.
+    bool removeEdge(const string& from, const string& to) {
+        return updateEdge(from, to, INFINITE_COST);
+    }
+    
+    // Make the current graph, with all edits so far, the version that
+    // query threads pinning snapshots() see. Graph itself is not thread
+    // safe: edit it from one thread and let the others query snapshots.
+    uint64_t publishSnapshot() {
+        return published.publish(frozen());
+    }
+    
+    SnapshotGraph& snapshots() {
+        return published;
+    }
+    
+    // Write the current graph as a binary graph file
+    bool saveGraphFile(const string& path) {
+        string error;
+        if (!writeGraphFile(frozen(), path, error)) {
+            out << "Error: " << error << '\n';
+            return false;
+        }
+        return true;
     }
     
     // Display the graph
     void displayGraph() {
-        cout << "\n=== GRAPH STRUCTURE ===" << endl;
-        cout << "Nodes:" << endl;
-        for (const auto& pair : nodes) {
-            cout << "  " << pair.first << " (x: " << pair.second.x 
-                 << ", y: " << pair.second.y << ")" << endl;
-        }
-        
-        cout << "\nEdges:" << endl;
-        for (const auto& pair : adjacencyList) {
-            if (!pair.second.empty()) {
-                cout << "  " << pair.first << " -> ";
-                for (size_t i = 0; i < pair.second.size(); i++) {
-                    cout << pair.second[i].destination << "(" << pair.second[i].weight << ")";
-                    if (i < pair.second.size() - 1) cout << ", ";
-                }
-                cout << endl;
+        const CsrGraph& g = frozen();
+
+        out << "\n=== GRAPH STRUCTURE ===\n";
+        out << "Nodes:\n";
+        for (NodeId u = 0; u < g.numNodes(); u++) {
+            out << "  " << g.name(u) << " (x: " << g.x(u) 
+                 << ", y: " << g.y(u) << ")\n";
+        }
+        
+        // Removed edges (infinite weight) stay in the frozen graph until
+        // the next edit, but are not listed
+        out << "\nEdges:\n";
+        for (NodeId u = 0; u < g.numNodes(); u++) {
+            bool listed = false;
+            for (EdgeId e = g.edgeBegin(u); e < g.edgeEnd(u); e++) {
+                if (g.weight(e) == INFINITE_COST) continue;
+                if (listed) out << ", ";
+                else out << "  " << g.name(u) << " -> ";
+                out << g.name(g.target(e)) << "(" << g.weight(e) << ")";
+                listed = true;
             }
+            if (listed) out << '\n';
+        }
+        out << "\nMemory:\n";
+        displayMemoryUsage();
+        out << "======================\n";
+    }
+    
+    // Bytes held by the frozen graph and by the builder, in total and per
+    // node and edge
+    void displayMemoryUsage() {
+        const CsrGraph& g = frozen();
+        double nodes = max<double>(1, g.numNodes());
+        double edges = max<double>(1, g.numEdges());
+        out << "  Graph: " << g.memoryBytes() << " bytes (";
+        out.fixed(g.edgeBytes() / edges, 1) << " per edge, ";
+        out.fixed((g.memoryBytes() - g.edgeBytes()) / nodes, 1) << " per node)\n";
+        if (builderStale) {
+            out << "  Builder: empty, refilled from the graph on the next edit\n";
+        } else {
+            out << "  Builder: " << builder.memoryBytes() << " bytes (" << builder.numNodes() << " nodes, "
+                << builder.numEdges() << " edges)\n";
         }
-        cout << "======================" << endl;
     }
     
     // Calculate Euclidean distance as heuristic
     double calculateHeuristic(const string& from, const string& to) {
-        if (nodes.find(from) == nodes.end() || nodes.find(to) == nodes.end()) {
+        const CsrGraph& g = frozen();
+        NodeId fromId = g.findNode(from);
+        NodeId toId = g.findNode(to);
+        if (fromId == INVALID_NODE || toId == INVALID_NODE) {
             return 0;
         }
         
-        Node fromNode = nodes[from];
-        Node toNode = nodes[to];
-        
-        return sqrt(pow(toNode.x - fromNode.x, 2) + pow(toNode.y - fromNode.y, 2));
+        return calculateHeuristic(g, fromId, toId);
+    }
+
+    // Euclidean distance between two node ids
+    static double calculateHeuristic(const CsrGraph& g, NodeId from, NodeId to) {
+        return euclideanHeuristic(g, from, to);
     }
     
     // A* Algorithm implementation
-    vector<string> aStar(const string& start, const string& goal) {
-        if (nodes.find(start) == nodes.end() || nodes.find(goal) == nodes.end()) {
-            cout << "Error: Start or goal node doesn't exist!" << endl;
+    // openList selects the open-set data structure (see open_list.h)
+    vector<string> aStar(const string& start, const string& goal,
+                         OpenListKind openList = OPEN_LIST_QUATERNARY_HEAP) {
+        const CsrGraph& g = frozen();
+        NodeId startId = g.findNode(start);
+        NodeId goalId = g.findNode(goal);
+        if (startId == INVALID_NODE || goalId == INVALID_NODE) {
+            out << "Error: Start or goal node doesn't exist!\n";
             return vector<string>();
         }
         
-        // Priority queue for open set (f_score, node_name)
-        priority_queue<pair<double, string>, vector<pair<double, string>>, greater<pair<double, string>>> openSet;
-        
-        // Maps to store scores and came_from relationships
-        map<string, double> gScore; // Cost from start to node
-        map<string, double> fScore; // gScore + heuristic
-        map<string, string> cameFrom; // For path reconstruction
-        set<string> openSetNodes;
+        const vector<NodeId>* pathIds = findPathIds(startId, goalId, openList);
+        if (pathIds == nullptr) {
+            return vector<string>(); // No path found
+        }
         
-        // Initialize all nodes with infinite scores
-        for (const auto& pair : nodes) {
-            gScore[pair.first] = INT_MAX;
-            fScore[pair.first] = INT_MAX;
+        vector<string> path;
+        path.reserve(pathIds->size());
+        for (NodeId id : *pathIds) {
+            path.push_back(g.name(id));
+        }
+        return path;
+    }
+    
+    // Id-level A* that reuses the graph's search context.
+    // Returns the path as node ids, or nullptr if no path exists; the
+    // vector is owned by the context and valid until the next search.
+    const vector<NodeId>* findPathIds(NodeId startId, NodeId goalId,
+                                      OpenListKind openList = OPEN_LIST_QUATERNARY_HEAP) {
+        const CsrGraph& g = frozen();
+        double cost;
+        if (pathCache && pathCache->lookup(startId, goalId, graphVersion, cachedPath, cost)) {
+            return cachedPath.empty() ? nullptr : &cachedPath;
         }
         
-        // Initialize start node
-        gScore[start] = 0;
-        fScore[start] = calculateHeuristic(start, goal);
-        openSet.push({fScore[start], start});
-        openSetNodes.insert(start);
+        if (astarSearch(g, searchContext, startId, goalId, openList, &landmarks, statsSink) == INFINITE_COST) {
+            if (pathCache) pathCache->insert(startId, goalId, graphVersion, INFINITE_COST, vector<NodeId>());
+            return nullptr;
+        }
+        chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+        const vector<NodeId>* path = &searchContext.buildPath(goalId);
+        if (statsSink) {
+            statsSink->pathMicros += chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count();
+        }
+        if (pathCache) pathCache->insert(startId, goalId, graphVersion, searchContext.g(goalId), *path);
+        return path;
+    }
+    
+    // Cost of reaching each node of a path findPathIds just returned, as
+    // the search recorded it (cache hits are charged edge by edge)
+    const vector<double>& pathCosts(const vector<NodeId>& path) {
+        if (&path == &cachedPath) {
+            cachedPathCosts(frozen(), path, cachedCosts);
+            return cachedCosts;
+        }
+        return searchContext.buildPathCosts();
+    }
+    
+    // Everything the graph prints goes through this buffer; the program
+    // flushes it before reading input
+    OutputBuffer& output() {
+        return out;
+    }
+    
+    // Keep up to budgetBytes of path results keyed by (start, goal) for
+    // aStar, findPathIds and batches; 0 turns the cache off. Entries are
+    // dropped when the graph changes in a way that may affect them.
+    void enablePathCache(size_t budgetBytes = 64 << 20) {
+        pathCache.reset(budgetBytes > 0 ? new PathCache(budgetBytes) : nullptr);
+    }
+    
+    // Hit ratio, memory use and eviction counters of the path cache
+    PathCacheStats pathCacheStats() const {
+        return pathCache ? pathCache->stats() : PathCacheStats();
+    }
+    
+    // Add the counters of every following aStar, findPathIds and batch
+    // search to stats (see search_stats.h); nullptr turns collection off
+    void collectSearchStats(SearchStats* stats) {
+        statsSink = stats;
+    }
+    
+    // A* that keeps its search tree (LPA*, see incremental_search.h) per
+    // (start, goal) pair. The first query plans from scratch; later ones
+    // only repair the tree for the edges changed by updateEdge/removeEdge.
+    vector<string> aStarIncremental(const string& start, const string& goal) {
+        const CsrGraph& g = frozen();
+        NodeId startId = g.findNode(start);
+        NodeId goalId = g.findNode(goal);
+        if (startId == INVALID_NODE || goalId == INVALID_NODE) {
+            out << "Error: Start or goal node doesn't exist!\n";
+            return vector<string>();
+        }
         
-        while (!openSet.empty()) {
-            string current = openSet.top().second;
-            openSet.pop();
-            openSetNodes.erase(current);
-            
-            if (current == goal) {
-                // Reconstruct path
-                vector<string> path;
-                string temp = current;
-                while (cameFrom.find(temp) != cameFrom.end()) {
-                    path.push_back(temp);
-                    temp = cameFrom[temp];
-                }
-                path.push_back(start);
-                reverse(path.begin(), path.end());
-                return path;
-            }
-            
-            // Check all neighbors
-            for (const Edge& edge : adjacencyList[current]) {
-                string neighbor = edge.destination;
-                double tentativeGScore = gScore[current] + edge.weight;
-                
-                if (tentativeGScore < gScore[neighbor]) {
-                    cameFrom[neighbor] = current;
-                    gScore[neighbor] = tentativeGScore;
-                    fScore[neighbor] = gScore[neighbor] + calculateHeuristic(neighbor, goal);
-                    
-                    if (openSetNodes.find(neighbor) == openSetNodes.end()) {
-                        openSet.push({fScore[neighbor], neighbor});
-                        openSetNodes.insert(neighbor);
-                    }
-                }
-            }
+        unique_ptr<IncrementalRoute>& route = routes[make_pair(startId, goalId)];
+        if (!route) {
+            route.reset(new IncrementalRoute());
+            route->planner.search(g, startId, goalId);
+        } else if (route->appliedChanges < edgeChanges.size()) {
+            route->planner.update(&edgeChanges[route->appliedChanges], edgeChanges.size() - route->appliedChanges);
         }
+        route->appliedChanges = edgeChanges.size();
+        trimEdgeChanges();
         
-        return vector<string>(); // No path found
+        vector<string> path;
+        for (NodeId id : route->planner.buildPath()) {
+            path.push_back(g.name(id));
+        }
+        return path;
     }
-      // Display A* result
-    void displayAStarResult(const string& start, const string& goal) {
-        cout << "\n=== A* PATHFINDING RESULT ===" << endl;
-        cout << "Finding shortest path from " << start << " to " << goal << endl;
+    
+    // Forget the search trees of aStarIncremental
+    void clearIncrementalRoutes() {
+        routes.clear();
+        edgeChanges.clear();
+    }
+    
+    // Bidirectional A* (forward from start, backward from goal). With
+    // parallel set, the two directions run on separate threads.
+    vector<string> aStarBidirectional(const string& start, const string& goal, bool parallel = false) {
+        const CsrGraph& g = frozen();
+        NodeId startId = g.findNode(start);
+        NodeId goalId = g.findNode(goal);
+        if (startId == INVALID_NODE || goalId == INVALID_NODE) {
+            out << "Error: Start or goal node doesn't exist!\n";
+            return vector<string>();
+        }
         
-        vector<string> path = aStar(start, goal);
+        vector<string> path;
+        if (bidirectional.search(g, startId, goalId, parallel) == INFINITE_COST) {
+            return path; // No path found
+        }
+        for (NodeId id : bidirectional.buildPath()) {
+            path.push_back(g.name(id));
+        }
+        return path;
+    }
+    
+    // Precompute an ALT landmark table; aStar, findPathIds and the batch
+    // queries use it instead of the Euclidean heuristic until the graph changes
+    void buildLandmarks(uint32_t count = 16, LandmarkSelection selection = LANDMARKS_AVOID) {
+        landmarks.build(frozen(), count, selection);
+    }
+    
+    // Store the landmark table so it can be loaded instead of rebuilt
+    bool saveLandmarks(const string& path) {
+        string error;
+        if (landmarks.empty()) {
+            out << "Error: No landmark table to save!\n";
+            return false;
+        }
+        if (!landmarks.save(path, error)) {
+            out << "Error: " << error << '\n';
+            return false;
+        }
+        return true;
+    }
+    
+    // Load a saved landmark table; rejected if it belongs to another graph version
+    bool loadLandmarks(const string& path) {
+        string error;
+        if (!landmarks.load(path, frozen(), error)) {
+            out << "Error: " << error << '\n';
+            return false;
+        }
+        return true;
+    }
+    
+    bool hasLandmarks() const {
+        return !landmarks.empty();
+    }
+    
+    // Shortest path through the contraction hierarchy, unpacked to the
+    // same node-name path aStar returns. Contracts the graph on first use.
+    vector<string> shortestPathHierarchy(const string& start, const string& goal) {
+        const CsrGraph& g = frozen();
+        NodeId startId = g.findNode(start);
+        NodeId goalId = g.findNode(goal);
+        if (startId == INVALID_NODE || goalId == INVALID_NODE) {
+            out << "Error: Start or goal node doesn't exist!\n";
+            return vector<string>();
+        }
+        if (hierarchy.empty()) {
+            buildHierarchy();
+        }
         
-        if (path.empty()) {
-            cout << "No path found!" << endl;
-            return;
+        vector<string> path;
+        if (hierarchyQuery.search(hierarchy, startId, goalId) == INFINITE_COST) {
+            return path; // No path found
+        }
+        for (NodeId id : hierarchyQuery.buildPath(hierarchy)) {
+            path.push_back(g.name(id));
+        }
+        return path;
+    }
+    
+    // Contract the graph (parallel over independent node sets)
+    void buildHierarchy() {
+        hierarchy.build(frozen());
+    }
+    
+    // Store the contraction hierarchy so it can be loaded instead of rebuilt
+    bool saveHierarchy(const string& path) {
+        string error;
+        if (hierarchy.empty()) {
+            out << "Error: No contraction hierarchy to save!\n";
+            return false;
+        }
+        if (!hierarchy.save(path, error)) {
+            out << "Error: " << error << '\n';
+            return false;
+        }
+        return true;
+    }
+    
+    // Load a saved hierarchy; rejected if it belongs to another graph version
+    bool loadHierarchy(const string& path) {
+        string error;
+        if (!hierarchy.load(path, frozen(), error)) {
+            out << "Error: " << error << '\n';
+            return false;
+        }
+        return true;
+    }
+    
+    // Number of scratch buffer growths across all searches so far
+    uint64_t searchAllocationCount() const {
+        return searchContext.allocationCount();
+    }
+    
+    // Nodes expanded by the last aStar / findPathIds call
+    uint64_t searchExpandedCount() const {
+        return searchContext.expandedCount();
+    }
+    
+    // Answer many (start, goal) pairs at once on all cores.
+    // paths[i] is empty and costs[i] is INFINITE_COST when there is no path
+    // (or a node doesn't exist). Nothing is printed per query.
+    BatchReport batchAStar(const vector<pair<string, string>>& queries,
+                           vector<vector<string>>& paths, vector<double>& costs,
+                           OpenListKind openList = OPEN_LIST_QUATERNARY_HEAP) {
+        const CsrGraph& g = frozen();
+        vector<PathQuery> batch(queries.size());
+        for (size_t i = 0; i < queries.size(); i++) {
+            batch[i].start = g.findNode(queries[i].first);
+            batch[i].goal = g.findNode(queries[i].second);
         }
         
-        cout << "Path found: ";
-        double totalCost = 0;
+        vector<PathResult> results;
+        BatchReport report = batchAStarIds(batch, results, openList);
         
-        for (size_t i = 0; i < path.size(); i++) {
-            cout << path[i];
-            
-            if (i < path.size() - 1) {
-                // Find the weight of the edge
-                string current = path[i];
-                string next = path[i + 1];
-                
-                for (const Edge& edge : adjacencyList[current]) {
-                    if (edge.destination == next) {
-                        totalCost += edge.weight;
-                        cout << " -(" << edge.weight << ")-> ";
-                        break;
-                    }
-                }
+        paths.assign(queries.size(), vector<string>());
+        costs.resize(queries.size());
+        for (size_t i = 0; i < results.size(); i++) {
+            costs[i] = results[i].cost;
+            for (NodeId id : results[i].path) {
+                paths[i].push_back(g.name(id));
             }
         }
+        return report;
+    }
+    
+    // Id-level batch; queries with unknown ids get INFINITE_COST
+    BatchReport batchAStarIds(const vector<PathQuery>& queries, vector<PathResult>& results,
+                              OpenListKind openList = OPEN_LIST_QUATERNARY_HEAP) {
+        const CsrGraph& g = frozen();
+        if (!batchEngine) {
+            batchEngine.reset(new BatchQueryEngine());
+        }
+        batchEngine->usePathCache(pathCache.get(), graphVersion);
+        return batchEngine->run(g, queries, results, openList, &landmarks, statsSink);
+    }
+    
+    // Batch between arbitrary positions; each end is snapped to its nearest node
+    BatchReport batchAStarPoints(const vector<PointQuery>& queries, vector<PathResult>& results,
+                                 OpenListKind openList = OPEN_LIST_QUATERNARY_HEAP) {
+        const CsrGraph& g = frozen();
+        const SpatialIndex& index = spatialIndex();
+        if (!batchEngine) {
+            batchEngine.reset(new BatchQueryEngine());
+        }
+        batchEngine->usePathCache(pathCache.get(), graphVersion);
+        return batchEngine->run(g, index, queries, results, openList, &landmarks, statsSink);
+    }
+    
+    // k-d tree over the node coordinates; rebuilt after the graph changes
+    // (weight updates keep it, they do not move nodes)
+    const SpatialIndex& spatialIndex() {
+        const CsrGraph& g = frozen();
+        if (spatialStale) {
+            spatial.build(g);
+            spatialStale = false;
+        }
+        return spatial;
+    }
+    
+    // Name of the node closest to (x, y), empty if the graph is empty
+    string nearestNode(double x, double y) {
+        NodeId id = spatialIndex().nearest(x, y);
+        return id == INVALID_NODE ? string() : csr.name(id);
+    }
+    
+    // Names of the k nodes closest to (x, y), nearest first
+    vector<string> nearestNodes(double x, double y, size_t k) {
+        vector<NodeId> ids;
+        spatialIndex().nearest(x, y, k, ids);
+        vector<string> names;
+        for (NodeId id : ids) names.push_back(csr.name(id));
+        return names;
+    }
+    
+    // Names of the nodes inside the box [minX, maxX] x [minY, maxY]
+    vector<string> nodesInBox(double minX, double minY, double maxX, double maxY) {
+        vector<NodeId> ids;
+        spatialIndex().withinBox(minX, minY, maxX, maxY, ids);
+        vector<string> names;
+        for (NodeId id : ids) names.push_back(csr.name(id));
+        return names;
+    }
+    
+    // Distances from every source to every target with shared searches
+    // instead of one aStar call per pair. Unknown names give rows/columns
+    // of INFINITE_COST.
+    DistanceTable distanceTable(const vector<string>& sources, const vector<string>& targets,
+                                const TableOptions& options = TableOptions()) {
+        const CsrGraph& g = frozen();
+        vector<NodeId> sourceIds, targetIds;
+        for (const string& name : sources) sourceIds.push_back(g.findNode(name));
+        for (const string& name : targets) targetIds.push_back(g.findNode(name));
         
-        cout << endl;
-        cout << "Total path cost: " << fixed << setprecision(2) << totalCost << endl;
-        cout << "Number of nodes in path: " << path.size() << endl;
+        DistanceTable table;
+        tableEngine.manyToMany(g, sourceIds, targetIds, options, table);
+        return table;
+    }
+    
+    // Nodes reachable from source at cost <= budget, sorted by id with
+    // their costs, without searching past the budget. With boundary, also
+    // the edges on which the budget runs out. Unknown sources give an
+    // empty result.
+    Isochrone reachableWithin(const string& source, double budget, bool boundary = false) {
+        const CsrGraph& g = frozen();
+        Isochrone result;
+        isochroneEngine.reachable(g, g.findNode(source), budget, result, boundary);
+        return result;
+    }
+    
+    // One isochrone per source, computed in parallel on up to threads
+    // workers (0 = all cores); overlapping isochrones each keep all their
+    // nodes
+    vector<Isochrone> reachableWithin(const vector<string>& sources, double budget, unsigned threads = 0) {
+        const CsrGraph& g = frozen();
+        vector<NodeId> sourceIds;
+        for (const string& name : sources) sourceIds.push_back(g.findNode(name));
+        vector<Isochrone> results;
+        reachableBatch(g, sourceIds, budget, results, isochroneWorkers, threads);
+        return results;
+    }
+    
+    // Distance from source to every node, indexed by node id (the order
+    // of getAllNodes), with parent[v] the node before v on a shortest path.
+    // Runs parallel delta-stepping on up to threads workers (0 = all
+    // cores); delta 0 picks the bucket width from the edge weights.
+    // Unreachable nodes, and every node if source is unknown, get
+    // INFINITE_COST and INVALID_NODE.
+    SsspReport distancesFrom(const string& source, vector<double>& dist, vector<NodeId>& parent,
+                             unsigned threads = 0, double delta = 0) {
+        const CsrGraph& g = frozen();
+        NodeId sourceId = g.findNode(source);
+        if (sourceId == INVALID_NODE) out << "Error: Source node doesn't exist!\n";
+        return DeltaStepping(threads, delta).run(g, sourceId, dist, parent);
+    }
+    
+    // Display A* result
+    void displayAStarResult(const string& start, const string& goal) {
+        out << "\n=== A* PATHFINDING RESULT ===\n";
+        
+        const CsrGraph& g = frozen();
+        NodeId startId = g.findNode(start);
+        NodeId goalId = g.findNode(goal);
+        if (startId == INVALID_NODE || goalId == INVALID_NODE) {
+            out << "Error: Start or goal node doesn't exist!\n";
+            return;
+        }
+        
+        // Hop weights come from the costs the search recorded
+        ResultWriter writer(out);
+        const vector<NodeId>* path = findPathIds(startId, goalId);
+        if (path == nullptr) {
+            writer.writePath(g, 0, startId, goalId, INFINITE_COST, vector<NodeId>(), vector<double>());
+            return;
+        }
+        const vector<double>& costs = pathCosts(*path);
+        writer.writePath(g, 0, startId, goalId, costs.back(), *path, costs);
         
         // Add path visualization
-        visualizePath(path);
+        vector<string> names;
+        for (NodeId id : *path) names.push_back(g.name(id));
+        visualizePath(names);
         
-        cout << "=============================" << endl;
+        out << "=============================\n";
     }
     
     // Check if a node exists
     bool nodeExists(const string& name) {
-        return nodes.find(name) != nodes.end();
+        if (builderStale) {
+            return csr.findNode(name) != INVALID_NODE;
+        }
+        return builder.findNode(name) != INVALID_NODE;
     }
       // Get all node names
     vector<string> getAllNodes() {
+        const CsrGraph& g = frozen();
         vector<string> nodeNames;
-        for (const auto& pair : nodes) {
-            nodeNames.push_back(pair.first);
+        nodeNames.reserve(g.numNodes());
+        for (NodeId u = 0; u < g.numNodes(); u++) {
+            nodeNames.push_back(g.name(u));
         }
         return nodeNames;
     }
     
     // Visualize the graph in ASCII format
     void visualizeGraph() {
-        cout << "\n=== GRAPH VISUALIZATION ===" << endl;
+        out << "\n=== GRAPH VISUALIZATION ===\n";
         
-        if (nodes.empty()) {
-            cout << "No nodes to display!" << endl;
+        const CsrGraph& g = frozen();
+        if (g.numNodes() == 0) {
+            out << "No nodes to display!\n";
             return;
         }
         
-        // Find bounds for scaling
-        double minX = nodes.begin()->second.x, maxX = nodes.begin()->second.x;
-        double minY = nodes.begin()->second.y, maxY = nodes.begin()->second.y;
-        
-        for (const auto& pair : nodes) {
-            minX = min(minX, pair.second.x);
-            maxX = max(maxX, pair.second.x);
-            minY = min(minY, pair.second.y);
-            maxY = max(maxY, pair.second.y);
-        }
-        
         // Grid dimensions
         const int gridWidth = 40;
         const int gridHeight = 20;
         
-        // Create grid
-        vector<vector<char>> grid(gridHeight, vector<char>(gridWidth, '.'));
-        map<string, pair<int, int>> nodePositions;
+        // Grid and positions are scratch memory, released when we return
+        Arena& scratch = scratchArena();
+        ArenaScope scope(scratch);
+        AsciiGrid grid(scratch, gridWidth, gridHeight, '.');
+        NodePositions nodePositions = placeNodes(scratch, g, gridWidth, gridHeight);
         
         // Place nodes on grid
-        for (const auto& pair : nodes) {
-            double x = pair.second.x;
-            double y = pair.second.y;
-            
-            // Scale to grid
-            int gridX = (maxX == minX) ? gridWidth/2 : (int)((x - minX) / (maxX - minX) * (gridWidth - 1));
-            int gridY = (maxY == minY) ? gridHeight/2 : (int)((maxY - y) / (maxY - minY) * (gridHeight - 1));
-            
-            // Ensure within bounds
-            gridX = max(0, min(gridWidth - 1, gridX));
-            gridY = max(0, min(gridHeight - 1, gridY));
-            
-            nodePositions[pair.first] = {gridY, gridX};
-            grid[gridY][gridX] = pair.first[0]; // Use first character of node name
+        for (NodeId u = 0; u < g.numNodes(); u++) {
+            grid[nodePositions[u].first][nodePositions[u].second] = g.nameData(u)[0]; // Use first character of node name
         }
         
         // Draw edges as lines
-        for (const auto& pair : adjacencyList) {
-            string from = pair.first;
-            if (nodePositions.find(from) == nodePositions.end()) continue;
-            
-            for (const Edge& edge : pair.second) {
-                string to = edge.destination;
-                if (nodePositions.find(to) == nodePositions.end()) continue;
+        for (NodeId u = 0; u < g.numNodes(); u++) {
+            for (EdgeId e = g.edgeBegin(u); e < g.edgeEnd(u); e++) {
+                NodeId v = g.target(e);
                 
-                int y1 = nodePositions[from].first;
-                int x1 = nodePositions[from].second;
-                int y2 = nodePositions[to].first;
-                int x2 = nodePositions[to].second;
+                int y1 = nodePositions[u].first;
+                int x1 = nodePositions[u].second;
+                int y2 = nodePositions[v].first;
+                int x2 = nodePositions[v].second;
                 
                 // Simple line drawing using Bresenham-like approach
                 drawLine(grid, x1, y1, x2, y2, gridWidth, gridHeight);
@@ -276,108 +753,76 @@ public:
         }
         
         // Redraw nodes (to overwrite line characters)
-        for (const auto& pair : nodePositions) {
-            int y = pair.second.first;
-            int x = pair.second.second;
-            grid[y][x] = pair.first[0];
+        for (NodeId u = 0; u < g.numNodes(); u++) {
+            grid[nodePositions[u].first][nodePositions[u].second] = g.nameData(u)[0];
         }
         
-        // Print grid
-        cout << "   ";
-        for (int x = 0; x < gridWidth; x++) {
-            if (x % 5 == 0) cout << (x / 10);
-            else cout << " ";
-        }
-        cout << endl;
-        
-        cout << "   ";
-        for (int x = 0; x < gridWidth; x++) {
-            cout << (x % 10);
-        }
-        cout << endl;
-        
-        for (int y = 0; y < gridHeight; y++) {
-            cout << setfill(' ') << setw(2) << y << " ";
-            for (int x = 0; x < gridWidth; x++) {
-                cout << grid[y][x];
-            }
-            cout << endl;
-        }
+        printGrid(grid, gridWidth, gridHeight);
         
         // Legend
-        cout << "\nLegend:" << endl;
-        cout << "  Nodes: Represented by first letter of node name" << endl;
-        cout << "  Edges: Represented by '-', '|', '/', '\\' characters" << endl;
-        cout << "  Empty: Represented by '.' characters" << endl;
+        out << "\nLegend:\n";
+        out << "  Nodes: Represented by first letter of node name\n";
+        out << "  Edges: Represented by '-', '|', '/', '\\' characters\n";
+        out << "  Empty: Represented by '.' characters\n";
         
         // Node coordinates
-        cout << "\nNode Positions:" << endl;
-        for (const auto& pair : nodes) {
-            cout << "  " << pair.first << ": (" << pair.second.x << ", " << pair.second.y << ")" << endl;
+        out << "\nNode Positions:\n";
+        for (NodeId u = 0; u < g.numNodes(); u++) {
+            out << "  " << g.name(u) << ": (" << g.x(u) << ", " << g.y(u) << ")\n";
         }
         
-        cout << "===========================" << endl;
+        out << "===========================\n";
     }
     
     // Visualize path on the graph
     void visualizePath(const vector<string>& path) {
         if (path.empty()) {
-            cout << "No path to visualize!" << endl;
+            out << "No path to visualize!\n";
             return;
         }
         
-        cout << "\n=== PATH VISUALIZATION ===" << endl;
-        
-        // Find bounds for scaling
-        double minX = nodes.begin()->second.x, maxX = nodes.begin()->second.x;
-        double minY = nodes.begin()->second.y, maxY = nodes.begin()->second.y;
+        out << "\n=== PATH VISUALIZATION ===\n";
         
-        for (const auto& pair : nodes) {
-            minX = min(minX, pair.second.x);
-            maxX = max(maxX, pair.second.x);
-            minY = min(minY, pair.second.y);
-            maxY = max(maxY, pair.second.y);
-        }
+        const CsrGraph& g = frozen();
         
         // Grid dimensions
         const int gridWidth = 40;
         const int gridHeight = 20;
         
-        // Create grid
-        vector<vector<char>> grid(gridHeight, vector<char>(gridWidth, '.'));
-        map<string, pair<int, int>> nodePositions;
+        // Grid and positions are scratch memory, released when we return
+        Arena& scratch = scratchArena();
+        ArenaScope scope(scratch);
+        AsciiGrid grid(scratch, gridWidth, gridHeight, '.');
+        NodePositions nodePositions = placeNodes(scratch, g, gridWidth, gridHeight);
+        
+        // Map path names to ids once
+        ArenaVector<NodeId>::type pathIds{ArenaAllocator<NodeId>(scratch)};
+        ArenaVector<char>::type inPath(g.numNodes(), 0, ArenaAllocator<char>(scratch));
+        for (const string& nodeName : path) {
+            NodeId id = g.findNode(nodeName);
+            pathIds.push_back(id);
+            if (id != INVALID_NODE) inPath[id] = 1;
+        }
         
         // Place all nodes on grid
-        for (const auto& pair : nodes) {
-            double x = pair.second.x;
-            double y = pair.second.y;
-            
-            // Scale to grid
-            int gridX = (maxX == minX) ? gridWidth/2 : (int)((x - minX) / (maxX - minX) * (gridWidth - 1));
-            int gridY = (maxY == minY) ? gridHeight/2 : (int)((maxY - y) / (maxY - minY) * (gridHeight - 1));
-            
-            // Ensure within bounds
-            gridX = max(0, min(gridWidth - 1, gridX));
-            gridY = max(0, min(gridHeight - 1, gridY));
-            
-            nodePositions[pair.first] = {gridY, gridX};
+        for (NodeId u = 0; u < g.numNodes(); u++) {
+            int gridY = nodePositions[u].first;
+            int gridX = nodePositions[u].second;
             
             // Check if node is in path
-            bool inPath = find(path.begin(), path.end(), pair.first) != path.end();
-            if (inPath) {
+            if (inPath[u]) {
                 grid[gridY][gridX] = '*'; // Path nodes marked with *
             } else {
-                grid[gridY][gridX] = pair.first[0]; // Other nodes with first letter
+                grid[gridY][gridX] = g.nameData(u)[0]; // Other nodes with first letter
             }
         }
         
         // Draw path edges with special characters
-        for (size_t i = 0; i < path.size() - 1; i++) {
-            string from = path[i];
-            string to = path[i + 1];
+        for (size_t i = 0; i + 1 < pathIds.size(); i++) {
+            NodeId from = pathIds[i];
+            NodeId to = pathIds[i + 1];
             
-            if (nodePositions.find(from) == nodePositions.end() || 
-                nodePositions.find(to) == nodePositions.end()) continue;
+            if (from == INVALID_NODE || to == INVALID_NODE) continue;
             
             int y1 = nodePositions[from].first;
             int x1 = nodePositions[from].second;
@@ -389,56 +834,172 @@ public:
         }
         
         // Redraw path nodes
-        for (const string& nodeName : path) {
-            if (nodePositions.find(nodeName) != nodePositions.end()) {
-                int y = nodePositions[nodeName].first;
-                int x = nodePositions[nodeName].second;
-                grid[y][x] = '*';
+        for (NodeId id : pathIds) {
+            if (id != INVALID_NODE) {
+                grid[nodePositions[id].first][nodePositions[id].second] = '*';
             }
         }
         
-        // Print grid
-        cout << "   ";
+        printGrid(grid, gridWidth, gridHeight);
+        
+        // Path information
+        out << "\nPath Sequence: ";
+        for (size_t i = 0; i < path.size(); i++) {
+            out << path[i];
+            if (i < path.size() - 1) out << " -> ";
+        }
+        out << '\n';
+        
+        out << "\nLegend:\n";
+        out << "  Path Nodes: * (asterisk)\n";
+        out << "  Path Edges: # (hash)\n";
+        out << "  Other Nodes: First letter of node name\n";
+        out << "  Empty Space: . (dot)\n";
+        
+        out << "==========================\n";
+    }
+
+    // Visualize a grid map path in the same view; maps larger than the
+    // view are shrunk, a view cell showing blocked when all of its map
+    // cells are blocked
+    void visualizePath(const GridMap& map, const vector<NodeId>& jumpPoints, const vector<NodeId>& cells) {
+        if (cells.empty()) {
+            out << "No path to visualize!\n";
+            return;
+        }
+
+        out << "\n=== PATH VISUALIZATION ===\n";
+
+        const int gridWidth = (int)min<uint32_t>(map.width(), 64);
+        const int gridHeight = (int)min<uint32_t>(map.height(), 32);
+        ArenaScope scope(scratchArena());
+        AsciiGrid grid(scratchArena(), gridWidth, gridHeight, '@');
+        for (uint32_t y = 0; y < map.height(); y++) {
+            for (uint32_t x = 0; x < map.width(); x++) {
+                if (map.passable(x, y)) {
+                    grid[(uint64_t)y * gridHeight / map.height()][(uint64_t)x * gridWidth / map.width()] = '.';
+                }
+            }
+        }
+
+        for (NodeId cell : cells) {
+            grid[(uint64_t)map.cellY(cell) * gridHeight / map.height()]
+                [(uint64_t)map.cellX(cell) * gridWidth / map.width()] = '#';
+        }
+        for (NodeId cell : jumpPoints) {
+            grid[(uint64_t)map.cellY(cell) * gridHeight / map.height()]
+                [(uint64_t)map.cellX(cell) * gridWidth / map.width()] = '*';
+        }
+
+        printGrid(grid, gridWidth, gridHeight);
+
+        out << "\nLegend:\n";
+        out << "  Jump Points: * (asterisk)\n";
+        out << "  Path Cells: # (hash)\n";
+        out << "  Blocked: @ (at sign)\n";
+        out << "  Free Space: . (dot)\n";
+
+        out << "==========================\n";
+    }
+
+private:
+    // Keep the change log short. Routes more than MAX_ROUTE_LAG changes
+    // behind are dropped (their next query plans from scratch, which is
+    // cheaper than repairing that many changes), then the prefix every
+    // remaining route has repaired past is cut off.
+    void trimEdgeChanges() {
+        if (edgeChanges.size() > MAX_ROUTE_LAG) {
+            for (auto it = routes.begin(); it != routes.end();) {
+                if (edgeChanges.size() - it->second->appliedChanges > MAX_ROUTE_LAG) it = routes.erase(it);
+                else ++it;
+            }
+        }
+        size_t applied = edgeChanges.size();
+        for (const auto& route : routes) {
+            applied = min(applied, route.second->appliedChanges);
+        }
+        if (applied == 0) return;
+        edgeChanges.erase(edgeChanges.begin(), edgeChanges.begin() + applied);
+        for (auto& route : routes) {
+            route.second->appliedChanges -= applied;
+        }
+    }
+    
+    // Refill the builder from a graph loaded from file before editing it
+    void syncBuilder() {
+        if (builderStale) {
+            builder.assign(csr);
+            builderStale = false;
+        }
+    }
+    
+    // Character cells of an ASCII view, row by row in arena memory
+    struct AsciiGrid {
+        char* cells;
+        int width;
+
+        AsciiGrid(Arena& arena, int gridWidth, int gridHeight, char fill)
+            : cells(arena.allocateArray<char>((size_t)gridWidth * gridHeight)), width(gridWidth) {
+            fill_n(cells, (size_t)gridWidth * gridHeight, fill);
+        }
+
+        char* operator[](int row) const { return cells + (size_t)row * width; }
+    };
+
+    typedef ArenaVector<pair<int, int>>::type NodePositions;
+
+    // Scale node coordinates onto the ASCII grid, returns (row, column) per node id
+    NodePositions placeNodes(Arena& arena, const CsrGraph& g, int gridWidth, int gridHeight) {
+        NodePositions positions(g.numNodes(), pair<int, int>(), ArenaAllocator<pair<int, int>>(arena));
+        if (g.numNodes() == 0) return positions;
+        
+        // Bounds for scaling, kept by the spatial index
+        double minX = 0, minY = 0, maxX = 0, maxY = 0;
+        spatialIndex().bounds(minX, minY, maxX, maxY);
+        
+        for (NodeId u = 0; u < g.numNodes(); u++) {
+            double x = g.x(u);
+            double y = g.y(u);
+            
+            // Scale to grid
+            int gridX = (maxX == minX) ? gridWidth/2 : (int)((x - minX) / (maxX - minX) * (gridWidth - 1));
+            int gridY = (maxY == minY) ? gridHeight/2 : (int)((maxY - y) / (maxY - minY) * (gridHeight - 1));
+            
+            // Ensure within bounds
+            gridX = max(0, min(gridWidth - 1, gridX));
+            gridY = max(0, min(gridHeight - 1, gridY));
+            
+            positions[u] = {gridY, gridX};
+        }
+        return positions;
+    }
+    
+    // Print the grid with coordinate rulers
+    void printGrid(const AsciiGrid& grid, int gridWidth, int gridHeight) {
+        out << "   ";
         for (int x = 0; x < gridWidth; x++) {
-            if (x % 5 == 0) cout << (x / 10);
-            else cout << " ";
+            if (x % 5 == 0) out << (x / 10);
+            else out << " ";
         }
-        cout << endl;
+        out << '\n';
         
-        cout << "   ";
+        out << "   ";
         for (int x = 0; x < gridWidth; x++) {
-            cout << (x % 10);
+            out << (x % 10);
         }
-        cout << endl;
+        out << '\n';
         
         for (int y = 0; y < gridHeight; y++) {
-            cout << setfill(' ') << setw(2) << y << " ";
+            out.padded(y, 2) << " ";
             for (int x = 0; x < gridWidth; x++) {
-                cout << grid[y][x];
+                out << grid[y][x];
             }
-            cout << endl;
+            out << '\n';
         }
-        
-        // Path information
-        cout << "\nPath Sequence: ";
-        for (size_t i = 0; i < path.size(); i++) {
-            cout << path[i];
-            if (i < path.size() - 1) cout << " -> ";
-        }
-        cout << endl;
-        
-        cout << "\nLegend:" << endl;
-        cout << "  Path Nodes: * (asterisk)" << endl;
-        cout << "  Path Edges: # (hash)" << endl;
-        cout << "  Other Nodes: First letter of node name" << endl;
-        cout << "  Empty Space: . (dot)" << endl;
-        
-        cout << "==========================" << endl;
     }
-
-private:
+    
     // Helper function to draw line between two points
-    void drawLine(vector<vector<char>>& grid, int x1, int y1, int x2, int y2, int width, int height) {
+    void drawLine(const AsciiGrid& grid, int x1, int y1, int x2, int y2, int width, int height) {
         int dx = abs(x2 - x1);
         int dy = abs(y2 - y1);
         int sx = (x1 < x2) ? 1 : -1;
@@ -476,7 +1037,7 @@ private:
     }
     
     // Helper function to draw path line with special character
-    void drawPathLine(vector<vector<char>>& grid, int x1, int y1, int x2, int y2, int width, int height) {
+    void drawPathLine(const AsciiGrid& grid, int x1, int y1, int x2, int y2, int width, int height) {
         int dx = abs(x2 - x1);
         int dy = abs(y2 - y1);
         int sx = (x1 < x2) ? 1 : -1;
@@ -508,9 +1069,12 @@ private:
     }
 };
 
+const size_t Graph::MAX_ROUTE_LAG;
+
 // Function to create a sample graph with 6 nodes and various weights
 void createSampleGraph(Graph& graph) {
-    cout << "\nCreating sample graph with 6 nodes..." << endl;
+    OutputBuffer& out = graph.output();
+    out << "\nCreating sample graph with 6 nodes...\n";
     
     // Clear existing graph (add a method to clear if needed)
     // For now, we'll just add to existing graph
@@ -534,9 +1098,211 @@ void createSampleGraph(Graph& graph) {
     graph.addEdge("A", "C", 8.5);  // A->C (direct but expensive)
     graph.addEdge("D", "F", 7.8);  // D->F (long diagonal)
     
-    cout << "Sample graph created successfully!" << endl;
-    cout << "Nodes: A, B, C, D, E, F" << endl;
-    cout << "Try visualizing the graph or finding paths between nodes!" << endl;
+    out << "Sample graph created successfully!\n";
+    out << "Nodes: A, B, C, D, E, F\n";
+    out << "Try visualizing the graph or finding paths between nodes!\n";
+}
+
+// Query a grid map (Moving AI .map file) with JPS+ until the user exits
+int runGridMap(Graph& graph, const string& path) {
+    GridMap map;
+    string error;
+    if (!map.load(path, error)) {
+        cout << "Error: " << error << endl;
+        return 1;
+    }
+
+    JumpTable table;
+    table.build(map);
+    GridSearch search;
+    cout << "Loaded " << path << " (" << map.width() << "x" << map.height() << " grid)" << endl;
+
+    while (true) {
+        int sx, sy, gx, gy;
+        graph.output().flush();
+        cout << "\nEnter start x y (negative to exit): ";
+        if (!(cin >> sx >> sy) || sx < 0 || sy < 0) break;
+        cout << "Enter goal x y: ";
+        if (!(cin >> gx >> gy)) break;
+
+        OutputBuffer& out = graph.output();
+        if (!map.passable(sx, sy) || !map.passable(gx, gy)) {
+            out << "Start and goal must be free cells inside the map!\n";
+            continue;
+        }
+
+        NodeId start = map.cellId(sx, sy), goal = map.cellId(gx, gy);
+        double cost = search.search(map, start, goal, GRID_JPS_PLUS, &table);
+        if (cost == INFINITE_COST) {
+            out << "No path found from (" << sx << ", " << sy << ") to (" << gx << ", " << gy << ")\n";
+            continue;
+        }
+
+        vector<NodeId> jumpPoints = search.buildPath(goal);
+        const vector<NodeId>& cells = search.buildCellPath(map, goal);
+        out << "\n=== A* SEARCH RESULT ===\n";
+        out << "Total path cost: ";
+        out.fixed(cost, 2);
+        out << "\nNumber of cells in path: " << (unsigned long long)cells.size() << " ("
+            << (unsigned long long)jumpPoints.size() << " jump points, " << (unsigned long long)search.expandedCount()
+            << " expanded)\n";
+        graph.visualizePath(map, jumpPoints, cells);
+    }
+    return 0;
+}
+
+// Headless mode: load a graph once and answer protocol requests (see
+// query_server.h) until stdin ends or, with a socket, until SIGINT/SIGTERM
+//   graph_astar --serve <graph.agr> [--socket <path>] [--stdio] [--threads N]
+int runServer(int argc, char** argv) {
+#ifdef __linux__
+    string graphPath, socketPath, error;
+    bool stdio = false;
+    unsigned threads = 0;
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = (unsigned)atoi(argv[++i]);
+        } else if (arg == "--stdio") {
+            stdio = true;
+        } else if (graphPath.empty()) {
+            graphPath = arg;
+        } else {
+            cerr << "Unknown option " << arg << endl;
+            return 1;
+        }
+    }
+    CsrGraph g;
+    if (graphPath.empty() || !openGraphFile(graphPath, g, error)) {
+        cerr << "Error: " << (graphPath.empty() ? string("no graph file given") : error) << endl;
+        return 1;
+    }
+
+    // Logs go to stderr: stdout may carry answers
+    QueryServer server(g, threads);
+    if (!socketPath.empty() && !server.listenUnix(socketPath, error)) {
+        cerr << "Error: " << error << endl;
+        return 1;
+    }
+    if (stdio || socketPath.empty()) server.serveStdio();
+    cerr << "Serving " << graphPath << " (" << g.numNodes() << " nodes, " << g.numEdges() << " edges)"
+         << (socketPath.empty() ? "" : " on " + socketPath) << endl;
+    if (!server.run(error)) {
+        cerr << "Error: " << error << endl;
+        return 1;
+    }
+    QueryServerStats stats = server.stats();
+    cerr << stats.requests << " requests answered over " << stats.connections << " connections" << endl;
+    return 0;
+#else
+    (void)argc;
+    (void)argv;
+    cerr << "Error: server mode needs Linux (epoll)" << endl;
+    return 1;
+#endif
+}
+
+// Headless batch: answer every "<from> <to>" line of a query file (or
+// stdin) and write the results and a closing summary to stdout. Nodes are
+// names or "#<node id>". A line that is not exactly two known nodes is
+// reported on stderr and answered without a path.
+//   graph_astar --paths <graph.agr> [queries.txt] [--format text|ndjson|binary]
+int runPaths(int argc, char** argv) {
+    string graphPath, queryPath, formatName = "text", error;
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc) {
+            formatName = argv[++i];
+        } else if (graphPath.empty()) {
+            graphPath = arg;
+        } else if (queryPath.empty()) {
+            queryPath = arg;
+        } else {
+            cerr << "Unknown option " << arg << endl;
+            return 1;
+        }
+    }
+    ResultFormat format;
+    if (!parseResultFormat(formatName, format)) {
+        cerr << "Error: unknown format " << formatName << " (text, ndjson or binary)" << endl;
+        return 1;
+    }
+    CsrGraph loaded;
+    if (graphPath.empty() || !openGraphFile(graphPath, loaded, error)) {
+        cerr << "Error: " << (graphPath.empty() ? string("no graph file given") : error) << endl;
+        return 1;
+    }
+    ifstream file;
+    if (!queryPath.empty() && queryPath != "-") {
+        file.open(queryPath.c_str());
+        if (!file) {
+            cerr << "Error: cannot open " << queryPath << endl;
+            return 1;
+        }
+    }
+    istream& input = file.is_open() ? file : cin;
+
+    Graph graph;
+    graph.assign(loaded);
+    const CsrGraph& g = graph.frozen();
+    // Read and answer the queries a slice at a time, so results are written
+    // as they come and only the latencies of earlier slices are kept
+    const size_t slice = 1 << 16;
+    ResultWriter writer(graph.output(), format);
+    vector<PathQuery> batch;
+    vector<PathResult> results;
+    vector<PathResult> timings; // only the latencies, for the summary
+    double seconds = 0;
+    unsigned threads = 0;
+    string line, names[3];
+    size_t number = 0;
+    for (bool more = true; more;) {
+        batch.clear();
+        while (batch.size() < slice && (more = static_cast<bool>(getline(input, line)))) {
+            number++;
+            istringstream fields(line);
+            names[0].clear();
+            names[1].clear();
+            if (!(fields >> names[0])) continue;
+            NodeId ids[2] = {INVALID_NODE, INVALID_NODE};
+            if (!(fields >> names[1]) || fields >> names[2]) {
+                // Kept, and answered without a path, so ids follow the input
+                cerr << "Line " << number << ": expected <from> <to>" << endl;
+                batch.push_back(PathQuery{ids[0], ids[1]});
+                continue;
+            }
+            for (int k = 0; k < 2; k++) {
+                if (names[k].size() > 1 && names[k][0] == '#') {
+                    char* end = nullptr;
+                    unsigned long value = strtoul(names[k].c_str() + 1, &end, 10);
+                    ids[k] = *end == '\0' && value < g.numNodes() ? (NodeId)value : INVALID_NODE;
+                } else {
+                    ids[k] = g.findNode(names[k]);
+                }
+                if (ids[k] == INVALID_NODE) cerr << "Line " << number << ": unknown node " << names[k] << endl;
+            }
+            batch.push_back(PathQuery{ids[0], ids[1]});
+        }
+        if (batch.empty()) continue;
+
+        BatchReport report = graph.batchAStarIds(batch, results);
+        threads = report.threads;
+        seconds += report.seconds;
+        for (size_t i = 0; i < results.size(); i++) {
+            writer.writePath(g, timings.size(), batch[i].start, batch[i].goal, results[i].cost, results[i].path,
+                             results[i].costs);
+            PathResult timing;
+            timing.cost = results[i].cost;
+            timing.latencyMicros = results[i].latencyMicros;
+            timings.push_back(timing);
+        }
+    }
+    BatchReport total = BatchQueryEngine::summarize(timings, threads, seconds);
+    writer.writeStats(total);
+    graph.output().flush();
+    return 0;
 }
 
 // Function to display menu
@@ -553,14 +1319,36 @@ void displayMenu() {
     cout << "Choose an option: ";
 }
 
-int main() {
+// bench.cpp includes this file for the Graph class and brings its own main
+#ifndef GRAPH_ASTAR_NO_MAIN
+int main(int argc, char** argv) {
+    if (argc > 1 && string(argv[1]) == "--serve") {
+        return runServer(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--paths") {
+        return runPaths(argc, argv);
+    }
+    
     Graph graph;
     int choice;
     
     cout << "Welcome to Graph & A* Pathfinder!" << endl;
     cout << "This program allows you to create a graph and find shortest paths using A* algorithm." << endl;
     
+    // A Moving AI .map file switches to the grid map engine
+    string input = argc > 1 ? argv[1] : "";
+    if (input.size() > 4 && input.compare(input.size() - 4, 4, ".map") == 0) {
+        return runGridMap(graph, input);
+    }
+    
+    // Optional binary graph file written by graph_convert
+    if (argc > 1 && graph.loadGraphFile(argv[1])) {
+        cout << "Loaded " << argv[1] << " (" << graph.frozen().numNodes() << " nodes, "
+             << graph.frozen().numEdges() << " edges)" << endl;
+    }
+    
     while (true) {
+        graph.output().flush();
         displayMenu();
         cin >> choice;
         
@@ -685,3 +1473,4 @@ int main() {
     
     return 0;
 }
+#endif
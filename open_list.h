@@ -0,0 +1,292 @@
+#ifndef OPEN_LIST_H
+#define OPEN_LIST_H
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "csr_graph.h"
+
+// Open-list implementations for the A* engines.
+// All of them share the same small interface:
+//   reset(numNodes)   prepare for a new search
+//   push(u, key)      insert u, or lower its key if already queued
+//   pop()             remove and return a node with the smallest key
+//   topKey(), empty(), size(), allocationCount(), memoryBytes()
+// Lazy queues may hand back a node more than once; the search skips
+// pops for nodes that are no longer marked open.
+
+// Which open list a search should use
+enum OpenListKind {
+    OPEN_LIST_BINARY_HEAP,     // std heap with lazy deletion (duplicates on improve)
+    OPEN_LIST_QUATERNARY_HEAP, // indexed 4-ary heap with true decrease-key
+    OPEN_LIST_RADIX_HEAP       // monotone radix heap over quantized keys
+};
+
+inline const char* openListName(OpenListKind kind) {
+    switch (kind) {
+        case OPEN_LIST_BINARY_HEAP: return "binary";
+        case OPEN_LIST_QUATERNARY_HEAP: return "4-ary";
+        case OPEN_LIST_RADIX_HEAP: return "radix";
+    }
+    return "unknown";
+}
+
+// Binary heap with lazy deletion, the behaviour of std::priority_queue
+class LazyBinaryHeap {
+public:
+    LazyBinaryHeap() : allocations(0) {}
+
+    void reset(NodeId) { entries.clear(); }
+    bool empty() const { return entries.empty(); }
+    size_t size() const { return entries.size(); }
+    double topKey() const { return entries.front().first; }
+
+    void push(NodeId u, double key) {
+        if (entries.size() == entries.capacity()) allocations++;
+        entries.push_back(std::make_pair(key, u));
+        std::push_heap(entries.begin(), entries.end(), std::greater<Entry>());
+    }
+
+    NodeId pop() {
+        std::pop_heap(entries.begin(), entries.end(), std::greater<Entry>());
+        NodeId u = entries.back().second;
+        entries.pop_back();
+        return u;
+    }
+
+    uint64_t allocationCount() const { return allocations; }
+    size_t memoryBytes() const { return entries.capacity() * sizeof(Entry); }
+
+private:
+    typedef std::pair<double, NodeId> Entry;
+    std::vector<Entry> entries;
+    uint64_t allocations;
+};
+
+// Indexed D-ary min-heap. Every node is in the heap at most once and
+// push() on a queued node performs a decrease-key in place. A wider
+// fan-out keeps the heap shallow and the children of a slot contiguous.
+// Key is any type ordered by operator<, e.g. the two-part keys of LPA*.
+template <unsigned D, class Key = double>
+class IndexedDaryHeap {
+public:
+    IndexedDaryHeap() : allocations(0) {}
+
+    // Only the slots still in the heap need clearing, not all V nodes
+    void reset(NodeId numNodes) {
+        for (size_t i = 0; i < entries.size(); i++) {
+            position[entries[i].node] = NOT_IN_HEAP;
+        }
+        entries.clear();
+        if (position.size() < numNodes) {
+            position.resize(numNodes, NOT_IN_HEAP);
+            allocations++;
+        }
+    }
+
+    bool empty() const { return entries.empty(); }
+    size_t size() const { return entries.size(); }
+    Key topKey() const { return entries[0].key; }
+    bool contains(NodeId u) const { return position[u] != NOT_IN_HEAP; }
+
+    void push(NodeId u, Key key) {
+        uint32_t slot = position[u];
+        if (slot == NOT_IN_HEAP) {
+            if (entries.size() == entries.capacity()) allocations++;
+            Entry entry;
+            entry.key = key;
+            entry.node = u;
+            entries.push_back(entry);
+            siftUp((uint32_t)entries.size() - 1);
+        } else if (key < entries[slot].key) {
+            entries[slot].key = key;
+            siftUp(slot);
+        }
+    }
+
+    NodeId pop() {
+        NodeId u = entries[0].node;
+        position[u] = NOT_IN_HEAP;
+        Entry last = entries.back();
+        entries.pop_back();
+        if (!entries.empty()) {
+            entries[0] = last;
+            position[last.node] = 0;
+            siftDown(0);
+        }
+        return u;
+    }
+
+    // Take u out of the heap wherever it is; no-op if it is not queued
+    void erase(NodeId u) {
+        uint32_t slot = position[u];
+        if (slot == NOT_IN_HEAP) return;
+        position[u] = NOT_IN_HEAP;
+        Entry last = entries.back();
+        entries.pop_back();
+        if (slot < entries.size()) {
+            entries[slot] = last;
+            position[last.node] = slot;
+            siftUp(slot);
+            siftDown(position[last.node]);
+        }
+    }
+
+    uint64_t allocationCount() const { return allocations; }
+    size_t memoryBytes() const {
+        return entries.capacity() * sizeof(Entry) + position.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    static const uint32_t NOT_IN_HEAP = 0xFFFFFFFFu;
+
+    struct Entry {
+        Key key;
+        NodeId node;
+    };
+
+    void siftUp(uint32_t slot) {
+        Entry moving = entries[slot];
+        while (slot > 0) {
+            uint32_t up = (slot - 1) / D;
+            if (!(moving.key < entries[up].key)) break;
+            entries[slot] = entries[up];
+            position[entries[slot].node] = slot;
+            slot = up;
+        }
+        entries[slot] = moving;
+        position[moving.node] = slot;
+    }
+
+    void siftDown(uint32_t slot) {
+        Entry moving = entries[slot];
+        uint32_t count = (uint32_t)entries.size();
+        while (true) {
+            uint32_t first = slot * D + 1;
+            if (first >= count) break;
+            uint32_t last = std::min(first + D, count);
+            uint32_t best = first;
+            for (uint32_t c = first + 1; c < last; c++) {
+                if (entries[c].key < entries[best].key) best = c;
+            }
+            if (!(entries[best].key < moving.key)) break;
+            entries[slot] = entries[best];
+            position[entries[slot].node] = slot;
+            slot = best;
+        }
+        entries[slot] = moving;
+        position[moving.node] = slot;
+    }
+
+    std::vector<Entry> entries;
+    std::vector<uint32_t> position; // heap slot per node, NOT_IN_HEAP if absent
+    uint64_t allocations;
+};
+
+template <unsigned D, class Key>
+const uint32_t IndexedDaryHeap<D, Key>::NOT_IN_HEAP;
+
+// Radix heap over non-negative integer keys (keys are f-scores multiplied
+// by the quantization scale). Requires monotone keys, which holds for A*
+// with a consistent heuristic; a key below the last popped key is clamped
+// up to it. Entries are lazy, so improved nodes appear more than once.
+class RadixHeap {
+public:
+    explicit RadixHeap(double scale = 1000.0) : quantization(scale), lastKey(0), count(0), allocations(0) {}
+
+    // Keys are multiplied by scale and rounded; use 1 for integer weights
+    void setQuantization(double scale) { quantization = scale; }
+    double getQuantization() const { return quantization; }
+
+    void reset(NodeId) {
+        for (int b = 0; b < BUCKETS; b++) buckets[b].clear();
+        lastKey = 0;
+        count = 0;
+    }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    double topKey() const {
+        uint64_t best = UINT64_MAX;
+        for (int b = 0; b < BUCKETS; b++) {
+            for (size_t i = 0; i < buckets[b].size(); i++) {
+                best = std::min(best, buckets[b][i].first);
+            }
+            if (best != UINT64_MAX) break;
+        }
+        return best / quantization;
+    }
+
+    void push(NodeId u, double key) {
+        double scaled = key * quantization + 0.5;
+        uint64_t k = scaled <= 0 ? 0 : scaled >= 1.8e19 ? UINT64_MAX - 1 : (uint64_t)scaled;
+        if (k < lastKey) k = lastKey;
+        insert(k, u);
+        count++;
+    }
+
+    NodeId pop() {
+        if (buckets[0].empty()) {
+            // Find the first non-empty bucket and redistribute it around its minimum
+            int b = 1;
+            while (buckets[b].empty()) b++;
+            uint64_t newLast = buckets[b][0].first;
+            for (size_t i = 1; i < buckets[b].size(); i++) {
+                newLast = std::min(newLast, buckets[b][i].first);
+            }
+            lastKey = newLast;
+            for (size_t i = 0; i < buckets[b].size(); i++) {
+                insert(buckets[b][i].first, buckets[b][i].second);
+            }
+            buckets[b].clear();
+        }
+        NodeId u = buckets[0].back().second;
+        buckets[0].pop_back();
+        count--;
+        return u;
+    }
+
+    uint64_t allocationCount() const { return allocations; }
+    size_t memoryBytes() const {
+        size_t bytes = 0;
+        for (int b = 0; b < BUCKETS; b++) bytes += buckets[b].capacity() * sizeof(buckets[b][0]);
+        return bytes;
+    }
+
+private:
+    static const int BUCKETS = 65;
+
+    // Bucket index is the position of the highest bit where key and last differ
+    static int bucketFor(uint64_t key, uint64_t last) {
+        uint64_t diff = key ^ last;
+        if (diff == 0) return 0;
+#if defined(__GNUC__) || defined(__clang__)
+        return 64 - __builtin_clzll(diff);
+#else
+        int bit = 0;
+        while (diff != 0) {
+            diff >>= 1;
+            bit++;
+        }
+        return bit;
+#endif
+    }
+
+    void insert(uint64_t key, NodeId u) {
+        std::vector<std::pair<uint64_t, NodeId> >& bucket = buckets[bucketFor(key, lastKey)];
+        if (bucket.size() == bucket.capacity()) allocations++;
+        bucket.push_back(std::make_pair(key, u));
+    }
+
+    std::vector<std::pair<uint64_t, NodeId> > buckets[BUCKETS];
+    double quantization;
+    uint64_t lastKey;
+    size_t count;
+    uint64_t allocations;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of workers to use when the caller passes 0
+inline unsigned defaultThreadCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Run f(i, worker) for every i in [0, count) on up to threads workers
+// (0 = all cores). Indices are handed out grain at a time from a shared
+// counter, so uneven work balances itself. worker is in [0, threads) and
+// can index per-thread scratch space. Runs inline when one worker suffices.
+template <class Function>
+void parallelFor(size_t count, unsigned threads, Function f, size_t grain = 1) {
+    if (threads == 0) threads = defaultThreadCount();
+    grain = std::max<size_t>(grain, 1);
+    unsigned used = (unsigned)std::min<size_t>(threads, (count + grain - 1) / grain);
+    if (used <= 1) {
+        for (size_t i = 0; i < count; i++) f(i, 0u);
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (unsigned w = 0; w < used; w++) {
+        workers.push_back(std::thread([&next, &f, count, grain, w] {
+            for (size_t begin = next.fetch_add(grain); begin < count; begin = next.fetch_add(grain)) {
+                size_t end = std::min(count, begin + grain);
+                for (size_t i = begin; i < end; i++) f(i, w);
+            }
+        }));
+    }
+    for (size_t w = 0; w < workers.size(); w++) workers[w].join();
+}
+
+// Reusable barrier for a fixed number of threads working in lock-step
+// phases. The last thread to arrive runs the completion function before
+// any of them is released, which is the place for decisions every thread
+// must agree on.
+class PhaseBarrier {
+public:
+    explicit PhaseBarrier(unsigned threads) : count(threads), waiting(0), generation(0) {}
+
+    template <class Completion>
+    void wait(Completion onLast) {
+        std::unique_lock<std::mutex> lock(mutex);
+        size_t arrived = generation;
+        if (++waiting == count) {
+            onLast();
+            waiting = 0;
+            generation++;
+            released.notify_all();
+            return;
+        }
+        released.wait(lock, [this, arrived] { return generation != arrived; });
+    }
+
+    void wait() {
+        wait([] {});
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable released;
+    unsigned count, waiting;
+    size_t generation;
+};
+
+// Sort [first, last) with up to threads workers: equal slices are sorted
+// in parallel, then merged pairwise, each round of merges in parallel
+template <class Iterator, class Compare>
+void parallelSort(Iterator first, Iterator last, Compare less, unsigned threads = 0) {
+    if (threads == 0) threads = defaultThreadCount();
+    size_t count = (size_t)(last - first);
+    size_t pieces = std::min<size_t>(threads, count / 4096 + 1);
+    if (pieces <= 1) {
+        std::sort(first, last, less);
+        return;
+    }
+
+    std::vector<size_t> bounds(pieces + 1);
+    for (size_t p = 0; p <= pieces; p++) bounds[p] = count * p / pieces;
+    parallelFor(pieces, threads, [&](size_t p, unsigned) {
+        std::sort(first + bounds[p], first + bounds[p + 1], less);
+    });
+    for (size_t width = 1; width < pieces; width *= 2) {
+        size_t merges = (pieces + 2 * width - 1) / (2 * width);
+        parallelFor(merges, threads, [&](size_t m, unsigned) {
+            size_t lo = 2 * width * m, mid = std::min(lo + width, pieces), hi = std::min(lo + 2 * width, pieces);
+            if (mid < hi) std::inplace_merge(first + bounds[lo], first + bounds[mid], first + bounds[hi], less);
+        });
+    }
+}
+
+#endif
@@ -0,0 +1,275 @@
+#ifndef PATH_CACHE_H
+#define PATH_CACHE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "csr_graph.h"
+
+// Counters of a PathCache, summed over its shards
+struct PathCacheStats {
+    uint64_t hits, misses, insertions, evictions, invalidations;
+    uint64_t entries, bytes, budgetBytes;
+
+    PathCacheStats() : hits(0), misses(0), insertions(0), evictions(0), invalidations(0),
+                       entries(0), bytes(0), budgetBytes(0) {}
+
+    double hitRatio() const { return hits + misses == 0 ? 0 : (double)hits / (hits + misses); }
+
+    std::string toJson() const {
+        std::ostringstream out;
+        out << "{\"hits\": " << hits << ", \"misses\": " << misses << ", \"hit_ratio\": " << hitRatio()
+            << ", \"insertions\": " << insertions << ", \"evictions\": " << evictions
+            << ", \"invalidations\": " << invalidations << ", \"entries\": " << entries << ", \"bytes\": " << bytes
+            << ", \"budget_bytes\": " << budgetBytes << "}";
+        return out.str();
+    }
+
+    std::string toPrometheus(const std::string& prefix = "astar_path_cache") const {
+        std::ostringstream out;
+        out << "# TYPE " << prefix << "_hits_total counter\n" << prefix << "_hits_total " << hits << "\n"
+            << "# TYPE " << prefix << "_misses_total counter\n" << prefix << "_misses_total " << misses << "\n"
+            << "# TYPE " << prefix << "_evictions_total counter\n" << prefix << "_evictions_total " << evictions << "\n"
+            << "# TYPE " << prefix << "_invalidations_total counter\n" << prefix << "_invalidations_total "
+            << invalidations << "\n"
+            << "# TYPE " << prefix << "_entries gauge\n" << prefix << "_entries " << entries << "\n"
+            << "# TYPE " << prefix << "_bytes gauge\n" << prefix << "_bytes " << bytes << "\n"
+            << "# TYPE " << prefix << "_budget_bytes gauge\n" << prefix << "_budget_bytes " << budgetBytes << "\n";
+        return out.str();
+    }
+};
+
+// Cost of reaching each node of a path the cache returned, which keeps
+// only the nodes: hops are charged their cheapest parallel edge, as a
+// search would have
+inline void cachedPathCosts(const CsrGraph& g, const std::vector<NodeId>& path, std::vector<double>& costs) {
+    costs.clear();
+    double total = 0;
+    for (size_t i = 0; i < path.size(); i++) {
+        if (i > 0) {
+            EdgeId e = g.findEdge(path[i - 1], path[i]);
+            total += e < g.numEdges() ? g.weight(e) : INFINITE_COST;
+        }
+        costs.push_back(total);
+    }
+}
+
+// Concurrent cache of path results keyed by (start, goal).
+//
+// Entries hold the node-id path and its cost, stamped with the graph
+// version they were computed on; a lookup with another version misses
+// and drops the entry, so bumping the version invalidates everything
+// lazily. invalidateEdge() instead drops just the entries whose path
+// uses that edge, which is enough when a weight goes up or an edge is
+// removed (a weight going down can make any path stale).
+//
+// Keys are spread over independently locked shards. Each shard evicts
+// with the CLOCK algorithm (second chance on a reference bit) until its
+// share of the byte budget holds.
+class PathCache {
+public:
+    explicit PathCache(size_t budgetBytes = 64 << 20, unsigned shardCount = 16) : budget(budgetBytes) {
+        shardCount = std::max(1u, shardCount);
+        for (unsigned i = 0; i < shardCount; i++) {
+            shards.push_back(std::unique_ptr<Shard>(new Shard()));
+            shards.back()->budget = budgetBytes / shardCount;
+        }
+    }
+
+    // On a hit copies the path and cost out and returns true
+    bool lookup(NodeId start, NodeId goal, uint64_t version, std::vector<NodeId>& path, double& cost) {
+        uint64_t key = pairKey(start, goal);
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        std::unordered_map<uint64_t, uint32_t>::iterator it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            shard.stats.misses++;
+            return false;
+        }
+        Entry& entry = shard.slots[it->second];
+        if (entry.version != version) {
+            shard.remove(it->second);
+            shard.stats.invalidations++;
+            shard.stats.misses++;
+            return false;
+        }
+        entry.referenced = true;
+        path.assign(entry.path.begin(), entry.path.end());
+        cost = entry.cost;
+        shard.stats.hits++;
+        return true;
+    }
+
+    // Store a result; an empty path records that goal is unreachable
+    void insert(NodeId start, NodeId goal, uint64_t version, double cost, const std::vector<NodeId>& path) {
+        uint64_t key = pairKey(start, goal);
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        std::unordered_map<uint64_t, uint32_t>::iterator it = shard.index.find(key);
+        if (it != shard.index.end()) shard.remove(it->second);
+
+        size_t bytes = entryBytes(path.size());
+        if (bytes > shard.budget) return; // would never fit
+        while (shard.bytes + bytes > shard.budget && shard.evictOne()) shard.stats.evictions++;
+
+        uint32_t slot = shard.allocate();
+        Entry& entry = shard.slots[slot];
+        entry.key = key;
+        entry.version = version;
+        entry.cost = cost;
+        entry.path.assign(path.begin(), path.end());
+        entry.referenced = false;
+        entry.used = true;
+        entry.bytes = bytes;
+        shard.index[key] = slot;
+        for (size_t i = 0; i + 1 < path.size(); i++) {
+            shard.byEdge[pairKey(path[i], path[i + 1])].push_back(slot);
+        }
+        shard.bytes += bytes;
+        shard.stats.insertions++;
+    }
+
+    // Drop every entry whose path goes from -> to
+    void invalidateEdge(NodeId from, NodeId to) {
+        uint64_t edge = pairKey(from, to);
+        for (size_t s = 0; s < shards.size(); s++) {
+            Shard& shard = *shards[s];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            std::unordered_map<uint64_t, std::vector<uint32_t> >::iterator it = shard.byEdge.find(edge);
+            if (it == shard.byEdge.end()) continue;
+            std::vector<uint32_t> slots;
+            slots.swap(it->second);
+            for (size_t i = 0; i < slots.size(); i++) {
+                if (shard.slots[slots[i]].used) {
+                    shard.remove(slots[i]);
+                    shard.stats.invalidations++;
+                }
+            }
+        }
+    }
+
+    void clear() {
+        for (size_t s = 0; s < shards.size(); s++) {
+            Shard& shard = *shards[s];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.stats.invalidations += shard.index.size();
+            shard.index.clear();
+            shard.byEdge.clear();
+            shard.slots.clear();
+            shard.freeSlots.clear();
+            shard.hand = 0;
+            shard.bytes = 0;
+        }
+    }
+
+    PathCacheStats stats() const {
+        PathCacheStats total;
+        for (size_t s = 0; s < shards.size(); s++) {
+            Shard& shard = *shards[s];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            total.hits += shard.stats.hits;
+            total.misses += shard.stats.misses;
+            total.insertions += shard.stats.insertions;
+            total.evictions += shard.stats.evictions;
+            total.invalidations += shard.stats.invalidations;
+            total.entries += shard.index.size();
+            total.bytes += shard.bytes;
+        }
+        total.budgetBytes = budget;
+        return total;
+    }
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint64_t version;
+        double cost;
+        std::vector<NodeId> path;
+        size_t bytes;
+        bool referenced; // CLOCK second-chance bit
+        bool used;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, uint32_t> index; // (start, goal) -> slot
+        std::unordered_map<uint64_t, std::vector<uint32_t> > byEdge; // (from, to) -> slots of paths using it
+        std::vector<Entry> slots;
+        std::vector<uint32_t> freeSlots;
+        size_t hand = 0;
+        size_t bytes = 0;
+        size_t budget = 0;
+        PathCacheStats stats;
+
+        uint32_t allocate() {
+            if (!freeSlots.empty()) {
+                uint32_t slot = freeSlots.back();
+                freeSlots.pop_back();
+                return slot;
+            }
+            slots.push_back(Entry());
+            return (uint32_t)slots.size() - 1;
+        }
+
+        void remove(uint32_t slot) {
+            Entry& entry = slots[slot];
+            index.erase(entry.key);
+            for (size_t i = 0; i + 1 < entry.path.size(); i++) {
+                std::unordered_map<uint64_t, std::vector<uint32_t> >::iterator it =
+                    byEdge.find(pairKey(entry.path[i], entry.path[i + 1]));
+                if (it == byEdge.end()) continue;
+                std::vector<uint32_t>& list = it->second;
+                std::vector<uint32_t>::iterator pos = std::find(list.begin(), list.end(), slot);
+                if (pos != list.end()) {
+                    *pos = list.back();
+                    list.pop_back();
+                }
+                if (list.empty()) byEdge.erase(it);
+            }
+            bytes -= entry.bytes;
+            entry.used = false;
+            std::vector<NodeId>().swap(entry.path);
+            freeSlots.push_back(slot);
+        }
+
+        // Advance the clock hand to an entry without a second chance
+        bool evictOne() {
+            if (index.empty()) return false;
+            for (;;) {
+                if (hand >= slots.size()) hand = 0;
+                Entry& entry = slots[hand];
+                if (entry.used) {
+                    if (!entry.referenced) {
+                        remove((uint32_t)hand++);
+                        return true;
+                    }
+                    entry.referenced = false;
+                }
+                hand++;
+            }
+        }
+    };
+
+    static uint64_t pairKey(NodeId a, NodeId b) { return (uint64_t)a << 32 | b; }
+
+    // Entry, its path, its index slot and one edge-index reference per edge
+    static size_t entryBytes(size_t pathLength) {
+        return sizeof(Entry) + 32 + pathLength * (sizeof(NodeId) + 48);
+    }
+
+    Shard& shardFor(uint64_t key) {
+        uint64_t h = key * 0x9E3779B97F4A7C15ULL;
+        return *shards[(h >> 32) % shards.size()];
+    }
+
+    size_t budget;
+    std::vector<std::unique_ptr<Shard> > shards;
+};
+
+#endif
@@ -0,0 +1,735 @@
+#ifndef QUERY_SERVER_H
+#define QUERY_SERVER_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "csr_graph.h"
+#include "search_context.h"
+#include "astar_search.h"
+#include "isochrone.h"
+#include "spatial_index.h"
+#include "parallel.h"
+
+// Wire protocol of the query server. A client may mix both forms on one
+// connection; a message starting with QUERY_FRAME_MAGIC is a binary
+// frame, anything else a text line. Answers come back as soon as they
+// are ready, not in request order, tagged with the request's id.
+//
+// Text: one request per line, "<id> <op> <args>", where id is any token
+// and nodes are names or "#<node id>":
+//   <id> path <from> <to>        -> <id> ok <cost> <count> <node>...
+//   <id> cost <from> <to>        -> <id> ok <cost>
+//   <id> reach <from> <budget>   -> <id> ok <count> <node>:<cost>...
+//   <id> nearest <x> <y>         -> <id> ok <node>
+//   <id> info                    -> <id> ok <nodes> <edges>
+// or "<id> none" when there is no path, "<id> error <message>" on bad
+// input.
+//
+// Binary: fixed 24-byte QueryFrame requests with node ids, answered by a
+// 24-byte ResponseFrame followed by count node ids (path, reach) and,
+// for reach, count costs. Fields are in host byte order.
+const uint8_t QUERY_FRAME_MAGIC = 0xA5;
+
+enum QueryOp : uint8_t {
+    QUERY_PATH = 1,
+    QUERY_COST = 2,
+    QUERY_REACH = 3,   // from a, budget arg
+    QUERY_NEAREST = 4, // not available in frames (needs two coordinates)
+    QUERY_INFO = 5     // count = nodes, value = edges
+};
+
+enum QueryStatus : uint8_t {
+    QUERY_OK = 0,
+    QUERY_NO_PATH = 1,
+    QUERY_ERROR = 2
+};
+
+struct QueryFrame {
+    uint8_t magic;
+    uint8_t op;
+    uint16_t reserved;
+    uint32_t id;
+    uint32_t a, b; // node ids
+    double arg;
+};
+
+struct ResponseFrame {
+    uint8_t magic;
+    uint8_t status;
+    uint16_t reserved;
+    uint32_t id;
+    uint32_t count;
+    uint32_t reserved2;
+    double value; // cost
+};
+
+static_assert(sizeof(QueryFrame) == 24 && sizeof(ResponseFrame) == 24, "frames are 24 bytes");
+
+// Answers protocol messages against a read-only graph. Holds the search
+// state of one worker, so each thread needs its own.
+class QueryResponder {
+public:
+    QueryResponder(const CsrGraph& graph, const SpatialIndex& spatial) : g(graph), index(spatial) {}
+
+    // Answer one text line (without its newline), appending the reply line
+    void answerLine(const char* line, size_t length, std::string& out) {
+        tokens.clear();
+        size_t i = 0;
+        while (i < length) {
+            while (i < length && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r')) i++;
+            size_t begin = i;
+            while (i < length && line[i] != ' ' && line[i] != '\t' && line[i] != '\r') i++;
+            if (i > begin) tokens.push_back(std::string(line + begin, i - begin));
+        }
+        if (tokens.empty()) return;
+        out += tokens[0];
+        if (tokens.size() < 2) {
+            out += " error missing operation\n";
+            return;
+        }
+
+        const std::string& op = tokens[1];
+        if (op == "info") {
+            appendFormat(out, " ok %u %u\n", g.numNodes(), g.numEdges());
+        } else if (op == "nearest") {
+            double x, y;
+            if (tokens.size() != 4 || !parseNumber(tokens[2], x) || !parseNumber(tokens[3], y)) {
+                out += " error usage: nearest <x> <y>\n";
+            } else if (g.numNodes() == 0) {
+                out += " none\n";
+            } else {
+                out += " ok ";
+                appendName(out, index.nearest(x, y));
+                out += '\n';
+            }
+        } else if (op == "path" || op == "cost") {
+            NodeId from, to;
+            if (tokens.size() != 4) {
+                out += " error usage: " + op + " <from> <to>\n";
+            } else if (!resolve(tokens[2], from) || !resolve(tokens[3], to)) {
+                out += " error unknown node\n";
+            } else {
+                double cost = astarSearch(g, ctx, from, to);
+                if (cost == INFINITE_COST) {
+                    out += " none\n";
+                } else if (op == "cost") {
+                    appendFormat(out, " ok %.10g\n", cost);
+                } else {
+                    const std::vector<NodeId>& path = ctx.buildPath(to);
+                    appendFormat(out, " ok %.10g %zu", cost, path.size());
+                    for (size_t p = 0; p < path.size(); p++) {
+                        out += ' ';
+                        appendName(out, path[p]);
+                    }
+                    out += '\n';
+                }
+            }
+        } else if (op == "reach") {
+            NodeId from;
+            double budget;
+            if (tokens.size() != 4 || !parseNumber(tokens[3], budget)) {
+                out += " error usage: reach <from> <budget>\n";
+            } else if (!resolve(tokens[2], from)) {
+                out += " error unknown node\n";
+            } else {
+                isochrones.reachable(g, from, budget, reached);
+                appendFormat(out, " ok %zu", reached.size());
+                for (size_t r = 0; r < reached.size(); r++) {
+                    out += ' ';
+                    appendName(out, reached.nodes[r]);
+                    appendFormat(out, ":%.10g", reached.costs[r]);
+                }
+                out += '\n';
+            }
+        } else {
+            out += " error unknown operation " + op + "\n";
+        }
+    }
+
+    // Answer one binary frame, appending the reply frame
+    void answerFrame(const QueryFrame& frame, std::string& out) {
+        ResponseFrame reply;
+        std::memset(&reply, 0, sizeof(reply));
+        reply.magic = QUERY_FRAME_MAGIC;
+        reply.id = frame.id;
+        reply.status = QUERY_OK;
+        const NodeId* ids = nullptr;
+        const double* costs = nullptr;
+
+        bool fromValid = frame.a < g.numNodes(), toValid = frame.b < g.numNodes();
+        if (frame.op == QUERY_INFO) {
+            reply.count = g.numNodes();
+            reply.value = g.numEdges();
+        } else if ((frame.op == QUERY_PATH || frame.op == QUERY_COST) && fromValid && toValid) {
+            reply.value = astarSearch(g, ctx, frame.a, frame.b);
+            if (reply.value == INFINITE_COST) {
+                reply.status = QUERY_NO_PATH;
+            } else if (frame.op == QUERY_PATH) {
+                const std::vector<NodeId>& path = ctx.buildPath(frame.b);
+                reply.count = (uint32_t)path.size();
+                ids = path.data();
+            }
+        } else if (frame.op == QUERY_REACH && fromValid) {
+            isochrones.reachable(g, frame.a, frame.arg, reached);
+            reply.count = (uint32_t)reached.size();
+            ids = reached.nodes.data();
+            costs = reached.costs.data();
+        } else {
+            reply.status = QUERY_ERROR;
+        }
+
+        out.append((const char*)&reply, sizeof(reply));
+        if (ids) out.append((const char*)ids, reply.count * sizeof(NodeId));
+        if (costs) out.append((const char*)costs, reply.count * sizeof(double));
+    }
+
+private:
+    // "#<id>" or a node name
+    bool resolve(const std::string& token, NodeId& id) const {
+        if (token.size() > 1 && token[0] == '#') {
+            char* end = nullptr;
+            unsigned long value = std::strtoul(token.c_str() + 1, &end, 10);
+            id = (NodeId)value;
+            return *end == '\0' && value < g.numNodes();
+        }
+        id = g.findNode(token);
+        return id != INVALID_NODE;
+    }
+
+    static bool parseNumber(const std::string& token, double& value) {
+        char* end = nullptr;
+        value = std::strtod(token.c_str(), &end);
+        return end != token.c_str() && *end == '\0';
+    }
+
+    void appendName(std::string& out, NodeId u) const { out.append(g.nameData(u), g.nameLength(u)); }
+
+    template <class... Args>
+    static void appendFormat(std::string& out, const char* format, Args... args) {
+        char buffer[64];
+        int written = std::snprintf(buffer, sizeof(buffer), format, args...);
+        out.append(buffer, (size_t)std::max(0, std::min(written, (int)sizeof(buffer) - 1)));
+    }
+
+    const CsrGraph& g;
+    const SpatialIndex& index;
+    SearchContext ctx;
+    IsochroneEngine isochrones;
+    Isochrone reached;
+    std::vector<std::string> tokens;
+};
+
+// Counters of a server run
+struct QueryServerStats {
+    uint64_t connections;
+    uint64_t requests;
+    uint64_t responses;
+};
+
+#ifdef __linux__
+
+// Headless query server. One event-loop thread multiplexes a listening
+// Unix socket, its clients and optionally stdin/stdout with epoll; it
+// only splits input into messages and writes answers. A pool of workers,
+// each with its own QueryResponder, answers the messages. Finished
+// answers are handed back through a queue and an eventfd, so a slow
+// query never holds up the others on the same connection.
+//
+// A connection is not read from while it has MAX_IN_FLIGHT unanswered
+// requests or more than MAX_PENDING_OUTPUT bytes of answers it has not
+// taken yet, and reading resumes once both drain. A text line longer
+// than MAX_LINE_BYTES is answered "<id> error line too long" and ends
+// the connection's input. Together they bound the memory a client that
+// sends fast and reads slowly can tie up.
+class QueryServer {
+public:
+    static const size_t MAX_IN_FLIGHT = 4096;
+    static const size_t MAX_PENDING_OUTPUT = 1 << 20;
+    static const size_t MAX_LINE_BYTES = 64 << 10;
+
+    // threads == 0 uses one worker per hardware thread
+    explicit QueryServer(const CsrGraph& graph, unsigned threads = 0)
+        : g(graph), epollFd(-1), wakeFd(-1), listenFd(-1), nextConnection(FIRST_CONNECTION), stopping(false),
+          stopFlag(false), stdinOpen(false), stdinPollable(true), stdoutWatched(false), stdinFlags(-1) {
+        std::memset(&counters, 0, sizeof(counters));
+        index.build(g, threads);
+        if (threads == 0) threads = defaultThreadCount();
+        for (unsigned w = 0; w < threads; w++) workers.push_back(std::thread([this] { workerLoop(); }));
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        watch(wakeFd, WAKE, EPOLLIN, EPOLL_CTL_ADD);
+    }
+
+    ~QueryServer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        jobReady.notify_all();
+        for (size_t w = 0; w < workers.size(); w++) workers[w].join();
+        for (std::unordered_map<uint64_t, Connection>::iterator it = connections.begin(); it != connections.end();
+             ++it) {
+            if (it->second.fd > STDOUT_FILENO) close(it->second.fd);
+        }
+        if (listenFd >= 0) {
+            close(listenFd);
+            unlink(socketPath.c_str());
+        }
+        close(wakeFd);
+        close(epollFd);
+        if (stdinFlags >= 0) fcntl(STDIN_FILENO, F_SETFL, stdinFlags);
+    }
+
+    // Accept clients on a Unix socket at path (a stale socket file is replaced)
+    bool listenUnix(const std::string& path, std::string& error) {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            error = "socket path too long: " + path;
+            return false;
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size());
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        unlink(path.c_str());
+        if (listenFd < 0 || bind(listenFd, (sockaddr*)&address, sizeof(address)) != 0 || listen(listenFd, 128) != 0) {
+            error = "cannot listen on " + path + ": " + std::strerror(errno);
+            return false;
+        }
+        socketPath = path;
+        watch(listenFd, LISTENER, EPOLLIN, EPOLL_CTL_ADD);
+        return true;
+    }
+
+    // Also take requests from stdin and answer on stdout. Pipes are
+    // polled; a regular file is read whenever the loop is otherwise idle.
+    // A terminal is left blocking, since O_NONBLOCK would also reach the
+    // shell and stdout through the open file they share; other inputs get
+    // their flags back when the server is destroyed. When stdout would
+    // block anyway, it is polled until it takes more.
+    void serveStdio() {
+        Connection& c = connections[STDIO];
+        c.fd = STDIN_FILENO;
+        c.outFd = STDOUT_FILENO;
+        stdinOpen = true;
+        if (!isatty(STDIN_FILENO)) {
+            stdinFlags = fcntl(STDIN_FILENO, F_GETFL);
+            if (stdinFlags >= 0) fcntl(STDIN_FILENO, F_SETFL, stdinFlags | O_NONBLOCK);
+        }
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = STDIO;
+        stdinPollable = epoll_ctl(epollFd, EPOLL_CTL_ADD, STDIN_FILENO, &event) == 0;
+        c.watched = stdinPollable ? (uint32_t)EPOLLIN : 0u;
+    }
+
+    // Serve until stop(), SIGINT or SIGTERM; without a socket, until
+    // stdin ends and every answer is written
+    bool run(std::string& error) {
+        signal(SIGPIPE, SIG_IGN);
+        signalled();
+        wakeFdForSignals() = wakeFd;
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_handler = onSignal;
+        sigaction(SIGINT, &action, nullptr);
+        sigaction(SIGTERM, &action, nullptr);
+
+        epoll_event events[64];
+        while (!stopFlag.load() && !signalled().load()) {
+            if (listenFd < 0 && !stdinOpen && connections.empty()) break;
+            bool idleRead = stdinOpen && !stdinPollable && connections[STDIO].reading();
+            int ready = epoll_wait(epollFd, events, 64, idleRead ? 0 : -1);
+            if (ready < 0) {
+                if (errno == EINTR) continue;
+                error = std::string("epoll_wait: ") + std::strerror(errno);
+                return false;
+            }
+            for (int i = 0; i < ready; i++) {
+                uint64_t key = events[i].data.u64;
+                if (key == WAKE) {
+                    uint64_t count;
+                    if (read(wakeFd, &count, sizeof(count)) < 0) {
+                        // Nothing pending; the queue is drained below anyway
+                    }
+                } else if (key == LISTENER) {
+                    acceptClients();
+                } else if (key == STDOUT) {
+                    Connection& c = connections[STDIO];
+                    flush(c);
+                    splitMessages(STDIO, c);
+                    updateWatch(STDIO, c);
+                } else {
+                    std::unordered_map<uint64_t, Connection>::iterator it = connections.find(key);
+                    if (it == connections.end()) continue;
+                    if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) readFrom(key, it->second);
+                    if (events[i].events & EPOLLOUT) {
+                        flush(it->second);
+                        // Messages held back by the output cap can go out now
+                        splitMessages(key, it->second);
+                        updateWatch(key, it->second);
+                    }
+                }
+            }
+            if (idleRead) readFrom(STDIO, connections[STDIO]);
+            deliverAnswers();
+            closeFinished();
+        }
+        return true;
+    }
+
+    // Ask run() to return; safe from any thread
+    void stop() {
+        stopFlag.store(true);
+        uint64_t one = 1;
+        if (write(wakeFd, &one, sizeof(one)) < 0) {
+            // The counter is saturated, so run() wakes anyway
+        }
+    }
+
+    QueryServerStats stats() const { return counters; }
+
+private:
+    static const uint64_t WAKE = 0, LISTENER = 1, STDIO = 2, STDOUT = 3, FIRST_CONNECTION = 4;
+    static const size_t READ_CHUNK = 64 << 10;
+
+    struct Connection {
+        int fd, outFd;
+        std::string in, out;
+        size_t inStart, outStart;
+        size_t inFlight;
+        bool readClosed;
+        uint32_t watched; // epoll events registered
+
+        Connection() : fd(-1), outFd(-1), inStart(0), outStart(0), inFlight(0), readClosed(false), watched(0) {}
+
+        bool reading() const { return !readClosed && inFlight < MAX_IN_FLIGHT && !outputFull(); }
+        bool outputFull() const { return out.size() - outStart >= MAX_PENDING_OUTPUT; }
+        bool finished() const { return readClosed && inFlight == 0 && outStart == out.size(); }
+    };
+
+    struct Job {
+        uint64_t connection;
+        bool binary;
+        std::string message;
+    };
+
+    struct Answer {
+        uint64_t connection;
+        std::string bytes;
+    };
+
+    // Set by SIGINT/SIGTERM; stops every server in the process
+    static std::atomic<bool>& signalled() {
+        static std::atomic<bool> flag(false);
+        return flag;
+    }
+
+    static int& wakeFdForSignals() {
+        static int fd = -1;
+        return fd;
+    }
+
+    static void onSignal(int) {
+        signalled().store(true);
+        uint64_t one = 1;
+        if (write(wakeFdForSignals(), &one, sizeof(one)) < 0) {
+            // Nothing else is safe to do in a signal handler
+        }
+    }
+
+    void watch(int fd, uint64_t key, uint32_t events, int operation) {
+        epoll_event event;
+        event.events = events;
+        event.data.u64 = key;
+        epoll_ctl(epollFd, operation, fd, &event);
+    }
+
+    // Keep the registered events in line with what the connection needs
+    void updateWatch(uint64_t key, Connection& c) {
+        if (key == STDIO) {
+            // stdin and stdout are separate fds, so stdout gets its own key
+            bool pending = c.outStart < c.out.size();
+            if (pending && !stdoutWatched) {
+                epoll_event event;
+                event.events = EPOLLOUT;
+                event.data.u64 = STDOUT;
+                stdoutWatched = epoll_ctl(epollFd, EPOLL_CTL_ADD, STDOUT_FILENO, &event) == 0;
+            } else if (!pending && stdoutWatched) {
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, STDOUT_FILENO, nullptr);
+                stdoutWatched = false;
+            }
+            if (!stdinPollable || c.readClosed) return;
+            uint32_t wanted = c.reading() ? (uint32_t)EPOLLIN : 0u;
+            if (wanted != c.watched) watch(c.fd, key, wanted, EPOLL_CTL_MOD);
+            c.watched = wanted;
+            return;
+        }
+        uint32_t wanted = (c.reading() ? (uint32_t)EPOLLIN : 0u) | (c.outStart < c.out.size() ? (uint32_t)EPOLLOUT : 0u);
+        if (wanted != c.watched) watch(c.fd, key, wanted, EPOLL_CTL_MOD);
+        c.watched = wanted;
+    }
+
+    void acceptClients() {
+        while (true) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;
+            uint64_t key = nextConnection++;
+            Connection& c = connections[key];
+            c.fd = c.outFd = fd;
+            c.watched = EPOLLIN;
+            watch(fd, key, EPOLLIN, EPOLL_CTL_ADD);
+            counters.connections++;
+        }
+    }
+
+    // Read what is available and queue every complete message
+    void readFrom(uint64_t key, Connection& c) {
+        char buffer[READ_CHUNK];
+        while (c.reading()) {
+            ssize_t got = read(c.fd, buffer, sizeof(buffer));
+            if (got > 0) {
+                c.in.append(buffer, (size_t)got);
+                // Split before reading on, so a line without an end is caught
+                if ((size_t)got < sizeof(buffer) || c.in.size() - c.inStart > MAX_LINE_BYTES) break;
+                continue;
+            }
+            if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) closeInput(key, c);
+            break;
+        }
+        splitMessages(key, c);
+        updateWatch(key, c);
+    }
+
+    void closeInput(uint64_t key, Connection& c) {
+        c.readClosed = true;
+        if (key == STDIO) {
+            stdinOpen = false;
+            if (stdinPollable) epoll_ctl(epollFd, EPOLL_CTL_DEL, c.fd, nullptr);
+        }
+    }
+
+    void splitMessages(uint64_t key, Connection& c) {
+        std::vector<Job> jobs;
+        while (c.inStart < c.in.size() && c.inFlight + jobs.size() < MAX_IN_FLIGHT && !c.outputFull()) {
+            Job job;
+            job.connection = key;
+            job.binary = (uint8_t)c.in[c.inStart] == QUERY_FRAME_MAGIC;
+            if (job.binary) {
+                if (c.in.size() - c.inStart < sizeof(QueryFrame)) break;
+                job.message.assign(c.in, c.inStart, sizeof(QueryFrame));
+                c.inStart += sizeof(QueryFrame);
+            } else {
+                size_t end = c.in.find('\n', c.inStart);
+                if (end == std::string::npos ? c.in.size() - c.inStart > MAX_LINE_BYTES
+                                             : end - c.inStart > MAX_LINE_BYTES) {
+                    rejectLongLine(key, c);
+                    break;
+                }
+                if (end == std::string::npos) {
+                    if (!c.readClosed) break;
+                    end = c.in.size(); // last line without a newline
+                }
+                job.message.assign(c.in, c.inStart, end - c.inStart);
+                c.inStart = std::min(end + 1, c.in.size());
+                if (job.message.find_first_not_of(" \t\r") == std::string::npos) continue;
+            }
+            jobs.push_back(job);
+        }
+        if (c.inStart == c.in.size()) {
+            c.in.clear();
+            c.inStart = 0;
+        } else if (c.inStart > READ_CHUNK) {
+            c.in.erase(0, c.inStart);
+            c.inStart = 0;
+        }
+        if (jobs.empty()) return;
+
+        c.inFlight += jobs.size();
+        counters.requests += jobs.size();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t j = 0; j < jobs.size(); j++) pendingJobs.push_back(std::move(jobs[j]));
+        }
+        if (jobs.size() == 1) jobReady.notify_one();
+        else jobReady.notify_all();
+    }
+
+    // Answer an over-long line with its id, if it starts with one, and
+    // read nothing more from the connection
+    void rejectLongLine(uint64_t key, Connection& c) {
+        size_t begin = c.in.find_first_not_of(" \t\r", c.inStart);
+        size_t end = c.in.find_first_of(" \t\r\n", begin);
+        if (begin != std::string::npos && end != std::string::npos && end - begin <= 64) {
+            c.out.append(c.in, begin, end - begin);
+        } else {
+            c.out += '?';
+        }
+        c.out += " error line too long\n";
+        counters.requests++;
+        counters.responses++;
+        c.in.clear();
+        c.inStart = 0;
+        if (!c.readClosed) closeInput(key, c);
+        flush(c);
+    }
+
+    void workerLoop() {
+        QueryResponder responder(g, index);
+        Job job;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                jobReady.wait(lock, [this] { return stopping || !pendingJobs.empty(); });
+                if (stopping) return;
+                job = std::move(pendingJobs.front());
+                pendingJobs.pop_front();
+            }
+
+            Answer answer;
+            answer.connection = job.connection;
+            if (job.binary) {
+                QueryFrame frame;
+                std::memcpy(&frame, job.message.data(), sizeof(frame));
+                responder.answerFrame(frame, answer.bytes);
+            } else {
+                responder.answerLine(job.message.data(), job.message.size(), answer.bytes);
+            }
+
+            bool first;
+            {
+                std::lock_guard<std::mutex> lock(answerMutex);
+                first = answers.empty();
+                answers.push_back(std::move(answer));
+            }
+            // One wake-up per drain of the queue, not per answer
+            if (first) {
+                uint64_t one = 1;
+                if (write(wakeFd, &one, sizeof(one)) < 0) {
+                    // Counter saturated: the loop is awake already
+                }
+            }
+        }
+    }
+
+    void deliverAnswers() {
+        {
+            std::lock_guard<std::mutex> lock(answerMutex);
+            delivering.swap(answers);
+        }
+        for (size_t i = 0; i < delivering.size(); i++) {
+            std::unordered_map<uint64_t, Connection>::iterator it = connections.find(delivering[i].connection);
+            if (it == connections.end()) continue; // client went away
+            Connection& c = it->second;
+            c.out += delivering[i].bytes;
+            c.inFlight--;
+            counters.responses++;
+        }
+        for (size_t i = 0; i < delivering.size(); i++) {
+            std::unordered_map<uint64_t, Connection>::iterator it = connections.find(delivering[i].connection);
+            if (it == connections.end()) continue;
+            flush(it->second);
+            // Messages held back by the in-flight limit or the output cap
+            // can go out now
+            splitMessages(it->first, it->second);
+            updateWatch(it->first, it->second);
+        }
+        delivering.clear();
+    }
+
+    void flush(Connection& c) {
+        while (c.outStart < c.out.size()) {
+            ssize_t sent = c.fd == STDIN_FILENO
+                               ? write(c.outFd, c.out.data() + c.outStart, c.out.size() - c.outStart)
+                               : send(c.outFd, c.out.data() + c.outStart, c.out.size() - c.outStart, MSG_NOSIGNAL);
+            if (sent > 0) {
+                c.outStart += (size_t)sent;
+            } else if (sent < 0 && errno == EINTR) {
+                continue;
+            } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                // Peer gone: drop what is left and stop reading
+                c.outStart = c.out.size();
+                c.readClosed = true;
+            }
+        }
+        if (c.outStart == c.out.size()) {
+            c.out.clear();
+            c.outStart = 0;
+        }
+    }
+
+    void closeFinished() {
+        for (std::unordered_map<uint64_t, Connection>::iterator it = connections.begin(); it != connections.end();) {
+            Connection& c = it->second;
+            if (!c.finished()) {
+                ++it;
+                continue;
+            }
+            if (it->first != STDIO) {
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, c.fd, nullptr);
+                close(c.fd);
+            }
+            it = connections.erase(it);
+        }
+    }
+
+    const CsrGraph& g;
+    SpatialIndex index;
+    int epollFd, wakeFd, listenFd;
+    std::string socketPath;
+    std::unordered_map<uint64_t, Connection> connections;
+    uint64_t nextConnection;
+    QueryServerStats counters;
+
+    std::vector<std::thread> workers;
+    std::mutex mutex; // guards pendingJobs and stopping
+    std::condition_variable jobReady;
+    std::deque<Job> pendingJobs;
+    bool stopping;
+
+    std::mutex answerMutex; // guards answers
+    std::vector<Answer> answers, delivering;
+
+    std::atomic<bool> stopFlag;
+    bool stdinOpen, stdinPollable, stdoutWatched;
+    int stdinFlags; // stdin's file status flags before serveStdio, -1 if untouched
+};
+
+const size_t QueryServer::MAX_IN_FLIGHT;
+const size_t QueryServer::MAX_PENDING_OUTPUT;
+const size_t QueryServer::MAX_LINE_BYTES;
+const uint64_t QueryServer::WAKE;
+const uint64_t QueryServer::LISTENER;
+const uint64_t QueryServer::STDIO;
+const uint64_t QueryServer::STDOUT;
+const uint64_t QueryServer::FIRST_CONNECTION;
+const size_t QueryServer::READ_CHUNK;
+
+#endif
+
+#endif
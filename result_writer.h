@@ -0,0 +1,415 @@
+#ifndef RESULT_WRITER_H
+#define RESULT_WRITER_H
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "csr_graph.h"
+#include "search_context.h"
+#include "batch_query.h"
+
+// Reusable output buffer. Text is appended to one growing block that is
+// handed to the sink in a single write once it reaches blockBytes, or on
+// flush(), instead of one flushed stream write per line. Numbers are
+// formatted without going through the stream's locale and format state.
+// Not thread-safe; give each writer thread its own buffer.
+class OutputBuffer {
+public:
+    static const size_t DEFAULT_BLOCK_BYTES = 64 << 10;
+
+    explicit OutputBuffer(std::ostream& sink, size_t blockBytes = DEFAULT_BLOCK_BYTES)
+        : sink(&sink), blockBytes(blockBytes), flushes(0), written(0) {
+        buffer.reserve(blockBytes);
+    }
+
+    ~OutputBuffer() { flush(); }
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    void write(const char* data, size_t size) {
+        buffer.append(data, size);
+        if (buffer.size() >= blockBytes) flush();
+    }
+
+    OutputBuffer& operator<<(const std::string& text) {
+        write(text.data(), text.size());
+        return *this;
+    }
+
+    OutputBuffer& operator<<(const char* text) {
+        write(text, std::strlen(text));
+        return *this;
+    }
+
+    OutputBuffer& operator<<(char c) {
+        buffer.push_back(c);
+        if (buffer.size() >= blockBytes) flush();
+        return *this;
+    }
+
+    OutputBuffer& operator<<(int value) { return integer(value); }
+    OutputBuffer& operator<<(unsigned value) { return integer(value); }
+    OutputBuffer& operator<<(long value) { return integer(value); }
+    OutputBuffer& operator<<(unsigned long value) { return integer(value); }
+    OutputBuffer& operator<<(long long value) { return integer(value); }
+    OutputBuffer& operator<<(unsigned long long value) { return integer(value); }
+
+    // Six significant digits, as a default-formatted stream prints them
+    OutputBuffer& operator<<(double value) { return formatted("%g", value); }
+
+    // value with a fixed number of decimals
+    OutputBuffer& fixed(double value, int decimals) { return formatted("%.*f", decimals, value); }
+
+    // value right-aligned in width characters
+    OutputBuffer& padded(long long value, int width) { return formatted("%*lld", width, value); }
+
+    // Enough digits to read back as the same double
+    OutputBuffer& exact(double value) {
+        char text[32];
+        size_t length = exactDigits(value, text);
+        if (length == 0) return formatted("%.17g", value);
+        write(text, length);
+        return *this;
+    }
+
+    // Hand everything buffered to the sink in one write
+    void flush() {
+        if (buffer.empty()) return;
+        sink->write(buffer.data(), (std::streamsize)buffer.size());
+        sink->flush();
+        written += buffer.size();
+        flushes++;
+        buffer.clear();
+    }
+
+    // Flush and write to another stream from now on
+    void redirect(std::ostream& to) {
+        flush();
+        sink = &to;
+    }
+
+    size_t pending() const { return buffer.size(); }
+    uint64_t flushCount() const { return flushes; }
+    uint64_t bytesWritten() const { return written; }
+
+private:
+    template <class T>
+    OutputBuffer& integer(T value) {
+        char digits[24];
+        char* end = digits + sizeof(digits);
+        char* p = end;
+        bool negative = value < 0;
+        unsigned long long magnitude = negative ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+        do {
+            *--p = (char)('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude != 0);
+        if (negative) *--p = '-';
+        write(p, (size_t)(end - p));
+        return *this;
+    }
+
+    // 17 significant digits without snprintf, for values %.17g prints in
+    // fixed notation (1e-4 <= |value| < 1e17). The digits come from one
+    // multiply in extended precision. Its rounding error is far below half
+    // a unit of the last digit, so the text reads back as the same double,
+    // though a near tie may end one unit off from what %.17g prints.
+    // Returns 0 for anything else, which is left to snprintf.
+    static size_t exactDigits(double value, char* text) {
+#if LDBL_MANT_DIG >= 64
+        static const long double powers[] = {1e0L,  1e1L,  1e2L,  1e3L,  1e4L,  1e5L,  1e6L,  1e7L,
+                                             1e8L,  1e9L,  1e10L, 1e11L, 1e12L, 1e13L, 1e14L, 1e15L,
+                                             1e16L, 1e17L, 1e18L, 1e19L, 1e20L, 1e21L, 1e22L};
+        double magnitude = std::fabs(value);
+        if (!(magnitude >= 1e-4 && magnitude < 1e17)) return 0;
+        int exponent = (int)std::floor(std::log10(magnitude));
+        if (exponent < -4) exponent = -4; // log10 may round just below a power of ten
+        long double scaled = magnitude * powers[16 - exponent];
+        if (scaled < 1e16L && exponent > -4) scaled = magnitude * powers[16 - --exponent];
+        if (scaled >= 1e17L) return 0;
+        uint64_t digits = (uint64_t)(scaled + 0.5L);
+        if (digits < 10000000000000000ULL) return 0; // below 1e-4 after all
+        if (digits == 100000000000000000ULL) {
+            digits /= 10;
+            if (++exponent >= 17) return 0;
+        }
+
+        char figures[17];
+        for (int i = 16; i >= 0; i--) {
+            figures[i] = (char)('0' + digits % 10);
+            digits /= 10;
+        }
+        int last = 16; // last significant figure
+        while (last > 0 && figures[last] == '0') last--;
+
+        char* p = text;
+        if (value < 0) *p++ = '-';
+        if (exponent >= 0) {
+            for (int i = 0; i <= exponent; i++) *p++ = figures[i];
+            if (last > exponent) {
+                *p++ = '.';
+                for (int i = exponent + 1; i <= last; i++) *p++ = figures[i];
+            }
+        } else {
+            *p++ = '0';
+            *p++ = '.';
+            for (int i = exponent; i < -1; i++) *p++ = '0';
+            for (int i = 0; i <= last; i++) *p++ = figures[i];
+        }
+        return (size_t)(p - text);
+#else
+        (void)value;
+        (void)text;
+        return 0;
+#endif
+    }
+
+    template <class... Args>
+    OutputBuffer& formatted(const char* format, Args... args) {
+        char text[64];
+        int length = std::snprintf(text, sizeof(text), format, args...);
+        if (length >= (int)sizeof(text)) {
+            std::vector<char> large((size_t)length + 1);
+            std::snprintf(large.data(), large.size(), format, args...);
+            write(large.data(), (size_t)length);
+        } else if (length > 0) {
+            write(text, (size_t)length);
+        }
+        return *this;
+    }
+
+    std::ostream* sink;
+    size_t blockBytes;
+    std::string buffer;
+    uint64_t flushes;
+    uint64_t written;
+};
+
+const size_t OutputBuffer::DEFAULT_BLOCK_BYTES;
+
+// How ResultWriter lays results out
+enum ResultFormat {
+    RESULT_TEXT,   // the interactive program's human-readable lines
+    RESULT_NDJSON, // one JSON object per line
+    RESULT_BINARY  // fixed-size records, see below
+};
+
+// "text", "ndjson" or "binary"
+inline bool parseResultFormat(const std::string& name, ResultFormat& format) {
+    if (name == "text") format = RESULT_TEXT;
+    else if (name == "ndjson") format = RESULT_NDJSON;
+    else if (name == "binary") format = RESULT_BINARY;
+    else return false;
+    return true;
+}
+
+// Binary records, in host byte order. A path record is followed by count
+// node ids and then count doubles, the cost of reaching each of them.
+// A stats record stands alone.
+const uint8_t RESULT_PATH_RECORD = 'P';
+const uint8_t RESULT_STATS_RECORD = 'S';
+
+struct PathRecordHeader {
+    uint8_t tag; // RESULT_PATH_RECORD
+    uint8_t reserved[3];
+    uint32_t count; // nodes on the path, 0 if there is none
+    uint64_t id;
+    NodeId from, to;
+    double cost; // infinity if there is no path
+};
+
+struct StatsRecord {
+    uint8_t tag; // RESULT_STATS_RECORD
+    uint8_t reserved[3];
+    uint32_t threads;
+    uint64_t queries;
+    double seconds, queriesPerSecond;
+    double p50Micros, p90Micros, p99Micros, maxMicros;
+};
+
+static_assert(sizeof(PathRecordHeader) == 32, "PathRecordHeader layout");
+static_assert(sizeof(StatsRecord) == 64, "StatsRecord layout");
+
+// Serializes path results and batch summaries into an OutputBuffer in one
+// of the ResultFormats. Per-hop weights come from costs, the cost of
+// reaching each path node as the search recorded it (see
+// SearchContext::buildPathCosts and PathResult::costs), so nothing is
+// looked up in the graph again.
+class ResultWriter {
+public:
+    explicit ResultWriter(OutputBuffer& out, ResultFormat format = RESULT_TEXT) : out(out), resultFormat(format) {}
+
+    ResultFormat format() const { return resultFormat; }
+
+    // One path answer; an empty path means none was found. Without costs
+    // (empty) text leaves the weights out, NDJSON writes an empty costs
+    // array and binary NaNs.
+    void writePath(const CsrGraph& g, uint64_t id, NodeId from, NodeId to, double cost,
+                   const std::vector<NodeId>& path, const std::vector<double>& costs) {
+        bool withCosts = costs.size() == path.size();
+        if (resultFormat == RESULT_BINARY) {
+            PathRecordHeader header;
+            std::memset(&header, 0, sizeof(header));
+            header.tag = RESULT_PATH_RECORD;
+            header.count = (uint32_t)path.size();
+            header.id = id;
+            header.from = from;
+            header.to = to;
+            header.cost = path.empty() ? INFINITE_COST : cost;
+            out.write((const char*)&header, sizeof(header));
+            out.write((const char*)path.data(), path.size() * sizeof(NodeId));
+            if (withCosts) {
+                out.write((const char*)costs.data(), costs.size() * sizeof(double));
+            } else {
+                double unknown = std::nan("");
+                for (size_t i = 0; i < path.size(); i++) out.write((const char*)&unknown, sizeof(unknown));
+            }
+            return;
+        }
+
+        if (resultFormat == RESULT_NDJSON) {
+            out << "{\"type\":\"path\",\"id\":" << (unsigned long long)id << ",\"from\":";
+            name(g, from);
+            out << ",\"to\":";
+            name(g, to);
+            out << ",\"cost\":";
+            number(path.empty() ? INFINITE_COST : cost);
+            out << ",\"path\":[";
+            for (size_t i = 0; i < path.size(); i++) {
+                if (i > 0) out << ',';
+                name(g, path[i]);
+            }
+            out << "],\"costs\":[";
+            for (size_t i = 0; withCosts && i < costs.size(); i++) {
+                if (i > 0) out << ',';
+                number(costs[i]);
+            }
+            out << "]}\n";
+            return;
+        }
+
+        out << "Finding shortest path from ";
+        text(g, from);
+        out << " to ";
+        text(g, to);
+        out << '\n';
+        if (path.empty()) {
+            out << "No path found!\n";
+            return;
+        }
+        out << "Path found: ";
+        for (size_t i = 0; i < path.size(); i++) {
+            text(g, path[i]);
+            if (i + 1 < path.size()) {
+                if (withCosts) out << " -(" << costs[i + 1] - costs[i] << ")-> ";
+                else out << " -> ";
+            }
+        }
+        out << "\nTotal path cost: ";
+        out.fixed(cost, 2);
+        out << "\nNumber of nodes in path: " << (unsigned long long)path.size() << '\n';
+    }
+
+    // Throughput and latency summary of a batch
+    void writeStats(const BatchReport& report) {
+        if (resultFormat == RESULT_BINARY) {
+            StatsRecord record;
+            std::memset(&record, 0, sizeof(record));
+            record.tag = RESULT_STATS_RECORD;
+            record.threads = report.threads;
+            record.queries = report.queries;
+            record.seconds = report.seconds;
+            record.queriesPerSecond = report.queriesPerSecond;
+            record.p50Micros = report.p50Micros;
+            record.p90Micros = report.p90Micros;
+            record.p99Micros = report.p99Micros;
+            record.maxMicros = report.maxMicros;
+            out.write((const char*)&record, sizeof(record));
+            return;
+        }
+
+        if (resultFormat == RESULT_NDJSON) {
+            out << "{\"type\":\"stats\",\"queries\":" << (unsigned long long)report.queries
+                << ",\"threads\":" << report.threads << ",\"seconds\":";
+            number(report.seconds);
+            out << ",\"queries_per_second\":";
+            number(report.queriesPerSecond);
+            out << ",\"p50_us\":";
+            number(report.p50Micros);
+            out << ",\"p90_us\":";
+            number(report.p90Micros);
+            out << ",\"p99_us\":";
+            number(report.p99Micros);
+            out << ",\"max_us\":";
+            number(report.maxMicros);
+            out << "}\n";
+            return;
+        }
+
+        out << (unsigned long long)report.queries << " queries on " << report.threads << " threads in ";
+        out.fixed(report.seconds, 3);
+        out << " s (";
+        out.fixed(report.queriesPerSecond, 0);
+        out << " queries/s), latency p50 ";
+        out.fixed(report.p50Micros, 1);
+        out << " us, p90 ";
+        out.fixed(report.p90Micros, 1);
+        out << " us, p99 ";
+        out.fixed(report.p99Micros, 1);
+        out << " us, max ";
+        out.fixed(report.maxMicros, 1);
+        out << " us\n";
+    }
+
+private:
+    // A node's name as is, "?" for an unknown id
+    void text(const CsrGraph& g, NodeId u) {
+        if (u < g.numNodes()) out.write(g.nameData(u), g.nameLength(u));
+        else out << '?';
+    }
+
+    // JSON string of a node's name
+    void name(const CsrGraph& g, NodeId u) {
+        if (u >= g.numNodes()) {
+            out << "null";
+            return;
+        }
+        const char* text = g.nameData(u);
+        size_t length = g.nameLength(u);
+        out << '"';
+        size_t run = 0; // characters that need no escaping, written together
+        for (size_t i = 0; i < length; i++) {
+            unsigned char c = (unsigned char)text[i];
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+            out.write(text + run, i - run);
+            run = i + 1;
+            if (c == '"' || c == '\\') {
+                out << '\\' << (char)c;
+            } else {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out << escaped;
+            }
+        }
+        out.write(text + run, length - run);
+        out << '"';
+    }
+
+    // JSON has no infinity: unreachable costs are null
+    void number(double value) {
+        if (std::isfinite(value)) out.exact(value);
+        else out << "null";
+    }
+
+    OutputBuffer& out;
+    ResultFormat resultFormat;
+};
+
+#endif
@@ -1,6 +1,6 @@
 @echo off
 echo Compiling Graph A* Program with Visualization...
-g++ -std=c++11 -Wall -Wextra -O2 -o graph_astar.exe main.cpp
+g++ -std=c++11 -Wall -Wextra -O2 -pthread -o graph_astar.exe main.cpp
 
 if %errorlevel% equ 0 (
     echo Compilation successful!
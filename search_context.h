@@ -0,0 +1,141 @@
+#ifndef SEARCH_CONTEXT_H
+#define SEARCH_CONTEXT_H
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <algorithm>
+
+#include "csr_graph.h"
+#include "open_list.h"
+
+const double INFINITE_COST = std::numeric_limits<double>::infinity();
+
+// Reusable scratch memory for one search at a time.
+// Per-node arrays are indexed by node id and stamped with a generation
+// number: a node whose stamp differs from the current generation is
+// treated as untouched, so reset() is O(1) instead of O(V).
+// Once the arrays have grown to the graph size, queries allocate nothing;
+// allocationCount() counts every buffer growth so callers can check that.
+class SearchContext {
+public:
+    enum NodeState : uint8_t {
+        UNSEEN = 0,
+        OPEN = 1,
+        CLOSED = 2
+    };
+
+    SearchContext() : generation(0), allocations(0), expansions(0) {}
+
+    // Start a new search over a graph with numNodes nodes
+    void reset(NodeId numNodes) {
+        if (stamp.size() < numNodes) {
+            stamp.resize(numNodes, 0);
+            gScore.resize(numNodes);
+            parent.resize(numNodes);
+            state.resize(numNodes);
+            allocations++;
+        }
+        generation++;
+        if (generation == 0) {
+            // Stamp counter wrapped around, clear once and start over
+            std::fill(stamp.begin(), stamp.end(), 0);
+            generation = 1;
+        }
+        pathBuffer.clear();
+        expansions = 0;
+    }
+
+    bool touched(NodeId u) const { return stamp[u] == generation; }
+
+    double g(NodeId u) const { return touched(u) ? gScore[u] : INFINITE_COST; }
+    NodeId parentOf(NodeId u) const { return touched(u) ? parent[u] : INVALID_NODE; }
+    NodeState stateOf(NodeId u) const { return touched(u) ? (NodeState)state[u] : UNSEEN; }
+
+    // Record a new best cost for u reached through from
+    void setG(NodeId u, double cost, NodeId from) {
+        if (!touched(u)) {
+            stamp[u] = generation;
+            state[u] = UNSEEN;
+        }
+        gScore[u] = cost;
+        parent[u] = from;
+    }
+
+    void setState(NodeId u, NodeState s) { state[u] = s; }
+
+    // Open lists are kept here so their buffers are reused between queries
+    LazyBinaryHeap binaryHeap;
+    IndexedDaryHeap<4> quaternaryHeap;
+    RadixHeap radixHeap;
+
+    // Walk parent pointers back from goal into the reused path buffer
+    const std::vector<NodeId>& buildPath(NodeId goal) {
+        pathBuffer.clear();
+        for (NodeId v = goal; v != INVALID_NODE; v = parent[v]) {
+            if (pathBuffer.size() == pathBuffer.capacity()) allocations++;
+            pathBuffer.push_back(v);
+        }
+        std::reverse(pathBuffer.begin(), pathBuffer.end());
+        return pathBuffer;
+    }
+
+    const std::vector<NodeId>& path() const { return pathBuffer; }
+
+    // Cost of reaching each node of the last built path, as the search
+    // recorded it; hop i weighs costs[i + 1] - costs[i]
+    const std::vector<double>& buildPathCosts() {
+        pathCostBuffer.clear();
+        for (size_t i = 0; i < pathBuffer.size(); i++) {
+            if (pathCostBuffer.size() == pathCostBuffer.capacity()) allocations++;
+            pathCostBuffer.push_back(gScore[pathBuffer[i]]);
+        }
+        return pathCostBuffer;
+    }
+
+    // Room for the neighbors improved by one expansion (at most degree of
+    // them) and, in batchEstimates(), their heuristic values
+    NodeId* batchNodes(size_t degree) {
+        if (batchNodeBuffer.size() < degree) {
+            batchNodeBuffer.resize(degree);
+            batchEstimateBuffer.resize(degree);
+            allocations++;
+        }
+        return batchNodeBuffer.data();
+    }
+
+    double* batchEstimates() { return batchEstimateBuffer.data(); }
+
+    // Nodes expanded by the current (or last) search
+    void countExpansion() { expansions++; }
+    uint64_t expandedCount() const { return expansions; }
+
+    // Number of times any scratch buffer had to grow
+    uint64_t allocationCount() const {
+        return allocations + binaryHeap.allocationCount() +
+               quaternaryHeap.allocationCount() + radixHeap.allocationCount();
+    }
+
+    // Bytes held by the scratch buffers, open lists included
+    size_t memoryBytes() const {
+        return stamp.capacity() * sizeof(uint32_t) + gScore.capacity() * sizeof(double) +
+               parent.capacity() * sizeof(NodeId) + state.capacity() + pathBuffer.capacity() * sizeof(NodeId) +
+               pathCostBuffer.capacity() * sizeof(double) + batchNodeBuffer.capacity() * sizeof(NodeId) + batchEstimateBuffer.capacity() * sizeof(double) +
+               binaryHeap.memoryBytes() + quaternaryHeap.memoryBytes() + radixHeap.memoryBytes();
+    }
+
+private:
+    std::vector<uint32_t> stamp;
+    std::vector<double> gScore;
+    std::vector<NodeId> parent;
+    std::vector<uint8_t> state;
+    std::vector<NodeId> pathBuffer;
+    std::vector<double> pathCostBuffer;
+    std::vector<NodeId> batchNodeBuffer;
+    std::vector<double> batchEstimateBuffer;
+    uint32_t generation;
+    uint64_t allocations;
+    uint64_t expansions;
+};
+
+#endif
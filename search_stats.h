@@ -0,0 +1,145 @@
+#ifndef SEARCH_STATS_H
+#define SEARCH_STATS_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <algorithm>
+
+// Work done by one or more searches. Filled through a stats policy (see
+// below) so that searches without one compile to the same code as before.
+struct SearchStats {
+    uint64_t searches;
+    uint64_t pushed;               // open-list pushes, including decrease-keys
+    uint64_t popped;               // open-list pops, stale ones included
+    uint64_t stalePops;            // pops of nodes that were no longer open
+    uint64_t relaxations;          // edges scanned from expanded nodes
+    uint64_t heuristicEvaluations;
+    uint64_t maxOpenSize;          // largest open list of any search
+    uint64_t bytesAllocated;       // growth of the scratch buffers
+    double setupMicros;            // resetting the context and open list
+    double searchMicros;           // the main loop
+    double pathMicros;             // walking parents back into a path
+
+    SearchStats() { clear(); }
+
+    void clear() {
+        searches = pushed = popped = stalePops = relaxations = heuristicEvaluations = 0;
+        maxOpenSize = bytesAllocated = 0;
+        setupMicros = searchMicros = pathMicros = 0;
+    }
+
+    // Fold another set of counters into this one, e.g. per-thread stats of a batch
+    void add(const SearchStats& other) {
+        searches += other.searches;
+        pushed += other.pushed;
+        popped += other.popped;
+        stalePops += other.stalePops;
+        relaxations += other.relaxations;
+        heuristicEvaluations += other.heuristicEvaluations;
+        maxOpenSize = std::max(maxOpenSize, other.maxOpenSize);
+        bytesAllocated += other.bytesAllocated;
+        setupMicros += other.setupMicros;
+        searchMicros += other.searchMicros;
+        pathMicros += other.pathMicros;
+    }
+
+    std::string toJson() const {
+        std::ostringstream out;
+        out << "{\"searches\": " << searches << ", \"pushed\": " << pushed << ", \"popped\": " << popped
+            << ", \"stale_pops\": " << stalePops << ", \"relaxations\": " << relaxations
+            << ", \"heuristic_evaluations\": " << heuristicEvaluations << ", \"max_open_size\": " << maxOpenSize
+            << ", \"bytes_allocated\": " << bytesAllocated << std::fixed << std::setprecision(1)
+            << ", \"phase_micros\": {\"setup\": " << setupMicros
+            << ", \"search\": " << searchMicros << ", \"path\": " << pathMicros << "}}";
+        return out.str();
+    }
+
+    // Prometheus text exposition format; counters end in _total
+    std::string toPrometheus(const std::string& prefix = "astar") const {
+        std::ostringstream out;
+        counter(out, prefix + "_searches_total", "Searches run", searches);
+        counter(out, prefix + "_pushed_total", "Open-list pushes", pushed);
+        counter(out, prefix + "_popped_total", "Open-list pops", popped);
+        counter(out, prefix + "_stale_pops_total", "Pops of nodes no longer open", stalePops);
+        counter(out, prefix + "_relaxations_total", "Edges scanned", relaxations);
+        counter(out, prefix + "_heuristic_evaluations_total", "Heuristic evaluations", heuristicEvaluations);
+        counter(out, prefix + "_allocated_bytes_total", "Scratch buffer growth in bytes", bytesAllocated);
+        out << "# HELP " << prefix << "_max_open_size Largest open list of any search\n"
+            << "# TYPE " << prefix << "_max_open_size gauge\n"
+            << prefix << "_max_open_size " << maxOpenSize << "\n";
+        out << std::fixed << std::setprecision(6);
+        out << "# HELP " << prefix << "_phase_seconds_total Wall time by search phase\n"
+            << "# TYPE " << prefix << "_phase_seconds_total counter\n"
+            << prefix << "_phase_seconds_total{phase=\"setup\"} " << setupMicros / 1e6 << "\n"
+            << prefix << "_phase_seconds_total{phase=\"search\"} " << searchMicros / 1e6 << "\n"
+            << prefix << "_phase_seconds_total{phase=\"path\"} " << pathMicros / 1e6 << "\n";
+        return out.str();
+    }
+
+private:
+    static void counter(std::ostringstream& out, const std::string& name, const char* help, uint64_t value) {
+        out << "# HELP " << name << " " << help << "\n# TYPE " << name << " counter\n" << name << " " << value << "\n";
+    }
+};
+
+// Stats policies for the search templates. The search calls the hooks
+// unconditionally; with NoSearchStats they are empty inline functions and
+// vanish, so the hot path pays nothing when collection is off.
+struct NoSearchStats {
+    void beginSearch(size_t) {}
+    void endSetup() {}
+    void endSearch(size_t) {}
+    void push(size_t) {}
+    void pop() {}
+    void stalePop() {}
+    void relax() {}
+    void heuristic() {}
+};
+
+// Records into a SearchStats. bytes are the scratch memory sizes passed
+// to beginSearch/endSearch, whose difference is counted as allocated.
+class CollectSearchStats {
+public:
+    explicit CollectSearchStats(SearchStats& target) : stats(target), bytesBefore(0) {}
+
+    void beginSearch(size_t bytes) {
+        stats.searches++;
+        bytesBefore = bytes;
+        phaseStart = std::chrono::steady_clock::now();
+    }
+
+    void endSetup() { stats.setupMicros += lap(); }
+
+    void endSearch(size_t bytes) {
+        stats.searchMicros += lap();
+        if (bytes > bytesBefore) stats.bytesAllocated += bytes - bytesBefore;
+    }
+
+    void push(size_t openSize) {
+        stats.pushed++;
+        if (openSize > stats.maxOpenSize) stats.maxOpenSize = openSize;
+    }
+
+    void pop() { stats.popped++; }
+    void stalePop() { stats.stalePops++; }
+    void relax() { stats.relaxations++; }
+    void heuristic() { stats.heuristicEvaluations++; }
+
+private:
+    double lap() {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double micros = std::chrono::duration<double, std::micro>(now - phaseStart).count();
+        phaseStart = now;
+        return micros;
+    }
+
+    SearchStats& stats;
+    size_t bytesBefore;
+    std::chrono::steady_clock::time_point phaseStart;
+};
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+#include "parallel.h"
+
+// Static k-d tree over the node coordinates, for snapping raw (x, y)
+// positions to nodes. The tree is implicit in one flat array: the range
+// [lo, hi) is split at mid = (lo + hi) / 2, whose point is the median of
+// the range along x at even depths and y at odd depths, with smaller
+// points in [lo, mid) and larger ones in (mid, hi). Nothing but the
+// points is stored.
+class SpatialIndex {
+public:
+    SpatialIndex() : minX(0), minY(0), maxX(0), maxY(0) {}
+
+    bool empty() const { return points.empty(); }
+    size_t size() const { return points.size(); }
+
+    // Index every node of g; each tree level is partitioned in parallel
+    void build(const CsrGraph& g, unsigned threads = 0) {
+        points.resize(g.numNodes());
+        for (NodeId u = 0; u < g.numNodes(); u++) {
+            Point p = {g.x(u), g.y(u), u};
+            points[u] = p;
+        }
+        minX = minY = std::numeric_limits<double>::infinity();
+        maxX = maxY = -std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i < points.size(); i++) {
+            minX = std::min(minX, points[i].x);
+            minY = std::min(minY, points[i].y);
+            maxX = std::max(maxX, points[i].x);
+            maxY = std::max(maxY, points[i].y);
+        }
+
+        std::vector<std::pair<size_t, size_t> > level(1, std::make_pair((size_t)0, points.size())), next;
+        for (int depth = 0; !level.empty(); depth++) {
+            parallelFor(level.size(), threads, [&](size_t i, unsigned) {
+                size_t lo = level[i].first, hi = level[i].second, mid = lo + (hi - lo) / 2;
+                std::nth_element(points.begin() + lo, points.begin() + mid, points.begin() + hi,
+                                 depth % 2 == 0 ? lessX : lessY);
+            }, 16);
+            next.clear();
+            for (size_t i = 0; i < level.size(); i++) {
+                size_t lo = level[i].first, hi = level[i].second, mid = lo + (hi - lo) / 2;
+                if (mid - lo > 1) next.push_back(std::make_pair(lo, mid));
+                if (hi - mid > 2) next.push_back(std::make_pair(mid + 1, hi));
+            }
+            level.swap(next);
+        }
+    }
+
+    // Bounding box of all nodes; false if the index is empty
+    bool bounds(double& outMinX, double& outMinY, double& outMaxX, double& outMaxY) const {
+        if (empty()) return false;
+        outMinX = minX;
+        outMinY = minY;
+        outMaxX = maxX;
+        outMaxY = maxY;
+        return true;
+    }
+
+    // Closest node to (x, y), INVALID_NODE if the index is empty
+    NodeId nearest(double x, double y) const {
+        Best best = {std::numeric_limits<double>::infinity(), INVALID_NODE};
+        nearestIn(0, points.size(), 0, x, y, best);
+        return best.id;
+    }
+
+    // Up to k closest nodes, nearest first
+    void nearest(double x, double y, size_t k, std::vector<NodeId>& out) const {
+        out.clear();
+        if (k == 0) return;
+        std::vector<std::pair<double, NodeId> > heap; // max-heap on distance, at most k entries
+        heap.reserve(k + 1);
+        nearestK(0, points.size(), 0, x, y, k, heap);
+        std::sort_heap(heap.begin(), heap.end());
+        for (size_t i = 0; i < heap.size(); i++) out.push_back(heap[i].second);
+    }
+
+    // Nodes inside [boxMinX, boxMaxX] x [boxMinY, boxMaxY], in no particular order
+    void withinBox(double boxMinX, double boxMinY, double boxMaxX, double boxMaxY, std::vector<NodeId>& out) const {
+        out.clear();
+        boxIn(0, points.size(), 0, boxMinX, boxMinY, boxMaxX, boxMaxY, out);
+    }
+
+    size_t memoryBytes() const { return points.capacity() * sizeof(Point); }
+
+private:
+    struct Point {
+        double x, y;
+        NodeId id;
+    };
+
+    struct Best {
+        double distance2;
+        NodeId id;
+    };
+
+    static bool lessX(const Point& a, const Point& b) { return a.x < b.x; }
+    static bool lessY(const Point& a, const Point& b) { return a.y < b.y; }
+
+    static double distance2(const Point& p, double x, double y) {
+        double dx = p.x - x, dy = p.y - y;
+        return dx * dx + dy * dy;
+    }
+
+    // Offset of (x, y) from the splitting line of the point at mid
+    static double splitOffset(const Point& p, int depth, double x, double y) {
+        return depth % 2 == 0 ? x - p.x : y - p.y;
+    }
+
+    void nearestIn(size_t lo, size_t hi, int depth, double x, double y, Best& best) const {
+        if (lo >= hi) return;
+        size_t mid = lo + (hi - lo) / 2;
+        const Point& p = points[mid];
+        double d2 = distance2(p, x, y);
+        if (d2 < best.distance2) {
+            best.distance2 = d2;
+            best.id = p.id;
+        }
+        double offset = splitOffset(p, depth, x, y);
+        // Near side first; the far side only if the splitting line is closer than the best
+        if (offset < 0) {
+            nearestIn(lo, mid, depth + 1, x, y, best);
+            if (offset * offset < best.distance2) nearestIn(mid + 1, hi, depth + 1, x, y, best);
+        } else {
+            nearestIn(mid + 1, hi, depth + 1, x, y, best);
+            if (offset * offset < best.distance2) nearestIn(lo, mid, depth + 1, x, y, best);
+        }
+    }
+
+    void nearestK(size_t lo, size_t hi, int depth, double x, double y, size_t k,
+                  std::vector<std::pair<double, NodeId> >& heap) const {
+        if (lo >= hi) return;
+        size_t mid = lo + (hi - lo) / 2;
+        const Point& p = points[mid];
+        double d2 = distance2(p, x, y);
+        if (heap.size() < k || d2 < heap.front().first) {
+            heap.push_back(std::make_pair(d2, p.id));
+            std::push_heap(heap.begin(), heap.end());
+            if (heap.size() > k) {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.pop_back();
+            }
+        }
+        double offset = splitOffset(p, depth, x, y);
+        size_t nearLo = offset < 0 ? lo : mid + 1, nearHi = offset < 0 ? mid : hi;
+        size_t farLo = offset < 0 ? mid + 1 : lo, farHi = offset < 0 ? hi : mid;
+        nearestK(nearLo, nearHi, depth + 1, x, y, k, heap);
+        if (heap.size() < k || offset * offset < heap.front().first) {
+            nearestK(farLo, farHi, depth + 1, x, y, k, heap);
+        }
+    }
+
+    void boxIn(size_t lo, size_t hi, int depth, double bx0, double by0, double bx1, double by1,
+               std::vector<NodeId>& out) const {
+        if (lo >= hi) return;
+        size_t mid = lo + (hi - lo) / 2;
+        const Point& p = points[mid];
+        if (p.x >= bx0 && p.x <= bx1 && p.y >= by0 && p.y <= by1) out.push_back(p.id);
+        double split = depth % 2 == 0 ? p.x : p.y;
+        double boxLow = depth % 2 == 0 ? bx0 : by0, boxHigh = depth % 2 == 0 ? bx1 : by1;
+        if (boxLow <= split) boxIn(lo, mid, depth + 1, bx0, by0, bx1, by1, out);
+        if (boxHigh >= split) boxIn(mid + 1, hi, depth + 1, bx0, by0, bx1, by1, out);
+    }
+
+    std::vector<Point> points; // in implicit tree order
+    double minX, minY, maxX, maxY;
+};
+
+#endif